@@ -0,0 +1,91 @@
+// NOTE: ArrayList growth, the original mutex + new T[] list against the
+// current one. Postings are built the way indexing builds them: many short
+// lists and a few long ones of 16-byte FileFrequency records, then a run of
+// std::string tokens.
+//
+// Usage: bench_array_list [postings] (default 20M)
+
+#include "array_list.hpp"
+#include "indexer.h"
+#include "legacy_array_list.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// INFO: Zipf-like list lengths, so most terms have a handful of postings
+static std::vector<size_t> list_lengths(size_t total) {
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<double> u(0.0, 1.0);
+  std::vector<size_t> lengths;
+  for (size_t used = 0; used < total;) {
+    size_t length = static_cast<size_t>(std::pow(100000.0, u(rng) * u(rng)));
+    length = std::min(length, total - used);
+    lengths.push_back(length);
+    used += length;
+  }
+  return lengths;
+}
+
+template <typename List>
+static double build_postings(const std::vector<size_t> &lengths) {
+  auto start = std::chrono::steady_clock::now();
+  uint64_t checksum = 0;
+  for (size_t length : lengths) {
+    auto list = std::make_unique<List>();
+    for (size_t i = 0; i < length; i++) {
+      list->push_back(FileFrequency{static_cast<uint32_t>(i), 1, 0.5});
+    }
+    checksum += (*list)[length - 1].doc;
+  }
+  double seconds = seconds_since(start);
+  if (checksum == 0) {
+    std::cout << "unreachable" << std::endl; // NOTE: Keeps the lists alive
+  }
+  return seconds;
+}
+
+template <typename List> static double build_tokens(size_t n) {
+  std::string token = "watson";
+  auto start = std::chrono::steady_clock::now();
+  auto list = std::make_unique<List>();
+  for (size_t i = 0; i < n; i++) {
+    list->push_back(token);
+  }
+  double seconds = seconds_since(start);
+  if (list->size() != n) {
+    std::cout << "unreachable" << std::endl;
+  }
+  return seconds;
+}
+
+int main(int argc, char *argv[]) {
+  size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000000;
+  std::vector<size_t> lengths = list_lengths(n);
+  double count = static_cast<double>(n);
+
+  double legacy = build_postings<LegacyArrayList<FileFrequency>>(lengths);
+  double current = build_postings<ArrayList<FileFrequency>>(lengths);
+  std::cout << "postings (" << lengths.size() << " lists): legacy "
+            << legacy / count * 1e9 << " ns, ArrayList "
+            << current / count * 1e9 << " ns per push_back" << std::endl;
+
+  legacy = build_tokens<LegacyArrayList<std::string>>(n / 4);
+  current = build_tokens<ArrayList<std::string>>(n / 4);
+  std::cout << "strings: legacy " << legacy / (count / 4) * 1e9
+            << " ns, ArrayList " << current / (count / 4) * 1e9
+            << " ns per push_back" << std::endl;
+  return 0;
+}
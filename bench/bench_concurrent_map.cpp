@@ -0,0 +1,111 @@
+// NOTE: Contention benchmark, 1 to 16 threads at 0%, 10%, 50% and 100%
+// writes. Compares one HashMap behind a single reader/writer lock against
+// ConcurrentHashMap's per-shard locks. Each thread runs a fixed number of
+// random lookups and inserts over a shared, pre-filled key set.
+//
+// Usage: bench_concurrent_map [keys] [ops per thread]
+
+#include "concurrent_hashmap.hpp"
+#include "hashmap.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// INFO: The baseline, one lock around the whole map
+class GlobalLockMap {
+private:
+  mutable std::shared_mutex mutex;
+  mutable HashMap<std::string, int> map; // INFO: HashMap::find is not const
+
+public:
+  void insert(const std::string &key, int value) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    map.insert_or_assign(key, value);
+  }
+
+  bool find(const std::string &key, int &out) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto it = map.find(key);
+    if (it == map.end()) {
+      return false;
+    }
+    out = it->value;
+    return true;
+  }
+};
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// INFO: Million operations per second across all threads
+template <typename Map>
+static double run(Map &map, const std::vector<std::string> &keys,
+                  int num_threads, int write_percent, size_t ops) {
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      std::mt19937 rng(t);
+      std::uniform_int_distribution<size_t> pick(0, keys.size() - 1);
+      std::uniform_int_distribution<int> percent(0, 99);
+      size_t found = 0;
+      for (size_t i = 0; i < ops; i++) {
+        const std::string &key = keys[pick(rng)];
+        if (percent(rng) < write_percent) {
+          map.insert(key, static_cast<int>(i));
+        } else {
+          int value;
+          found += map.find(key, value);
+        }
+      }
+      if (found > ops) {
+        std::cout << "unreachable" << std::endl; // NOTE: Keeps found alive
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  return num_threads * ops / seconds_since(start) / 1e6;
+}
+
+int main(int argc, char *argv[]) {
+  size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+  size_t ops = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 200000;
+
+  std::vector<std::string> keys;
+  keys.reserve(n);
+  for (size_t i = 0; i < n; i++) {
+    keys.push_back("term" + std::to_string(i));
+  }
+
+  std::cout << "threads  writes  global-lock(Mops/s)  sharded(Mops/s)  speedup"
+            << std::endl;
+  for (int num_threads = 1; num_threads <= 16; num_threads *= 2) {
+    for (int write_percent : {0, 10, 50, 100}) {
+      GlobalLockMap global;
+      ConcurrentHashMap<std::string, int> sharded;
+      for (size_t i = 0; i < n; i++) {
+        global.insert(keys[i], static_cast<int>(i));
+        sharded.insert(keys[i], static_cast<int>(i));
+      }
+
+      double locked = run(global, keys, num_threads, write_percent, ops);
+      double striped = run(sharded, keys, num_threads, write_percent, ops);
+      std::cout << num_threads << "\t " << write_percent << "%\t "
+                << locked << "\t\t      " << striped << "\t       "
+                << striped / locked << "x" << std::endl;
+    }
+  }
+  return 0;
+}
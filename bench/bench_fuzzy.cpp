@@ -0,0 +1,158 @@
+// NOTE: Typo tolerant lookups on the mapped autocomplete trie. Vocabulary
+// words are given 1 or 2 random edits (substitution, insertion or deletion)
+// and looked up with FlatTrie::fuzzy_find (whole word) and fuzzy_top_k
+// (first 3 to 6 characters, top 10), both with k = 2 edits. Reports the
+// mean, p99 and max latency, and the mean for fuzzy_find scanning every
+// word with the same automaton instead of walking the trie.
+//
+// Usage: bench_fuzzy [indexed directory] (default 1000000 synthetic words)
+
+#include "flat_trie.h"
+#include "levenshtein.h"
+#include "trie.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// INFO: Letters drawn by rough English frequency, lengths 2 to 14
+static std::vector<std::string> synthetic_words(size_t n) {
+  const std::string letters = "eeeeeeetttttaaaaooooiiiinnnnsssshhhrrrdddllcc"
+                              "uummwwffggyyppbbvkjxqz";
+  std::mt19937 rng(42);
+  std::vector<std::string> words;
+  words.reserve(n);
+  for (size_t i = 0; i < n; i++) {
+    size_t length = 2 + rng() % 7 + rng() % 7;
+    std::string word;
+    for (size_t j = 0; j < length; j++) {
+      word += letters[rng() % letters.size()];
+    }
+    words.push_back(word);
+  }
+  return words;
+}
+
+static std::string misspell(std::string word, size_t edits,
+                            std::mt19937 &rng) {
+  for (size_t i = 0; i < edits; i++) {
+    size_t pos = rng() % (word.size() + 1);
+    char c = static_cast<char>('a' + rng() % 26);
+    switch (rng() % 3) {
+    case 0:
+      if (pos < word.size()) {
+        word[pos] = c;
+        break;
+      }
+      [[fallthrough]];
+    case 1:
+      word.insert(word.begin() + pos, c);
+      break;
+    default:
+      if (word.size() > 1) {
+        word.erase(std::min(pos, word.size() - 1), 1);
+      }
+    }
+  }
+  return word;
+}
+
+template <typename F>
+static void measure(const char *label, const std::vector<std::string> &queries,
+                    F lookup) {
+  std::vector<double> times;
+  size_t results = 0;
+  for (const std::string &query : queries) {
+    auto start = std::chrono::steady_clock::now();
+    results += lookup(query);
+    times.push_back(seconds_since(start));
+  }
+  std::sort(times.begin(), times.end());
+  double total = 0;
+  for (double time : times) {
+    total += time;
+  }
+  std::cout << label << " mean " << total / times.size() * 1e3 << " ms, p99 "
+            << times[times.size() * 99 / 100] * 1e3 << " ms, max "
+            << times.back() * 1e3 << " ms, " << results / queries.size()
+            << " results" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  std::string path = "bench_fuzzy.ac";
+  std::vector<std::string> words;
+  if (argc > 1) {
+    path = std::string(argv[1]) + "/clouseau.ac";
+  } else {
+    words = synthetic_words(1000000);
+    Trie trie;
+    for (size_t i = 0; i < words.size(); i++) {
+      trie.insert(words[i], static_cast<uint32_t>(1000000 / (i + 1)));
+    }
+    FlatTrie::write(trie, path);
+  }
+  FlatTrie flat(path);
+  if (argc > 1) {
+    for (const std::string &word : flat.search("")) {
+      words.push_back(word);
+    }
+  }
+  std::cout << flat.num_words() << " words" << std::endl;
+
+  std::mt19937 rng(7);
+  std::vector<std::string> typos, prefixes;
+  for (size_t i = 0; i < 500; i++) {
+    std::string word = misspell(words[rng() % words.size()], 1 + i % 2, rng);
+    typos.push_back(word);
+    prefixes.push_back(word.substr(0, 3 + rng() % 4));
+  }
+
+  const uint8_t edits = 2;
+  measure("fuzzy_find, 2 edits:      ", typos, [&](const std::string &query) {
+    return flat.fuzzy_find(query, 10, edits).size();
+  });
+  measure("fuzzy_top_k 10, 2 edits:  ", prefixes,
+          [&](const std::string &query) {
+            return flat.fuzzy_top_k(query, 10, edits).size();
+          });
+  measure("fuzzy_top_k 10, by length:", prefixes,
+          [&](const std::string &query) {
+            return flat
+                .fuzzy_top_k(query, 10, edits_for_length(query.size()))
+                .size();
+          });
+
+  // NOTE: Baseline, the same automaton run over every word in turn
+  std::vector<std::string> few(typos.begin(), typos.begin() + 20);
+  measure("scan every word, 2 edits: ", few, [&](const std::string &query) {
+    LevenshteinAutomaton automaton(query, edits);
+    size_t found = 0;
+    for (const std::string &word : words) {
+      LevenshteinAutomaton::State state = automaton.start();
+      size_t i = 0;
+      for (; i < word.size(); i++) {
+        state = automaton.step(state, static_cast<unsigned char>(word[i]));
+        if (automaton.lower_bound(state) > edits) {
+          break;
+        }
+      }
+      found += i == word.size() && automaton.distance(state) <= edits;
+    }
+    return found;
+  });
+
+  if (argc <= 1) {
+    std::remove(path.c_str());
+  }
+  return 0;
+}
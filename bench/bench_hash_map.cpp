@@ -0,0 +1,226 @@
+// NOTE: HashMap engine comparison on string keys: the original node-array
+// map, the current HashMap and std::unordered_map. Each map is built, probed
+// (hits and misses), iterated and erased in turn, then driven through a
+// sliding window of inserts and erases (the incremental-update pattern) and
+// probed for misses. The hash functions are also timed on their own.
+//
+// Usage: bench_hash_map [keys] (default 10M)
+
+#include "hashmap.hpp"
+#include "legacy_hashmap.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// INFO: Adapters so every map is driven through the same calls
+template <typename Map> struct Ops {
+  static void put(Map &map, const std::string &key, int value) {
+    map[key] = value;
+  }
+  static bool has(Map &map, const std::string &key) {
+    return map.find(key) != map.end();
+  }
+  static long sum(Map &map) {
+    long total = 0;
+    for (auto &pair : map) {
+      total += pair.value;
+    }
+    return total;
+  }
+};
+
+template <> struct Ops<std::unordered_map<std::string, int>> {
+  using Map = std::unordered_map<std::string, int>;
+  static void put(Map &map, const std::string &key, int value) {
+    map[key] = value;
+  }
+  static bool has(Map &map, const std::string &key) {
+    return map.find(key) != map.end();
+  }
+  static long sum(Map &map) {
+    long total = 0;
+    for (auto &pair : map) {
+      total += pair.second;
+    }
+    return total;
+  }
+};
+
+template <typename Map>
+static void run(const char *label, const std::vector<std::string> &keys,
+                const std::vector<std::string> &missing) {
+  Map *map = new Map();
+  double n = static_cast<double>(keys.size());
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < keys.size(); i++) {
+    Ops<Map>::put(*map, keys[i], static_cast<int>(i));
+  }
+  double insert = seconds_since(start);
+
+  start = std::chrono::steady_clock::now();
+  size_t found = 0;
+  for (const std::string &key : keys) {
+    found += Ops<Map>::has(*map, key);
+  }
+  double hit = seconds_since(start);
+
+  start = std::chrono::steady_clock::now();
+  for (const std::string &key : missing) {
+    found += Ops<Map>::has(*map, key);
+  }
+  double miss = seconds_since(start);
+
+  start = std::chrono::steady_clock::now();
+  long sum = Ops<Map>::sum(*map);
+  double iterate = seconds_since(start);
+
+  start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < keys.size(); i += 2) {
+    map->erase(keys[i]);
+  }
+  double erase = seconds_since(start);
+  delete map;
+
+  std::cout << label << " insert " << insert / n * 1e9 << " ns, hit "
+            << hit / n * 1e9 << " ns, miss " << miss / n * 1e9
+            << " ns, iterate " << iterate / n * 1e9 << " ns, erase "
+            << erase / (n / 2) * 1e9 << " ns per key [" << found << ", "
+            << sum << "]" << std::endl;
+}
+
+// NOTE: Keeps keys.size() / 10 live keys while every key passes through, so
+// the map sees ten times its size in erases
+template <typename Map>
+static void churn(const char *label, const std::vector<std::string> &keys,
+                  const std::vector<std::string> &missing) {
+  Map *map = new Map();
+  size_t window = keys.size() / 10;
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < keys.size(); i++) {
+    Ops<Map>::put(*map, keys[i], static_cast<int>(i));
+    if (i >= window) {
+      map->erase(keys[i - window]);
+    }
+  }
+  double slide = seconds_since(start);
+
+  start = std::chrono::steady_clock::now();
+  size_t found = 0;
+  for (const std::string &key : missing) {
+    found += Ops<Map>::has(*map, key);
+  }
+  double miss = seconds_since(start);
+  delete map;
+
+  double n = static_cast<double>(keys.size());
+  std::cout << label << " churn " << slide / n * 1e9 << " ns per insert+erase, "
+            << "miss after churn " << miss / n * 1e9 << " ns [" << found
+            << "]" << std::endl;
+}
+
+// INFO: Hits one find at a time against find_many over the same keys
+static void batched_hits(const std::vector<std::string> &keys) {
+  HashMap<std::string, int> map;
+  for (size_t i = 0; i < keys.size(); i++) {
+    map[keys[i]] = static_cast<int>(i);
+  }
+  std::vector<std::string> probes(keys);
+  std::mt19937 rng(7);
+  std::shuffle(probes.begin(), probes.end(), rng);
+  double n = static_cast<double>(probes.size());
+
+  auto start = std::chrono::steady_clock::now();
+  long sum = 0;
+  for (const std::string &key : probes) {
+    sum += (*map.find(key)).value;
+  }
+  double single = seconds_since(start);
+
+  std::vector<HashMap<std::string, int>::Iterator> out(probes.size());
+  start = std::chrono::steady_clock::now();
+  map.find_many(probes.data(), probes.size(), out.data());
+  long batched_sum = 0;
+  for (auto &it : out) {
+    batched_sum += it->value;
+  }
+  double batched = seconds_since(start);
+
+  std::cout << "HashMap            find " << single / n * 1e9
+            << " ns, find_many " << batched / n * 1e9 << " ns per hit [" << sum
+            << ", " << batched_sum << "]" << std::endl;
+}
+
+// INFO: The original hashFunction, stringstream copy then DJB2
+static uint64_t legacy_hash(const std::string &key) {
+  std::stringstream ss;
+  ss << key;
+  std::string str = ss.str();
+  unsigned long hash = 5381;
+  for (char c : str) {
+    hash = ((hash << 5) + hash) + c;
+  }
+  return hash;
+}
+
+template <typename Fn>
+static void time_hash(const char *label, const std::vector<std::string> &keys,
+                      Fn hash) {
+  auto start = std::chrono::steady_clock::now();
+  uint64_t checksum = 0;
+  for (const std::string &key : keys) {
+    checksum ^= hash(key);
+  }
+  double seconds = seconds_since(start);
+  std::cout << label << " " << seconds / keys.size() * 1e9 << " ns per key ["
+            << checksum << "]" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+
+  std::vector<std::string> keys, missing;
+  keys.reserve(n);
+  missing.reserve(n);
+  for (size_t i = 0; i < n; i++) {
+    keys.push_back("term" + std::to_string(i));
+    missing.push_back("miss" + std::to_string(i));
+  }
+
+  // NOTE: Random order, so no map gets cache locality from sequential keys
+  std::mt19937 rng(42);
+  std::shuffle(keys.begin(), keys.end(), rng);
+  std::shuffle(missing.begin(), missing.end(), rng);
+
+  time_hash("hash: stringstream + DJB2", keys, legacy_hash);
+  time_hash("hash: HashPolicy<string> ", keys, HashPolicy<std::string>{});
+  time_hash("hash: std::hash<string>  ", keys, std::hash<std::string>{});
+
+  run<LegacyHashMap<std::string, int>>("legacy HashMap    ", keys, missing);
+  run<HashMap<std::string, int>>("HashMap           ", keys, missing);
+  run<std::unordered_map<std::string, int>>("std::unordered_map", keys,
+                                            missing);
+
+  batched_hits(keys);
+
+  churn<HashMap<std::string, int>>("HashMap           ", keys, missing);
+  churn<std::unordered_map<std::string, int>>("std::unordered_map", keys,
+                                              missing);
+  return 0;
+}
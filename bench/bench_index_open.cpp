@@ -0,0 +1,99 @@
+// NOTE: Time to first query. Compares rebuilding the whole in-memory index
+// with deserialize_index against mapping it with IndexReader, then looking up
+// one term. Finally times 16-term queries of random terms, looked up one
+// find at a time against one find_many.
+//
+// Usage: bench_index_open <indexed directory> [term]
+
+#include "index_reader.h"
+#include "indexer.h"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+static double millis_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    std::cerr << "Usage: bench_index_open <indexed directory> [term]"
+              << std::endl;
+    return 1;
+  }
+  std::string directory = argv[1];
+  std::string term = argc > 2 ? argv[2] : "the";
+
+  auto start = std::chrono::steady_clock::now();
+  size_t df = 0;
+  {
+    Indexer indexer(directory);
+    indexer.deserialize_index();
+    auto it = indexer.index.find(term);
+    if (it != indexer.index.end()) {
+      df = (*it).value.files.size();
+    }
+  }
+  std::cout << "deserialize_index: " << millis_since(start) << " ms (df "
+            << df << ")" << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  df = 0;
+  {
+    IndexReader reader(directory + "/clouseau.idx");
+    TermInfo info;
+    if (reader.find(term, info)) {
+      df = info.df;
+    }
+  }
+  std::cout << "IndexReader:       " << millis_since(start) << " ms (df "
+            << df << ")" << std::endl;
+
+  IndexReader reader(directory + "/clouseau.idx");
+  if (reader.num_terms() == 0) {
+    return 0;
+  }
+  const size_t query_terms = 16, queries = 20000;
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<size_t> pick(0, reader.num_terms() - 1);
+  std::vector<std::string_view> terms(query_terms * queries);
+  for (std::string_view &t : terms) {
+    t = reader.term(pick(rng)).term;
+  }
+
+  std::vector<TermInfo> infos(query_terms);
+  std::unique_ptr<bool[]> found(new bool[query_terms]);
+  start = std::chrono::steady_clock::now();
+  df = 0;
+  for (size_t q = 0; q < queries; q++) {
+    for (size_t i = 0; i < query_terms; i++) {
+      if (reader.find(terms[q * query_terms + i], infos[i])) {
+        df += infos[i].df;
+      }
+    }
+  }
+  double single = millis_since(start);
+
+  start = std::chrono::steady_clock::now();
+  size_t batched_df = 0;
+  for (size_t q = 0; q < queries; q++) {
+    reader.find_many(&terms[q * query_terms], query_terms, infos.data(),
+                     found.get());
+    for (size_t i = 0; i < query_terms; i++) {
+      batched_df += found[i] ? infos[i].df : 0;
+    }
+  }
+  double batched = millis_since(start);
+  std::cout << "16-term lookup:    find " << single / queries * 1000
+            << " us, find_many " << batched / queries * 1000
+            << " us per query (df " << df << ", " << batched_df << ")"
+            << std::endl;
+  return 0;
+}
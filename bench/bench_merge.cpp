@@ -0,0 +1,118 @@
+// NOTE: Merge phase scaling, 1 to 64 threads. Compares merging whole
+// per-thread indexes under one global mutex against merging pre-partitioned
+// shards in parallel without a lock.
+//
+// Usage: bench_merge [terms per thread]
+
+#include "indexer.h"
+#include "sharded_hashmap.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Local = ShardedHashMap<std::string, Frequency>;
+
+// INFO: Zipf-like vocabulary so threads share the common terms
+static void fill_local(Local &local, int thread, int terms) {
+  std::mt19937 rng(thread);
+  std::uniform_real_distribution<double> u(0.0, 1.0);
+  for (int i = 0; i < terms; i++) {
+    int rank = static_cast<int>(std::pow(200000.0, u(rng)));
+    std::string term = "t" + std::to_string(rank);
+    Frequency &freq = local[term];
+    freq.total += 1;
+    freq.files.push_back(FileFrequency{static_cast<uint32_t>(thread), 1, 0.1});
+  }
+}
+
+static void merge_into(HashMap<std::string, Frequency> &target,
+                       HashMap<std::string, Frequency> &source) {
+  for (auto const &pair : source) {
+    if (target.find(pair.key) == target.end()) {
+      target[pair.key] = pair.value;
+    } else {
+      target[pair.key].total += pair.value.total;
+      for (const auto &file_freq : pair.value.files) {
+        target[pair.key].files.push_back(file_freq);
+      }
+    }
+  }
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+static double global_lock_merge(std::vector<Local *> &locals) {
+  HashMap<std::string, Frequency> index;
+  std::mutex index_mutex;
+  std::vector<std::thread> threads;
+
+  auto start = std::chrono::steady_clock::now();
+  for (Local *local : locals) {
+    threads.emplace_back([&, local] {
+      std::lock_guard<std::mutex> lock(index_mutex);
+      for (size_t s = 0; s < local->shard_count(); s++) {
+        merge_into(index, local->shard(s));
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  return seconds_since(start);
+}
+
+static double sharded_merge(std::vector<Local *> &locals) {
+  Local index;
+  std::atomic<size_t> next_shard(0);
+  std::vector<std::thread> threads;
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t t = 0; t < locals.size(); t++) {
+    threads.emplace_back([&] {
+      for (size_t s = next_shard++; s < index.shard_count(); s = next_shard++) {
+        for (Local *local : locals) {
+          merge_into(index.shard(s), local->shard(s));
+        }
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  return seconds_since(start);
+}
+
+int main(int argc, char *argv[]) {
+  int terms = argc > 1 ? std::stoi(argv[1]) : 50000;
+  std::cout << "threads  global-lock(ms)  sharded(ms)  speedup" << std::endl;
+
+  for (int num_threads = 1; num_threads <= 64; num_threads *= 2) {
+    std::vector<Local *> locals;
+    for (int t = 0; t < num_threads; t++) {
+      locals.push_back(new Local());
+      fill_local(*locals.back(), t, terms);
+    }
+
+    double locked = global_lock_merge(locals);
+    double sharded = sharded_merge(locals);
+    std::cout << num_threads << "\t " << locked * 1000 << "\t\t  "
+              << sharded * 1000 << "\t       " << locked / sharded << "x"
+              << std::endl;
+
+    for (Local *local : locals) {
+      delete local;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,73 @@
+// NOTE: Postings codec throughput and size. Compares the compressed block
+// format against the previous fixed 16-byte postings (uint32 doc, int count,
+// double tf) for sparse, medium and dense terms.
+//
+// Usage: bench_postings [postings per list]
+
+#include "postings_codec.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// INFO: Average gap controls how dense the term is across the collection
+static void run(const char *label, size_t n, uint32_t average_gap) {
+  std::mt19937 rng(42);
+  std::geometric_distribution<uint32_t> gap(1.0 / average_gap);
+  std::geometric_distribution<uint32_t> count(0.5);
+
+  std::vector<uint32_t> docs(n), counts(n);
+  uint32_t doc = 0;
+  for (size_t i = 0; i < n; i++) {
+    doc += gap(rng) + (i == 0 ? 0 : 1);
+    docs[i] = doc;
+    counts[i] = count(rng) + 1;
+  }
+
+  const int ROUNDS = 20;
+  std::string encoded;
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < ROUNDS; r++) {
+    encoded.clear();
+    encode_postings(docs.data(), counts.data(), n, encoded);
+  }
+  double encode_seconds = seconds_since(start);
+
+  uint64_t checksum = 0;
+  uint32_t out_docs[POSTINGS_BLOCK_SIZE], out_counts[POSTINGS_BLOCK_SIZE];
+  start = std::chrono::steady_clock::now();
+  for (int r = 0; r < ROUNDS; r++) {
+    PostingsDecoder decoder(encoded.data(), encoded.size());
+    for (size_t k = decoder.next(out_docs, out_counts); k > 0;
+         k = decoder.next(out_docs, out_counts)) {
+      checksum += out_docs[k - 1] + out_counts[0];
+    }
+  }
+  double decode_seconds = seconds_since(start);
+
+  double postings = static_cast<double>(n) * ROUNDS;
+  std::cout << label << ": " << encoded.size() * 1.0 / n
+            << " bytes/posting (raw 16), encode "
+            << postings / encode_seconds / 1e6 << " M/s, decode "
+            << postings / decode_seconds / 1e6 << " M/s"
+            << " [checksum " << checksum << "]" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+  run("dense  (gap ~1)   ", n, 1);
+  run("medium (gap ~16)  ", n, 16);
+  run("sparse (gap ~1000)", n, 1000);
+  return 0;
+}
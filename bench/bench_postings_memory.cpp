@@ -0,0 +1,118 @@
+// NOTE: Memory per term of the in-memory postings lists. Loads every term's
+// postings from a saved index into the original ArrayList (mutex per list),
+// the current ArrayList, the PostingsList used by Frequency and a two-inline
+// variant for comparison. Reports bytes per term (the Frequency struct plus
+// the heap it points at), the same with malloc's per-block overhead, and heap
+// allocations per term.
+//
+// Usage: bench_postings_memory <indexed directory>
+
+#include "array_list.hpp"
+#include "index_reader.h"
+#include "indexer.h"
+#include "legacy_array_list.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+
+static size_t heap_bytes = 0;
+static size_t heap_footprint = 0;
+static size_t heap_allocations = 0;
+
+// INFO: Chunk a glibc-style malloc hands out for size bytes: an 8-byte
+// header, rounded up to 16 bytes, 32 bytes at least
+static size_t footprint(size_t size) {
+  size_t chunk = (size + sizeof(size_t) + 15) & ~static_cast<size_t>(15);
+  return chunk < 32 ? 32 : chunk;
+}
+
+// INFO: Counts what is asked for, the size is stashed in front of the block
+void *operator new(size_t size) {
+  void *block = std::malloc(size + alignof(std::max_align_t));
+  if (block == nullptr) {
+    throw std::bad_alloc();
+  }
+  *static_cast<size_t *>(block) = size;
+  heap_bytes += size;
+  heap_footprint += footprint(size);
+  heap_allocations++;
+  return static_cast<char *>(block) + alignof(std::max_align_t);
+}
+
+void operator delete(void *pointer) noexcept {
+  if (pointer != nullptr) {
+    void *block = static_cast<char *>(pointer) - alignof(std::max_align_t);
+    heap_bytes -= *static_cast<size_t *>(block);
+    heap_footprint -= footprint(*static_cast<size_t *>(block));
+    heap_allocations--;
+    std::free(block);
+  }
+}
+
+void operator delete(void *pointer, size_t) noexcept {
+  operator delete(pointer);
+}
+
+template <typename List> struct Entry {
+  int total;
+  double idf;
+  List files;
+};
+
+template <typename List>
+static void measure(const char *label, const IndexReader &reader) {
+  size_t terms = reader.num_terms();
+  size_t bytes_before = heap_bytes, footprint_before = heap_footprint;
+  size_t allocations_before = heap_allocations;
+  {
+    std::unique_ptr<Entry<List>[]> entries(new Entry<List>[terms]);
+    uint32_t docs[POSTINGS_BLOCK_SIZE], counts[POSTINGS_BLOCK_SIZE];
+    for (size_t i = 0; i < terms; i++) {
+      PostingsDecoder decoder = reader.postings(reader.term(i));
+      for (size_t n = decoder.next(docs, counts); n > 0;
+           n = decoder.next(docs, counts)) {
+        for (size_t j = 0; j < n; j++) {
+          entries[i].files.push_back(
+              FileFrequency{docs[j], static_cast<int>(counts[j]), 0.0});
+        }
+      }
+    }
+
+    double bytes = static_cast<double>(heap_bytes - bytes_before);
+    double held = static_cast<double>(heap_footprint - footprint_before);
+    double allocations =
+        static_cast<double>(heap_allocations - allocations_before - 1);
+    std::cout << label << " " << sizeof(Entry<List>) << " B struct, "
+              << bytes / terms << " B per term (" << held / terms
+              << " B with allocator overhead), " << allocations / terms
+              << " allocations per term" << std::endl;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    std::cerr << "Usage: bench_postings_memory <indexed directory>"
+              << std::endl;
+    return 1;
+  }
+
+  IndexReader reader(std::string(argv[1]) + "/clouseau.idx");
+  size_t single = 0, postings = 0;
+  for (size_t i = 0; i < reader.num_terms(); i++) {
+    uint32_t df = reader.term(i).df;
+    single += df == 1;
+    postings += df;
+  }
+  std::cout << reader.num_terms() << " terms, " << postings << " postings, "
+            << 100.0 * single / reader.num_terms() << "% in one document"
+            << std::endl;
+
+  measure<LegacyArrayList<FileFrequency>>("original ArrayList:", reader);
+  measure<ArrayList<FileFrequency>>("ArrayList:         ", reader);
+  measure<PostingsList>("PostingsList:      ", reader);
+  measure<SmallArrayList<FileFrequency, 2>>("two inline:        ", reader);
+  return 0;
+}
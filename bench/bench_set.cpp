@@ -0,0 +1,129 @@
+// NOTE: Boolean query evaluation, the original unsorted Set against the
+// sorted one and DocBitmap. Each query builds both terms' doc sets block by
+// block the way search_handler decodes postings, then runs AND, OR and AND
+// NOT. A common term (every few documents) is paired with an equally common
+// one, a rare one and one in every document, so merges, galloping, bitmap
+// words and runs are all measured.
+//
+// Usage: bench_set [documents] (default 20000)
+
+#include "doc_bitmap.h"
+#include "legacy_set.hpp"
+#include "set.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+static constexpr size_t BLOCK = 128; // NOTE: POSTINGS_BLOCK_SIZE
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// INFO: Ascending doc IDs, each document kept with probability 1 / every
+static std::vector<uint32_t> postings(size_t documents, size_t every,
+                                      std::mt19937 &rng) {
+  std::vector<uint32_t> docs;
+  for (size_t doc = 0; doc < documents; doc++) {
+    if (rng() % every == 0) {
+      docs.push_back(static_cast<uint32_t>(doc));
+    }
+  }
+  return docs;
+}
+
+template <typename S> static S build(const std::vector<uint32_t> &docs) {
+  S set;
+  for (size_t i = 0; i < docs.size(); i += BLOCK) {
+    size_t n = std::min(BLOCK, docs.size() - i);
+    set.insert(docs.data() + i, docs.data() + i + n);
+  }
+  return set;
+}
+
+// NOTE: Same evaluation as search_handler before and after the sorted Set
+static size_t query_legacy(const std::vector<uint32_t> &left,
+                           const std::vector<uint32_t> &right) {
+  LegacySet<uint32_t> a = build<LegacySet<uint32_t>>(left);
+  LegacySet<uint32_t> b = build<LegacySet<uint32_t>>(right);
+  size_t both = a.intersect(b).size();
+  LegacySet<uint32_t> either = a;
+  either.insert(b.begin(), b.end());
+  LegacySet<uint32_t> only = a;
+  for (const auto &doc : b) {
+    only.erase(doc);
+  }
+  return both + either.size() + only.size();
+}
+
+static size_t query_sorted(const std::vector<uint32_t> &left,
+                           const std::vector<uint32_t> &right) {
+  Set<uint32_t> a = build<Set<uint32_t>>(left);
+  Set<uint32_t> b = build<Set<uint32_t>>(right);
+  return a.intersect(b).size() + a.unite(b).size() + a.difference(b).size();
+}
+
+static size_t query_bitmap(const std::vector<uint32_t> &left,
+                           const std::vector<uint32_t> &right) {
+  DocBitmap a, b;
+  for (size_t i = 0; i < left.size(); i += BLOCK) {
+    a.add_many(left.data() + i, std::min(BLOCK, left.size() - i));
+  }
+  for (size_t i = 0; i < right.size(); i += BLOCK) {
+    b.add_many(right.data() + i, std::min(BLOCK, right.size() - i));
+  }
+  a.run_optimize();
+  b.run_optimize();
+  return a.intersect(b).cardinality() + a.unite(b).cardinality() +
+         a.difference(b).cardinality();
+}
+
+template <typename Query>
+static double time_query(Query query, const std::vector<uint32_t> &left,
+                         const std::vector<uint32_t> &right, size_t &check) {
+  size_t repeats = 200;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < repeats; i++) {
+    check = query(left, right);
+  }
+  return seconds_since(start) / repeats;
+}
+
+static void compare(const char *label, const std::vector<uint32_t> &left,
+                    const std::vector<uint32_t> &right) {
+  auto start = std::chrono::steady_clock::now();
+  size_t legacy_check = query_legacy(left, right);
+  double legacy = seconds_since(start);
+
+  // NOTE: The others are timed over many queries to get above the timer
+  size_t sorted_check = 0, bitmap_check = 0;
+  double sorted = time_query(query_sorted, left, right, sorted_check);
+  double bitmap = time_query(query_bitmap, left, right, bitmap_check);
+
+  bool match = legacy_check == sorted_check && legacy_check == bitmap_check;
+  std::cout << label << " (" << left.size() << " x " << right.size()
+            << " docs): legacy " << legacy * 1e3 << " ms, sorted "
+            << sorted * 1e6 << " us, DocBitmap " << bitmap * 1e6
+            << " us per query" << (match ? "" : " MISMATCH") << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  size_t documents = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+  std::mt19937 rng(42);
+  std::vector<uint32_t> common = postings(documents, 2, rng);
+  std::vector<uint32_t> other = postings(documents, 3, rng);
+  std::vector<uint32_t> rare = postings(documents, 500, rng);
+  std::vector<uint32_t> every = postings(documents, 1, rng);
+
+  compare("common, common", common, other);
+  compare("common, rare  ", common, rare);
+  compare("common, every ", common, every);
+  return 0;
+}
@@ -0,0 +1,179 @@
+// NOTE: Autocomplete trie, the original one node per character with a
+// HashMap of children against the radix trie. Reports heap bytes per word
+// after inserting the vocabulary, build time, and prefix search latency for
+// 1-, 2- and 3-character prefixes of vocabulary words. For the radix trie it
+// also times top_k(prefix, 10), the ranked completions autocomplete shows.
+// The radix trie is then written as a FlatTrie (the clouseau.ac file) and
+// reported by file size, heap bytes and time to open plus answer a first
+// query, which is autocomplete's startup cost against the build time above.
+//
+// Usage: bench_trie [indexed directory] (default 300000 synthetic words)
+
+#include "flat_trie.h"
+#include "index_reader.h"
+#include "legacy_trie.hpp"
+#include "trie.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+static size_t heap_bytes = 0;
+
+// INFO: Counts what is asked for, the size is stashed in front of the block
+void *operator new(size_t size) {
+  void *block = std::malloc(size + alignof(std::max_align_t));
+  if (block == nullptr) {
+    throw std::bad_alloc();
+  }
+  *static_cast<size_t *>(block) = size;
+  heap_bytes += size;
+  return static_cast<char *>(block) + alignof(std::max_align_t);
+}
+
+void operator delete(void *pointer) noexcept {
+  if (pointer != nullptr) {
+    void *block = static_cast<char *>(pointer) - alignof(std::max_align_t);
+    heap_bytes -= *static_cast<size_t *>(block);
+    std::free(block);
+  }
+}
+
+void operator delete(void *pointer, size_t) noexcept {
+  operator delete(pointer);
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+static void insert(LegacyTrie &trie, const std::string &word, uint32_t) {
+  trie.insert(word);
+}
+
+static void insert(Trie &trie, const std::string &word, uint32_t score) {
+  trie.insert(word, score);
+}
+
+// INFO: Letters drawn by rough English frequency, lengths 2 to 14
+static std::vector<std::string> synthetic_words(size_t n) {
+  const std::string letters = "eeeeeeetttttaaaaooooiiiinnnnsssshhhrrrdddllcc"
+                              "uummwwffggyyppbbvkjxqz";
+  std::mt19937 rng(42);
+  std::vector<std::string> words;
+  words.reserve(n);
+  for (size_t i = 0; i < n; i++) {
+    size_t length = 2 + rng() % 7 + rng() % 7;
+    std::string word;
+    for (size_t j = 0; j < length; j++) {
+      word += letters[rng() % letters.size()];
+    }
+    words.push_back(word);
+  }
+  return words;
+}
+
+template <typename T>
+static T *measure(const char *label, const std::vector<std::string> &words,
+                  const std::vector<uint32_t> &scores) {
+  size_t before = heap_bytes;
+  auto start = std::chrono::steady_clock::now();
+  T *trie = new T();
+  for (size_t i = 0; i < words.size(); i++) {
+    insert(*trie, words[i], scores[i]);
+  }
+  double build = seconds_since(start);
+  double bytes = static_cast<double>(heap_bytes - before);
+  std::cout << label << " " << bytes / words.size() << " B per word ("
+            << bytes / (1 << 20) << " MB), build " << build * 1e3 << " ms"
+            << std::endl;
+
+  std::mt19937 rng(7);
+  for (size_t length = 1; length <= 3; length++) {
+    size_t queries = 200, results = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < queries; i++) {
+      const std::string &word = words[rng() % words.size()];
+      results += trie->search(word.substr(0, length)).size();
+    }
+    double seconds = seconds_since(start) / queries;
+    std::cout << "  " << length << "-char prefix: " << seconds * 1e6
+              << " us per search, " << results / queries << " words"
+              << std::endl;
+  }
+  // NOTE: The original trie never frees its nodes, so neither trie is
+  // deleted here to keep the comparison fair
+  return trie;
+}
+
+template <typename T>
+static void measure_top_k(const T &trie,
+                          const std::vector<std::string> &words) {
+  std::mt19937 rng(7);
+  for (size_t length = 1; length <= 3; length++) {
+    size_t queries = 200, results = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < queries; i++) {
+      const std::string &word = words[rng() % words.size()];
+      results += trie.top_k(word.substr(0, length), 10).size();
+    }
+    double seconds = seconds_since(start) / queries;
+    std::cout << "  " << length << "-char prefix, top 10: " << seconds * 1e6
+              << " us per search" << std::endl;
+  }
+}
+
+static void measure_flat(const Trie &trie,
+                         const std::vector<std::string> &words) {
+  const std::string path = "bench_trie.ac";
+  FlatTrie::write(trie, path);
+
+  size_t before = heap_bytes;
+  auto start = std::chrono::steady_clock::now();
+  FlatTrie *flat = new FlatTrie(path);
+  size_t results = flat->top_k(words[0].substr(0, 1), 10).size();
+  double startup = seconds_since(start);
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  std::cout << "FlatTrie:      " << static_cast<double>(file.tellg()) /
+                                        words.size()
+            << " B per word on disk, "
+            << static_cast<double>(heap_bytes - before) / (1 << 10)
+            << " KB heap, open + first top 10 (" << results << " words) "
+            << startup * 1e3 << " ms" << std::endl;
+
+  measure_top_k(*flat, words);
+  delete flat;
+  std::remove(path.c_str());
+}
+
+int main(int argc, char *argv[]) {
+  std::vector<std::string> words;
+  std::vector<uint32_t> scores;
+  if (argc > 1) {
+    IndexReader reader(std::string(argv[1]) + "/clouseau.idx");
+    for (size_t i = 0; i < reader.num_terms(); i++) {
+      words.emplace_back(reader.term(i).term);
+      scores.push_back(reader.term(i).total);
+    }
+  } else {
+    words = synthetic_words(300000);
+    for (size_t i = 0; i < words.size(); i++) {
+      scores.push_back(static_cast<uint32_t>(1000000 / (i + 1))); // NOTE: Zipf
+    }
+  }
+  std::cout << words.size() << " words" << std::endl;
+
+  measure<LegacyTrie>("original Trie:", words, scores);
+  Trie *trie = measure<Trie>("radix Trie:   ", words, scores);
+  measure_top_k(*trie, words);
+  measure_flat(*trie, words);
+  return 0;
+}
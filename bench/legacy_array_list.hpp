@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <utility>
+
+// NOTE: The original ArrayList (a mutex taken on every push_back, growth
+// through new T[] that default-constructs the whole new capacity), kept only
+// as a benchmark baseline.
+template <typename T> class LegacyArrayList {
+private:
+  T *data_;
+  size_t size_;
+  size_t capacity_;
+  std::mutex mtx_;
+
+  void resize_if_needed() {
+    if (size_ == capacity_) {
+      size_t new_capacity = capacity_ == 0 ? 1 : capacity_ * 2;
+      T *new_data = new T[new_capacity];
+      for (size_t i = 0; i < size_; ++i) {
+        new_data[i] = std::move(data_[i]);
+      }
+      delete[] data_;
+      data_ = new_data;
+      capacity_ = new_capacity;
+    }
+  }
+
+public:
+  LegacyArrayList() : data_(nullptr), size_(0), capacity_(0) {}
+  ~LegacyArrayList() { delete[] data_; }
+
+  LegacyArrayList(const LegacyArrayList &) = delete;
+  LegacyArrayList &operator=(const LegacyArrayList &) = delete;
+
+  void push_back(const T &value) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    resize_if_needed();
+    data_[size_++] = value;
+  }
+
+  T &operator[](size_t index) { return data_[index]; }
+  size_t size() const { return size_; }
+};
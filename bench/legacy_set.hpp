@@ -0,0 +1,186 @@
+#pragma once
+
+#include <algorithm>
+#include <initializer_list>
+#include <mutex>
+#include <utility>
+
+// NOTE: The original Set (an unsorted array behind a mutex: linear contains,
+// O(n) insert and O(n*m) intersect), kept only as a benchmark baseline.
+template <typename T> class LegacySet {
+public:
+  class Iterator {
+  public:
+    Iterator(T *ptr) : ptr_(ptr) {}
+    Iterator operator++() {
+      ++ptr_;
+      return *this;
+    }
+    bool operator!=(const Iterator &other) const { return ptr_ != other.ptr_; }
+    T &operator*() const { return *ptr_; }
+
+  private:
+    T *ptr_;
+  };
+
+  LegacySet();
+  explicit LegacySet(size_t capacity);
+  LegacySet(std::initializer_list<T> list);
+  ~LegacySet();
+
+  LegacySet(const LegacySet &other);
+  LegacySet &operator=(const LegacySet &other);
+  LegacySet(LegacySet &&other) noexcept;
+  LegacySet &operator=(LegacySet &&other) noexcept;
+
+  bool contains(const T &value) const;
+  void insert(const T &value);
+  template <typename InputIt> void insert(InputIt first, InputIt last);
+  void erase(const T &value);
+  LegacySet<T> intersect(const LegacySet<T> &other) const;
+  size_t size() const;
+  size_t capacity() const;
+  bool empty() const;
+  void clear();
+  Iterator begin() { return Iterator(data_); }
+  Iterator end() { return Iterator(data_ + size_); }
+
+private:
+  T *data_;
+  size_t size_;
+  size_t capacity_;
+  std::mutex mtx_;
+
+  void resize_if_needed();
+  void copy_from(const LegacySet &other);
+  void move_from(LegacySet &&other);
+};
+
+template <typename T> LegacySet<T>::LegacySet() : data_(nullptr), size_(0), capacity_(0) {}
+
+template <typename T>
+LegacySet<T>::LegacySet(size_t capacity) : size_(0), capacity_(capacity) {
+  data_ = new T[capacity];
+}
+
+template <typename T>
+LegacySet<T>::LegacySet(std::initializer_list<T> list) : LegacySet(list.size()) {
+  size_ = 0;
+  for (const T &element : list) {
+    insert(element);
+  }
+}
+
+template <typename T> LegacySet<T>::~LegacySet() { delete[] data_; }
+
+template <typename T> LegacySet<T>::LegacySet(const LegacySet &other) { copy_from(other); }
+
+template <typename T> LegacySet<T> &LegacySet<T>::operator=(const LegacySet &other) {
+  if (this != &other) {
+    delete[] data_;
+    copy_from(other);
+  }
+  return *this;
+}
+
+template <typename T> LegacySet<T>::LegacySet(LegacySet &&other) noexcept {
+  move_from(std::move(other));
+}
+
+template <typename T> LegacySet<T> &LegacySet<T>::operator=(LegacySet &&other) noexcept {
+  if (this != &other) {
+    delete[] data_;
+    move_from(std::move(other));
+  }
+  return *this;
+}
+
+template <typename T> bool LegacySet<T>::contains(const T &value) const {
+  for (size_t i = 0; i < size_; ++i) {
+    if (data_[i] == value) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename T> void LegacySet<T>::insert(const T &value) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  if (!contains(value)) {
+    resize_if_needed();
+    data_[size_++] = value;
+  }
+}
+
+template <typename T>
+template <typename InputIt>
+void LegacySet<T>::insert(InputIt first, InputIt last) {
+  for (InputIt it = first; it != last; ++it) {
+    insert(*it);
+  }
+}
+
+template <typename T> void LegacySet<T>::erase(const T &value) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  for (size_t i = 0; i < size_; ++i) {
+    if (data_[i] == value) {
+      data_[i] = data_[--size_];
+      break;
+    }
+  }
+}
+
+template <typename T> LegacySet<T> LegacySet<T>::intersect(const LegacySet<T> &other) const {
+  LegacySet<T> result;
+  for (size_t i = 0; i < size_; ++i) {
+    if (other.contains(data_[i])) {
+      result.insert(data_[i]);
+    }
+  }
+  return result;
+}
+
+template <typename T> size_t LegacySet<T>::size() const { return size_; }
+
+template <typename T> size_t LegacySet<T>::capacity() const { return capacity_; }
+
+template <typename T> bool LegacySet<T>::empty() const { return size_ == 0; }
+
+template <typename T> void LegacySet<T>::clear() {
+  std::lock_guard<std::mutex> lock(mtx_);
+  size_ = 0;
+}
+
+template <typename T> void LegacySet<T>::resize_if_needed() {
+  if (size_ == capacity_) {
+    size_t new_capacity = capacity_ == 0 ? 1 : capacity_ * 2;
+    T *new_data = new T[new_capacity];
+
+    for (size_t i = 0; i < size_; ++i) {
+      new_data[i] = std::move(data_[i]);
+    }
+
+    delete[] data_;
+    data_ = new_data;
+    capacity_ = new_capacity;
+  }
+}
+
+template <typename T> void LegacySet<T>::copy_from(const LegacySet &other) {
+  data_ = new T[other.capacity_];
+  size_ = other.size_;
+  capacity_ = other.capacity_;
+  for (size_t i = 0; i < size_; ++i) {
+    data_[i] = other.data_[i];
+  }
+}
+
+template <typename T> void LegacySet<T>::move_from(LegacySet &&other) {
+  data_ = other.data_;
+  size_ = other.size_;
+  capacity_ = other.capacity_;
+
+  other.data_ = nullptr;
+  other.size_ = 0;
+  other.capacity_ = 0;
+}
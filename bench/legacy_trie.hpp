@@ -0,0 +1,69 @@
+#pragma once
+
+#include "array_list.hpp"
+#include "hashmap.hpp"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+// NOTE: The original Trie (one node per character, each with its own
+// HashMap of children, never freed), kept only as a benchmark baseline.
+class LegacyTrieNode {
+public:
+  char character;
+  bool is_end_of_word;
+  HashMap<char, LegacyTrieNode *> children;
+
+  LegacyTrieNode(char character)
+      : character(character), is_end_of_word(false) {}
+};
+
+class LegacyTrie {
+public:
+  LegacyTrieNode *root;
+
+  LegacyTrie() : root(new LegacyTrieNode('\0')) {}
+
+  void insert(const std::string &word) {
+    LegacyTrieNode *current = root;
+    for (char c : word) {
+      auto child = current->children.try_emplace(c, nullptr);
+      if (child.second) {
+        child.first->value = new LegacyTrieNode(c);
+      }
+      current = child.first->value;
+    }
+    current->is_end_of_word = true;
+  }
+
+  void collect_all_words(LegacyTrieNode *node, const std::string &prefix,
+                         ArrayList<std::string> &results) {
+    if (node->is_end_of_word) {
+      results.push_back(prefix);
+    }
+    std::vector<std::pair<char, LegacyTrieNode *>> children;
+    for (auto const &pair : node->children) {
+      children.emplace_back(pair.key, pair.value);
+    }
+    std::sort(children.begin(), children.end());
+    for (auto const &child : children) {
+      collect_all_words(child.second, prefix + child.first, results);
+    }
+  }
+
+  ArrayList<std::string> search(const std::string &prefix) {
+    LegacyTrieNode *current = root;
+    for (char c : prefix) {
+      auto child = current->children.find(c);
+      if (child == current->children.end()) {
+        return ArrayList<std::string>();
+      }
+      current = child->value;
+    }
+    ArrayList<std::string> results;
+    collect_all_words(current, prefix, results);
+    return results;
+  }
+};
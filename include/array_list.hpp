@@ -1,11 +1,41 @@
 #pragma once
 
+#include <cstring>
 #include <initializer_list>
+#include <memory>
 #include <mutex>
+#include <new>
 #include <stdexcept>
+#include <type_traits>
 #include <utility>
 
-template <typename T> class ArrayList {
+// NOTE: Locking policies for ArrayList. Almost every list is owned by one
+// thread, so the default takes no lock at all; MutexLockPolicy makes
+// push_back, emplace_back, pop_back, reserve and clear safe to call from
+// several threads at once.
+struct NoLockPolicy {
+  void lock() {}
+  void unlock() {}
+};
+
+struct MutexLockPolicy {
+  MutexLockPolicy() = default;
+  // NOTE: A copy gets its own, unlocked mutex
+  MutexLockPolicy(const MutexLockPolicy &) {}
+  MutexLockPolicy &operator=(const MutexLockPolicy &) { return *this; }
+
+  void lock() { mutex.lock(); }
+  void unlock() { mutex.unlock(); }
+
+private:
+  std::mutex mutex;
+};
+
+// NOTE: Elements live in raw storage and are only constructed when added, so
+// growing never default-constructs the spare capacity. Trivially copyable
+// elements are relocated with one memcpy.
+template <typename T, typename Lock = NoLockPolicy>
+class ArrayList : private Lock {
 public:
   class Iterator {
   public:
@@ -28,7 +58,8 @@ public:
 
   ArrayList();
 
-  // NOTE: Explicit does not allow implicit conversion
+  // NOTE: Explicit does not allow implicit conversion. Reserves capacity,
+  // the list starts empty.
   explicit ArrayList(size_t capacity);
 
   // NOTE: allows construct with initializer list (e.g. {1, 2, 3})
@@ -50,11 +81,16 @@ public:
 
   void push_back(const T &value);
   void push_back(T &&value);
+  // NOTE: Constructs the element in place from args, returns it
+  template <typename... Args> T &emplace_back(Args &&...args);
   void pop_back();
+  // INFO: Grows capacity to at least n, never shrinks
+  void reserve(size_t n);
   size_t size() const;
   size_t capacity() const;
   bool empty() const;
   void clear();
+  void swap(ArrayList &other) noexcept;
   Iterator begin() const { return Iterator(data_); }
   Iterator end() const { return Iterator(data_ + size_); }
 
@@ -62,139 +98,232 @@ private:
   T *data_;
   size_t size_;
   size_t capacity_;
-  std::mutex mtx_;
 
-  void resize_if_needed();
+  static T *allocate(size_t n);
+  static void deallocate(T *data, size_t n);
+  void destroy_all();
+  void grow_to(size_t new_capacity);
   void copy_from(const ArrayList &other);
   void move_from(ArrayList &&other);
 };
 
 // NOTE: Implementation
 
-template <typename T>
-ArrayList<T>::ArrayList() : data_(nullptr), size_(0), capacity_(0) {}
+template <typename T, typename Lock>
+ArrayList<T, Lock>::ArrayList() : data_(nullptr), size_(0), capacity_(0) {}
 
-template <typename T>
-ArrayList<T>::ArrayList(size_t capacity) : size_(0), capacity_(capacity) {
-  data_ = new T[capacity];
-}
+template <typename T, typename Lock>
+ArrayList<T, Lock>::ArrayList(size_t capacity)
+    : data_(allocate(capacity)), size_(0), capacity_(capacity) {}
 
-template <typename T>
-ArrayList<T>::ArrayList(std::initializer_list<T> list)
+template <typename T, typename Lock>
+ArrayList<T, Lock>::ArrayList(std::initializer_list<T> list)
     : ArrayList(list.size()) {
-  size_ = 0;
   for (const T &element : list) {
-    data_[size_++] = element;
+    new (data_ + size_) T(element);
+    size_++;
   }
 }
 
-template <typename T> ArrayList<T>::~ArrayList() { delete[] data_; }
+template <typename T, typename Lock> ArrayList<T, Lock>::~ArrayList() {
+  destroy_all();
+  deallocate(data_, capacity_);
+}
 
-template <typename T> ArrayList<T>::ArrayList(const ArrayList &other) {
+template <typename T, typename Lock>
+ArrayList<T, Lock>::ArrayList(const ArrayList &other) : Lock() {
   copy_from(other);
 }
 
-template <typename T>
-ArrayList<T> &ArrayList<T>::operator=(const ArrayList &other) {
+// NOTE: Copy first, then swap, so a throwing element copy leaves this list
+// as it was
+template <typename T, typename Lock>
+ArrayList<T, Lock> &ArrayList<T, Lock>::operator=(const ArrayList &other) {
   if (this != &other) {
-    delete[] data_;
-    copy_from(other);
+    ArrayList copy(other);
+    swap(copy);
   }
   return *this;
 }
 
-template <typename T> ArrayList<T>::ArrayList(ArrayList &&other) noexcept {
+template <typename T, typename Lock>
+ArrayList<T, Lock>::ArrayList(ArrayList &&other) noexcept : Lock() {
   move_from(std::move(other));
 }
 
-template <typename T>
-ArrayList<T> &ArrayList<T>::operator=(ArrayList &&other) noexcept {
+template <typename T, typename Lock>
+ArrayList<T, Lock> &ArrayList<T, Lock>::operator=(ArrayList &&other) noexcept {
   if (this != &other) {
-    delete[] data_;
+    destroy_all();
+    deallocate(data_, capacity_);
     move_from(std::move(other));
   }
   return *this;
 }
 
-template <typename T> T &ArrayList<T>::operator[](size_t index) {
+template <typename T, typename Lock>
+T &ArrayList<T, Lock>::operator[](size_t index) {
   return data_[index];
 }
 
-template <typename T> const T &ArrayList<T>::operator[](size_t index) const {
+template <typename T, typename Lock>
+const T &ArrayList<T, Lock>::operator[](size_t index) const {
   return data_[index];
 }
 // Access with bounds checking
-template <typename T> T &ArrayList<T>::at(size_t index) {
+template <typename T, typename Lock> T &ArrayList<T, Lock>::at(size_t index) {
   if (index >= size_) {
     throw std::out_of_range("Index out of range");
   }
   return data_[index];
 }
 
-template <typename T> const T &ArrayList<T>::at(size_t index) const {
+template <typename T, typename Lock>
+const T &ArrayList<T, Lock>::at(size_t index) const {
   if (index >= size_) {
     throw std::out_of_range("Index out of range");
   }
   return data_[index];
 }
 
-template <typename T> void ArrayList<T>::push_back(const T &value) {
-  std::lock_guard<std::mutex> lock(mtx_);
-  resize_if_needed();
-  data_[size_++] = value;
+template <typename T, typename Lock>
+void ArrayList<T, Lock>::push_back(const T &value) {
+  emplace_back(value);
 }
 
-template <typename T> void ArrayList<T>::push_back(T &&value) {
-  std::lock_guard<std::mutex> lock(mtx_);
-  resize_if_needed();
-  data_[size_++] = std::move(value);
+template <typename T, typename Lock>
+void ArrayList<T, Lock>::push_back(T &&value) {
+  emplace_back(std::move(value));
 }
 
-template <typename T> void ArrayList<T>::pop_back() {
-  std::lock_guard<std::mutex> lock(mtx_);
+template <typename T, typename Lock>
+template <typename... Args>
+T &ArrayList<T, Lock>::emplace_back(Args &&...args) {
+  std::lock_guard<Lock> lock(*this);
+  if (size_ == capacity_) {
+    // NOTE: args may refer to an element of this list, so build the new
+    // element before the old storage is released
+    T value(std::forward<Args>(args)...);
+    grow_to(capacity_ == 0 ? 1 : capacity_ * 2);
+    new (data_ + size_) T(std::move(value));
+  } else {
+    new (data_ + size_) T(std::forward<Args>(args)...);
+  }
+  return data_[size_++];
+}
+
+template <typename T, typename Lock> void ArrayList<T, Lock>::pop_back() {
+  std::lock_guard<Lock> lock(*this);
   if (size_ > 0) {
     --size_;
+    data_[size_].~T();
+  }
+}
+
+template <typename T, typename Lock>
+void ArrayList<T, Lock>::reserve(size_t n) {
+  std::lock_guard<Lock> lock(*this);
+  if (n > capacity_) {
+    grow_to(n);
   }
 }
 
-template <typename T> size_t ArrayList<T>::size() const { return size_; }
+template <typename T, typename Lock> size_t ArrayList<T, Lock>::size() const {
+  return size_;
+}
 
-template <typename T> size_t ArrayList<T>::capacity() const {
+template <typename T, typename Lock>
+size_t ArrayList<T, Lock>::capacity() const {
   return capacity_;
 }
 
-template <typename T> bool ArrayList<T>::empty() const { return size_ == 0; }
+template <typename T, typename Lock> bool ArrayList<T, Lock>::empty() const {
+  return size_ == 0;
+}
 
-template <typename T> void ArrayList<T>::clear() {
-  std::lock_guard<std::mutex> lock(mtx_);
-  size_ = 0;
+template <typename T, typename Lock> void ArrayList<T, Lock>::clear() {
+  std::lock_guard<Lock> lock(*this);
+  destroy_all();
 }
 
-template <typename T> void ArrayList<T>::resize_if_needed() {
-  if (size_ == capacity_) {
-    size_t new_capacity = capacity_ == 0 ? 1 : capacity_ * 2;
-    T *new_data = new T[new_capacity];
+// INFO: Swaps the elements, each list keeps its own lock
+template <typename T, typename Lock>
+void ArrayList<T, Lock>::swap(ArrayList &other) noexcept {
+  std::swap(data_, other.data_);
+  std::swap(size_, other.size_);
+  std::swap(capacity_, other.capacity_);
+}
+
+template <typename T, typename Lock>
+T *ArrayList<T, Lock>::allocate(size_t n) {
+  return n == 0 ? nullptr : std::allocator<T>().allocate(n);
+}
+
+template <typename T, typename Lock>
+void ArrayList<T, Lock>::deallocate(T *data, size_t n) {
+  if (data != nullptr) {
+    std::allocator<T>().deallocate(data, n);
+  }
+}
 
+template <typename T, typename Lock> void ArrayList<T, Lock>::destroy_all() {
+  if constexpr (!std::is_trivially_destructible<T>::value) {
     for (size_t i = 0; i < size_; ++i) {
-      new_data[i] = std::move(data_[i]);
+      data_[i].~T();
     }
+  }
+  size_ = 0;
+}
 
-    delete[] data_;
-    data_ = new_data;
-    capacity_ = new_capacity;
+// INFO: Moves the elements to new storage of exactly new_capacity
+template <typename T, typename Lock>
+void ArrayList<T, Lock>::grow_to(size_t new_capacity) {
+  T *new_data = allocate(new_capacity);
+  if constexpr (std::is_trivially_copyable<T>::value) {
+    if (size_ > 0) {
+      std::memcpy(static_cast<void *>(new_data), data_, size_ * sizeof(T));
+    }
+  } else {
+    for (size_t i = 0; i < size_; ++i) {
+      new (new_data + i) T(std::move_if_noexcept(data_[i]));
+      data_[i].~T();
+    }
   }
+
+  deallocate(data_, capacity_);
+  data_ = new_data;
+  capacity_ = new_capacity;
 }
 
-template <typename T> void ArrayList<T>::copy_from(const ArrayList &other) {
-  data_ = new T[other.capacity_];
-  size_ = other.size_;
-  capacity_ = other.capacity_;
-  for (size_t i = 0; i < size_; ++i) {
-    data_[i] = other.data_[i];
+template <typename T, typename Lock>
+void ArrayList<T, Lock>::copy_from(const ArrayList &other) {
+  data_ = allocate(other.size_);
+  size_ = 0;
+  capacity_ = other.size_;
+  if constexpr (std::is_trivially_copyable<T>::value) {
+    if (other.size_ > 0) {
+      std::memcpy(static_cast<void *>(data_), other.data_,
+                  other.size_ * sizeof(T));
+    }
+    size_ = other.size_;
+  } else {
+    // NOTE: No destructor runs for a half built copy, so undo it here
+    try {
+      for (; size_ < other.size_; ++size_) {
+        new (data_ + size_) T(other.data_[size_]);
+      }
+    } catch (...) {
+      destroy_all();
+      deallocate(data_, capacity_);
+      data_ = nullptr;
+      capacity_ = 0;
+      throw;
+    }
   }
 }
 
-template <typename T> void ArrayList<T>::move_from(ArrayList &&other) {
+template <typename T, typename Lock>
+void ArrayList<T, Lock>::move_from(ArrayList &&other) {
   data_ = other.data_;
   size_ = other.size_;
   capacity_ = other.capacity_;
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// NOTE: Little helpers for the binary index/run formats. Values are written
+// in host byte order, like the rest of the index file.
+
+template <typename T> void write_value(std::ostream &out, const T &value) {
+  static_assert(std::is_trivially_copyable<T>::value, "POD values only");
+  out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T> void append_value(std::string &out, const T &value) {
+  static_assert(std::is_trivially_copyable<T>::value, "POD values only");
+  out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+// NOTE: Copies the file at path onto the end of out a fixed-size chunk at a
+// time, for sections staged in a temporary file while the rest is written
+inline void append_file(std::ostream &out, const std::string &path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in.is_open()) {
+    throw std::runtime_error("Unable to open temporary file " + path);
+  }
+  char chunk[1 << 16];
+  while (in.read(chunk, sizeof(chunk)) || in.gcount() > 0) {
+    out.write(chunk, in.gcount());
+  }
+}
+
+// INFO: LEB128 - 7 bits per byte, high bit set on all but the last byte
+inline void append_varint(std::string &out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<char>(value));
+}
+
+// NOTE: Bounds-checked reads from a byte span (e.g. a MappedFile)
+class ByteReader {
+public:
+  ByteReader(const char *data, size_t size) : pos_(data), end_(data + size) {}
+
+  template <typename T> T read() {
+    static_assert(std::is_trivially_copyable<T>::value, "POD values only");
+    require(sizeof(T));
+    T value;
+    std::memcpy(&value, pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return value;
+  }
+
+  std::string_view read_bytes(size_t length) {
+    require(length);
+    std::string_view bytes(pos_, length);
+    pos_ += length;
+    return bytes;
+  }
+
+  uint64_t read_varint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      require(1);
+      uint8_t byte = static_cast<uint8_t>(*pos_++);
+      value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) {
+        return value;
+      }
+    }
+    throw std::runtime_error("Malformed varint");
+  }
+
+  const char *position() const { return pos_; }
+  size_t remaining() const { return static_cast<size_t>(end_ - pos_); }
+  bool done() const { return pos_ == end_; }
+
+private:
+  const char *pos_;
+  const char *end_;
+
+  void require(size_t length) const {
+    if (static_cast<size_t>(end_ - pos_) < length) {
+      throw std::runtime_error("Index file is truncated");
+    }
+  }
+};
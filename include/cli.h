@@ -2,6 +2,7 @@
 
 #include "array_list.hpp"
 #include "hashmap.hpp"
+#include <cstddef>
 #include <functional>
 #include <string>
 
@@ -11,6 +12,18 @@ struct Cmd {
   std::function<void(ArrayList<std::string>)> fn;
 };
 
+// INFO: Value following "--name" in args, or fallback when the flag is absent
+std::string get_option(const ArrayList<std::string> &args,
+                       const std::string &name,
+                       const std::string &fallback = "");
+
+// INFO: Parse a byte size such as "512M", "2G" or "65536". Throws
+// std::invalid_argument for a sign, a bad suffix or a size past SIZE_MAX.
+size_t parse_size(const std::string &text);
+
+// INFO: Args that are neither a "--flag" nor the value following one
+ArrayList<std::string> positional_args(const ArrayList<std::string> &args);
+
 class CLI {
 public:
   CLI(std::string name, int argc, char *argv[]);
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "hashmap.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+
+// NOTE: A HashMap that many threads may read and write at once. Keys are
+// striped over shards by the top bits of their hash (HashMap itself uses the
+// low bits), and every shard has its own reader/writer lock, so readers never
+// block each other and a writer only blocks the one shard it touches.
+//
+// No reference into the map ever escapes a lock: lookups copy the value out
+// or run a callback while the shard is held. Callbacks must not call back
+// into the same map.
+template <typename K, typename V, typename Hash = HashPolicy<K>>
+class ConcurrentHashMap {
+private:
+  // NOTE: One cache line per lock, so threads on neighbouring shards do not
+  // invalidate each other's lock word
+  struct alignas(64) Shard {
+    mutable std::shared_mutex mutex;
+    HashMap<K, V, Hash> map;
+  };
+
+  Shard *shards;
+  size_t numShards;
+  int shardShift;
+
+  template <typename Q> Shard &shardFor(const Q &key) const {
+    uint64_t hash = Hash{}(key);
+    return shards[shardShift == 64 ? 0 : hash >> shardShift];
+  }
+
+public:
+  static constexpr size_t DEFAULT_SHARDS = 64;
+
+  // INFO: shardCount is rounded up to a power of two
+  explicit ConcurrentHashMap(size_t shardCount = DEFAULT_SHARDS)
+      : numShards(1), shardShift(64) {
+    while (numShards < shardCount) {
+      numShards *= 2;
+      shardShift--;
+    }
+    shards = new Shard[numShards];
+  }
+
+  ~ConcurrentHashMap() { delete[] shards; }
+
+  ConcurrentHashMap(const ConcurrentHashMap &) = delete;
+  ConcurrentHashMap &operator=(const ConcurrentHashMap &) = delete;
+
+  size_t shard_count() const { return numShards; }
+
+  // INFO: Inserts or overwrites
+  void insert(const K &key, const V &value) {
+    Shard &shard = shardFor(key);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    shard.map.insert_or_assign(key, value);
+  }
+
+  // INFO: Inserts V(args...) unless the key is present, returns whether it did
+  template <typename KK, typename... Args>
+  bool try_emplace(KK &&key, Args &&...args) {
+    Shard &shard = shardFor(key);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    return shard.map
+        .try_emplace(std::forward<KK>(key), std::forward<Args>(args)...)
+        .second;
+  }
+
+  // NOTE: Read-modify-write under the shard's lock, inserting V() first when
+  // the key is new. e.g. appending a posting to a term's Frequency.
+  template <typename KK, typename F> void update(KK &&key, F f) {
+    Shard &shard = shardFor(key);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    f(shard.map.try_emplace(std::forward<KK>(key)).first->value);
+  }
+
+  // INFO: Copies the value into out, false when the key is missing
+  template <typename Q> bool find(const Q &key, V &out) const {
+    return visit(key, [&](const V &value) { out = value; });
+  }
+
+  template <typename Q> bool contains(const Q &key) const {
+    return visit(key, [](const V &) {});
+  }
+
+  // INFO: Calls f(const V &) under a shared lock, false when the key is
+  // missing
+  template <typename Q, typename F> bool visit(const Q &key, F f) const {
+    Shard &shard = shardFor(key);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.map.find(key);
+    if (it == shard.map.end()) {
+      return false;
+    }
+    f(static_cast<const V &>(it->value));
+    return true;
+  }
+
+  template <typename Q> bool erase(const Q &key) {
+    Shard &shard = shardFor(key);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    return shard.map.erase(key);
+  }
+
+  // NOTE: Shard by shard, so concurrent writers may land on either side of
+  // the count
+  size_t size() const {
+    size_t total = 0;
+    for (size_t i = 0; i < numShards; i++) {
+      std::shared_lock<std::shared_mutex> lock(shards[i].mutex);
+      total += shards[i].map.size();
+    }
+    return total;
+  }
+
+  bool empty() const { return size() == 0; }
+
+  void clear() {
+    for (size_t i = 0; i < numShards; i++) {
+      std::unique_lock<std::shared_mutex> lock(shards[i].mutex);
+      shards[i].map.clear();
+    }
+  }
+
+  // INFO: Calls f(const K &, const V &) for every entry, holding one shard's
+  // shared lock at a time
+  template <typename F> void for_each(F f) const {
+    for (size_t i = 0; i < numShards; i++) {
+      std::shared_lock<std::shared_mutex> lock(shards[i].mutex);
+      for (auto &pair : shards[i].map) {
+        f(static_cast<const K &>(pair.key), static_cast<const V &>(pair.value));
+      }
+    }
+  }
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// NOTE: A compressed set of doc IDs in the Roaring style. IDs are split by
+// their high 16 bits into chunks of 65536, and each chunk is stored in the
+// container that suits it:
+//
+//   array:  sorted low 16 bits, for sparse chunks (at most 4096 IDs)
+//   bitmap: 1024 64-bit words, for dense chunks
+//   run:    (start, length - 1) pairs, for stretches of consecutive IDs such
+//           as a term that is in almost every document
+//
+// AND, OR and ANDNOT go chunk by chunk. Bitmaps are combined two words per
+// SSE2 instruction, arrays are merged or probed against the other side, and
+// a chunk that is one full run short-circuits the operation.
+class DocBitmap {
+public:
+  // INFO: Fastest when docs are ascending and past every doc already added,
+  // as they are in each decoded postings block
+  void add_many(const uint32_t *docs, size_t count);
+  void add(uint32_t doc);
+
+  bool contains(uint32_t doc) const;
+  size_t cardinality() const;
+  bool empty() const { return containers_.empty(); }
+  void clear() { containers_.clear(); }
+
+  // INFO: Moves each chunk to its smallest container, call once built
+  void run_optimize();
+
+  DocBitmap intersect(const DocBitmap &other) const;  // NOTE: AND
+  DocBitmap unite(const DocBitmap &other) const;      // NOTE: OR
+  DocBitmap difference(const DocBitmap &other) const; // NOTE: ANDNOT
+
+  // INFO: Heap and container bytes, for comparing representations
+  size_t size_in_bytes() const;
+
+  // INFO: Calls f(doc) for every doc in ascending order
+  template <typename F> void for_each(F f) const;
+
+private:
+  enum class Kind : uint8_t { Array, Bitmap, Run };
+
+  static constexpr size_t CHUNK_BITS = 65536;
+  static constexpr size_t WORDS = CHUNK_BITS / 64;
+  static constexpr size_t MAX_ARRAY = 4096; // INFO: Where bitmaps get smaller
+
+  struct Container {
+    uint16_t key; // INFO: High 16 bits of every doc in the chunk
+    Kind kind;
+    uint32_t cardinality;
+    std::vector<uint16_t> values; // INFO: Array values or run pairs
+    std::vector<uint64_t> words;  // INFO: Bitmap words
+
+    bool full() const {
+      return kind == Kind::Run && cardinality == CHUNK_BITS;
+    }
+  };
+
+  std::vector<Container> containers_;
+
+  static int trailing_zeros(uint64_t word) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(word);
+#endif
+  }
+
+  Container &container_for(uint16_t key);
+  static void add_low(Container &container, uint16_t low);
+  static bool contains_low(const Container &container, uint16_t low);
+  static void to_words(const Container &container, uint64_t *words);
+  static Container from_words(uint16_t key, std::vector<uint64_t> &&words);
+  static Container from_array(uint16_t key, std::vector<uint16_t> &&values);
+  static Container filter(const Container &array, const Container &other,
+                          bool keep_present);
+  static Container intersect(const Container &a, const Container &b);
+  static Container unite(const Container &a, const Container &b);
+  static Container difference(const Container &a, const Container &b);
+};
+
+template <typename F> void DocBitmap::for_each(F f) const {
+  for (const Container &container : containers_) {
+    uint32_t high = static_cast<uint32_t>(container.key) << 16;
+    if (container.kind == Kind::Array) {
+      for (uint16_t low : container.values) {
+        f(high | low);
+      }
+    } else if (container.kind == Kind::Run) {
+      for (size_t i = 0; i < container.values.size(); i += 2) {
+        uint32_t start = container.values[i];
+        uint32_t last = start + container.values[i + 1];
+        for (uint32_t low = start; low <= last; low++) {
+          f(high | low);
+        }
+      }
+    } else {
+      for (size_t i = 0; i < WORDS; i++) {
+        for (uint64_t word = container.words[i]; word != 0;
+             word &= word - 1) {
+          f(high | static_cast<uint32_t>(i * 64 + trailing_zeros(word)));
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "array_list.hpp"
+#include "levenshtein.h"
+#include "mapped_file.h"
+#include "trie.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// NOTE: clouseau.ac layout (all integers host byte order)
+//
+//   header: "CLAC", uint32 version, uint32 num_nodes, uint32 num_words,
+//           uint64 labels offset
+//   nodes:  num_nodes records of FLAT_TRIE_NODE_SIZE bytes in breadth-first
+//           order, so a node's children are contiguous and sorted by first
+//           byte. Node 0 is the root. Each record: uint32 label offset,
+//           uint32 first child, uint32 score, uint32 max score, uint16 label
+//           length, uint16 children, uint8 first label byte, uint8 is word,
+//           2 bytes padding
+//   labels: every node's edge label, back to back
+//
+// It is the radix Trie laid out flat, so it is written once by `index` and
+// mapped by `autocomplete` without building anything.
+inline constexpr char FLAT_TRIE_MAGIC[4] = {'C', 'L', 'A', 'C'};
+inline constexpr uint32_t FLAT_TRIE_VERSION = 1;
+inline constexpr size_t FLAT_TRIE_HEADER_SIZE = 4 + 3 * 4 + 8;
+inline constexpr size_t FLAT_TRIE_NODE_SIZE = 24;
+
+// INFO: A word of a sorted vocabulary and its score, see FlatTrie::write
+struct ScoredWord {
+  std::string_view word;
+  uint32_t score;
+};
+
+// NOTE: Read-only, mapped autocomplete trie. Opening only checks the header;
+// a query touches the nodes on its path and the ones it ranks.
+class FlatTrie {
+public:
+  explicit FlatTrie(const std::string &path);
+
+  // INFO: Writes trie to path in the layout above. The file is written
+  // beside path and renamed over it, so existing mappings stay whole.
+  static void write(const Trie &trie, const std::string &path);
+
+  // NOTE: Writes the same file for num_words sorted, distinct words without
+  // building a Trie: one pass over the words per level, with each level's
+  // nodes and the labels staged on disk, so memory stays flat however large
+  // the vocabulary. word_at(i) is the i-th word; its view only has to last
+  // until the next call.
+  static void write(size_t num_words,
+                    const std::function<ScoredWord(size_t)> &word_at,
+                    const std::string &path);
+
+  size_t num_nodes() const { return num_nodes_; }
+  size_t num_words() const { return num_words_; }
+
+  // NOTE: Same results as Trie::search and Trie::top_k
+  ArrayList<std::string> search(const std::string &prefix) const;
+  ArrayList<Completion> top_k(const std::string &prefix, size_t k) const;
+
+  // NOTE: Typo tolerant top_k: the k best completions of any prefix within
+  // max_edits (at most 2) of prefix, fewest edits first, then best score.
+  // The trie is walked with a LevenshteinAutomaton, so only branches that
+  // can still come back within max_edits are visited. Queries longer than
+  // LevenshteinAutomaton::MAX_LENGTH only match exactly.
+  ArrayList<Completion> fuzzy_top_k(const std::string &prefix, size_t k,
+                                    uint8_t max_edits) const;
+
+  // INFO: Up to k words within max_edits of word, fewest edits first, then
+  // best score
+  ArrayList<Completion> fuzzy_find(const std::string &word, size_t k,
+                                   uint8_t max_edits) const;
+
+private:
+  struct Node {
+    uint32_t label;
+    uint32_t first_child;
+    uint32_t score;
+    uint32_t max_score;
+    uint16_t label_length;
+    uint16_t children;
+    uint8_t first;
+    uint8_t is_word;
+  };
+
+  MappedFile file_;
+  const char *nodes_;
+  const char *labels_;
+  size_t labels_size_;
+  uint32_t num_nodes_;
+  uint32_t num_words_;
+
+  Node node(uint32_t index) const;
+  std::string_view label(const Node &node) const;
+  // INFO: Child of node whose label starts with c, false if none
+  bool child(const Node &node, unsigned char c, uint32_t &index) const;
+  bool find_prefix(const std::string &prefix, uint32_t &index,
+                   std::string &path) const;
+  void collect_all_words(uint32_t index, std::string &word,
+                         ArrayList<std::string> &results) const;
+
+  // INFO: A node reached by the automaton walk, and its distance
+  struct FuzzyMatch {
+    uint32_t node;
+    uint8_t distance;
+    std::string path;
+  };
+
+  // INFO: Depth first below index, where the automaton is in state. Prefix
+  // walks report nodes under which every word completes a prefix within
+  // bound (only ones closer than the covered distance of an ancestor), word
+  // walks report words within bound.
+  void fuzzy_walk(const LevenshteinAutomaton &automaton, uint32_t index,
+                  const LevenshteinAutomaton::State &state, std::string &path,
+                  uint8_t covered, bool prefix,
+                  std::vector<FuzzyMatch> &matches) const;
+};
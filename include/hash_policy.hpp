@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+// NOTE: 64-bit hashing for HashMap. Strings use a wyhash-style hash (reads 8
+// bytes at a time, one 64x64->128 multiply per 16 bytes), integral keys a
+// single multiply-fold. Not cryptographic.
+
+namespace hash_detail {
+
+// INFO: 128-bit product of a and b, low half left in a and high half in b
+inline void multiply_wide(uint64_t &a, uint64_t &b) {
+#if defined(__SIZEOF_INT128__)
+  __uint128_t product = static_cast<__uint128_t>(a) * b;
+  a = static_cast<uint64_t>(product);
+  b = static_cast<uint64_t>(product >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+  a = _umul128(a, b, &b);
+#else
+  uint64_t a_lo = a & 0xffffffff, a_hi = a >> 32;
+  uint64_t b_lo = b & 0xffffffff, b_hi = b >> 32;
+  uint64_t lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo;
+  uint64_t lo_hi = a_lo * b_hi, hi_hi = a_hi * b_hi;
+  uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xffffffff) + lo_hi;
+  a = (cross << 32) | (lo_lo & 0xffffffff);
+  b = hi_hi + (hi_lo >> 32) + (cross >> 32);
+#endif
+}
+
+inline uint64_t multiply_fold(uint64_t a, uint64_t b) {
+  multiply_wide(a, b);
+  return a ^ b;
+}
+
+constexpr uint64_t SECRET[4] = {0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL,
+                                0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL};
+
+inline uint64_t read64(const unsigned char *p) {
+  uint64_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline uint64_t read32(const unsigned char *p) {
+  uint32_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+// INFO: 1-3 bytes, first/middle/last so every byte counts
+inline uint64_t read_small(const unsigned char *p, size_t length) {
+  return (static_cast<uint64_t>(p[0]) << 16) |
+         (static_cast<uint64_t>(p[length >> 1]) << 8) | p[length - 1];
+}
+
+} // namespace hash_detail
+
+inline uint64_t hash_bytes(const void *data, size_t length,
+                           uint64_t seed = 0) {
+  using namespace hash_detail;
+  const unsigned char *p = static_cast<const unsigned char *>(data);
+  seed ^= multiply_fold(seed ^ SECRET[0], SECRET[1]);
+
+  uint64_t a, b;
+  if (length <= 16) {
+    // NOTE: Most index terms land here - two overlapping 4-byte reads from
+    // each end cover 4 to 16 bytes without a loop
+    if (length >= 4) {
+      size_t middle = (length >> 3) << 2;
+      a = (read32(p) << 32) | read32(p + middle);
+      b = (read32(p + length - 4) << 32) | read32(p + length - 4 - middle);
+    } else if (length > 0) {
+      a = read_small(p, length);
+      b = 0;
+    } else {
+      a = b = 0;
+    }
+  } else {
+    size_t i = length;
+    if (i > 48) {
+      uint64_t seed1 = seed, seed2 = seed;
+      do {
+        seed = multiply_fold(read64(p) ^ SECRET[1], read64(p + 8) ^ seed);
+        seed1 = multiply_fold(read64(p + 16) ^ SECRET[2], read64(p + 24) ^ seed1);
+        seed2 = multiply_fold(read64(p + 32) ^ SECRET[3], read64(p + 40) ^ seed2);
+        p += 48;
+        i -= 48;
+      } while (i > 48);
+      seed ^= seed1 ^ seed2;
+    }
+    while (i > 16) {
+      seed = multiply_fold(read64(p) ^ SECRET[1], read64(p + 8) ^ seed);
+      i -= 16;
+      p += 16;
+    }
+    a = read64(p + i - 16);
+    b = read64(p + i - 8);
+  }
+
+  a ^= SECRET[1];
+  b ^= seed;
+  multiply_wide(a, b);
+  return multiply_fold(a ^ SECRET[0] ^ length, b ^ SECRET[1]);
+}
+
+// INFO: Spread an integer's bits over the whole word
+inline uint64_t hash_integer(uint64_t value) {
+  using namespace hash_detail;
+  return multiply_fold(value ^ SECRET[0], SECRET[1]);
+}
+
+// NOTE: Default policy - std::hash, mixed so the low bits are usable
+template <typename K, typename Enable = void> struct HashPolicy {
+  uint64_t operator()(const K &key) const {
+    return hash_integer(static_cast<uint64_t>(std::hash<K>{}(key)));
+  }
+};
+
+template <typename K>
+struct HashPolicy<
+    K, typename std::enable_if<std::is_integral<K>::value ||
+                               std::is_enum<K>::value>::type> {
+  uint64_t operator()(K key) const {
+    return hash_integer(static_cast<uint64_t>(key));
+  }
+};
+
+// NOTE: is_transparent lets HashMap<std::string, V>::find take a
+// std::string_view or a literal without building a std::string
+template <> struct HashPolicy<std::string> {
+  using is_transparent = void;
+
+  uint64_t operator()(std::string_view key) const {
+    return hash_bytes(key.data(), key.size());
+  }
+};
+
+template <> struct HashPolicy<std::string_view> {
+  using is_transparent = void;
+
+  uint64_t operator()(std::string_view key) const {
+    return hash_bytes(key.data(), key.size());
+  }
+};
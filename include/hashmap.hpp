@@ -1,190 +1,652 @@
 #pragma once
 
-#include <sstream>
+#include <cstddef>
+#include <cstdint>
+#include "hash_policy.hpp"
+#include "hashmap_stats.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <new>
 #include <stdexcept>
-#include <string>
-
-template <typename K, typename V> class HashMap {
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HASHMAP_SSE2 1
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// NOTE: Open addressing in the SwissTable style. Every slot has one control
+// byte (empty, deleted, or 7 bits of the key's hash) kept apart from the
+// keys, so a probe checks a group of 16 slots with a couple of SSE2
+// instructions and only compares keys on a likely match. Slots hold indices
+// into a dense array of entries, which keeps iteration in insertion order and
+// means growing the table never moves a key. Hash is a policy (see
+// hash_policy.hpp) returning 64 well mixed bits.
+//
+// Sizes are size_t, so the table itself may pass 2^31 slots; a slot stores a
+// 32-bit entry index, which caps the map at 2^32 - 1 keys. Stats is a policy
+// from hashmap_stats.hpp, off by default.
+template <typename K, typename V, typename Hash = HashPolicy<K>,
+          typename Stats = NoHashMapStats>
+class HashMap : private Stats {
 private:
+  template <typename, typename, typename> friend class ShardedHashMap;
+
   struct Node {
     K key;
     V value;
-    bool isOccupied;
-    bool isDeleted;
+    uint64_t hash; // INFO: Cached so growing never rehashes a key
 
-    Node() : isOccupied(false), isDeleted(false) {}
-    Node(const K &k, const V &v)
-        : key(k), value(v), isOccupied(true), isDeleted(false) {}
+    template <typename KK, typename... Args>
+    Node(uint64_t hash, KK &&key, Args &&...args)
+        : key(std::forward<KK>(key)), value(std::forward<Args>(args)...),
+          hash(hash) {}
   };
 
-  Node *buckets;
-  int capacity;
-  int numElements;
-  static constexpr float MAX_LOAD_FACTOR = 0.7f;
-  static constexpr int INITIAL_CAPACITY = 64;
+  static constexpr int GROUP_WIDTH = 16;
+  static constexpr int8_t EMPTY = -128;
+  static constexpr int8_t DELETED = -2;
 
-  int hashFunction(const K &key) const {
-    std::stringstream ss;
-    ss << key;
-    std::string str = ss.str();
+  // NOTE: Control bytes sit next to their slots' entry indices, so a probe
+  // usually finds both in the same cache line
+  struct Group {
+    int8_t ctrl[GROUP_WIDTH];
+    uint32_t slots[GROUP_WIDTH];
+  };
 
-    // INFO: DJB2 algorith (http://www.cse.yorku.ca/~oz/hash.html)
-    unsigned long hash = 5381;
-    for (char c : str) {
-      hash = ((hash << 5) + hash) + c;
-    }
+  Group *groups;  // INFO: capacity / GROUP_WIDTH groups
+  Node *entries;  // INFO: numElements live entries, insertion order, then
+                  // unconstructed storage up to entryCapacity
+  size_t capacity;
+  size_t numElements;
+  size_t numDeleted; // INFO: DELETED control bytes, they lengthen probes too
+  size_t entryCapacity;
+  static constexpr size_t INITIAL_CAPACITY = GROUP_WIDTH;
+  static constexpr size_t MAX_ENTRIES = UINT32_MAX;
+  static constexpr size_t NOT_FOUND = SIZE_MAX;
+
+  // NOTE: 7/8 load factor, in integers so it stays exact for huge tables
+  static size_t maxLoad(size_t slots) { return slots - slots / 8; }
+
+  // NOTE: Low 7 bits become the control byte, the rest pick the group
+  template <typename Q> uint64_t hashFunction(const Q &key) const {
+    return Hash{}(key);
+  }
+
+  template <typename H, typename = void>
+  struct IsTransparent : std::false_type {};
+  template <typename H>
+  struct IsTransparent<H, std::void_t<typename H::is_transparent>>
+      : std::true_type {};
+
+  // INFO: Enables the heterogeneous overloads when the policy allows them
+  template <typename Q, typename H>
+  using IfTransparent = typename std::enable_if<
+      IsTransparent<H>::value && !std::is_same<Q, K>::value>::type;
+
+  static int8_t fragment(uint64_t hash) {
+    return static_cast<int8_t>(hash & 0x7f);
+  }
 
-    return hash;
+  static int countTrailingZeros(uint32_t bits) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, bits);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(bits);
+#endif
   }
 
-  int probe(int hash, int i) const {
-    return (hash + (i + i * i) / 2) & (capacity - 1);
+  static void prefetch(const void *address) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address);
+#elif defined(HASHMAP_SSE2)
+    _mm_prefetch(static_cast<const char *>(address), _MM_HINT_T0);
+#else
+    (void)address;
+#endif
   }
 
-  void growIfNeeded() {
-    if (static_cast<float>(numElements) / capacity >= MAX_LOAD_FACTOR) {
-      resize(capacity * 2);
+  // INFO: Bit i set when control byte i of the group equals value
+  static uint32_t matchByte(const int8_t *group, int8_t value) {
+#ifdef HASHMAP_SSE2
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(group));
+    return static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(value))));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < GROUP_WIDTH; i++) {
+      mask |= static_cast<uint32_t>(group[i] == value) << i;
     }
+    return mask;
+#endif
   }
 
-  void resize(int newCapacity) {
-    Node *oldBuckets = buckets;
-    int oldCapacity = capacity;
+  // INFO: Empty and deleted are the only negative control bytes
+  static uint32_t matchFree(const int8_t *group) {
+#ifdef HASHMAP_SSE2
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(group));
+    return static_cast<uint32_t>(_mm_movemask_epi8(bytes));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < GROUP_WIDTH; i++) {
+      mask |= static_cast<uint32_t>(group[i] < 0) << i;
+    }
+    return mask;
+#endif
+  }
 
-    buckets = new Node[newCapacity];
-    capacity = newCapacity;
-    numElements = 0;
+  int8_t &ctrlAt(size_t slot) const {
+    return groups[slot / GROUP_WIDTH].ctrl[slot % GROUP_WIDTH];
+  }
 
-    for (int i = 0; i < oldCapacity; i++) {
-      if (oldBuckets[i].isOccupied && !oldBuckets[i].isDeleted) {
-        insert(oldBuckets[i].key, oldBuckets[i].value);
+  uint32_t &slotAt(size_t slot) const {
+    return groups[slot / GROUP_WIDTH].slots[slot % GROUP_WIDTH];
+  }
+
+  // NOTE: Triangular probing over whole groups, visits every group once
+  // because the group count is a power of two. visit gets the group and the
+  // slot number of its first slot.
+  template <typename Visit> size_t probe(uint64_t hash, Visit visit) const {
+    size_t mask = capacity / GROUP_WIDTH - 1;
+    size_t group = static_cast<size_t>(hash >> 7) & mask;
+    for (size_t i = 0; i <= mask; i++) {
+      group = (group + i) & mask;
+      size_t slot = visit(groups[group], group * GROUP_WIDTH);
+      if (slot != NOT_FOUND) {
+        return slot;
       }
     }
+    return NOT_FOUND;
+  }
 
-    delete[] oldBuckets;
+  // INFO: Slot holding key, or NOT_FOUND. When freeSlot is given it gets
+  // the first empty or deleted slot seen, which is where findFreeSlot would
+  // put the key, or NOT_FOUND if the probe passed none.
+  template <typename Q>
+  size_t findSlot(const Q &key, uint64_t hash,
+                  size_t *freeSlot = nullptr) const {
+    int8_t h2 = fragment(hash);
+    size_t found = NOT_FOUND;
+    uint64_t groupsVisited = 0, compares = 0;
+    probe(hash, [&](const Group &group, size_t base) {
+      if constexpr (Stats::ENABLED) {
+        groupsVisited++;
+      }
+      for (uint32_t m = matchByte(group.ctrl, h2); m != 0; m &= m - 1) {
+        int i = countTrailingZeros(m);
+        if constexpr (Stats::ENABLED) {
+          compares++;
+        }
+        if (entries[group.slots[i]].key == key) {
+          found = base + i;
+          return found;
+        }
+      }
+      if (freeSlot != nullptr && *freeSlot == NOT_FOUND) {
+        uint32_t m = matchFree(group.ctrl);
+        if (m != 0) {
+          *freeSlot = base + countTrailingZeros(m);
+        }
+      }
+      // NOTE: An empty slot means the key was never pushed past this group
+      return matchByte(group.ctrl, EMPTY) != 0 ? base : NOT_FOUND;
+    });
+    if constexpr (Stats::ENABLED) {
+      this->record_lookup(groupsVisited, compares, found != NOT_FOUND);
+    }
+    return found;
   }
 
-public:
-  HashMap() : capacity(INITIAL_CAPACITY), numElements(0) {
-    buckets = new Node[capacity];
+  // INFO: First empty or deleted slot on the key's probe sequence
+  size_t findFreeSlot(uint64_t hash) const {
+    size_t slot = probe(hash, [&](const Group &group, size_t base) {
+      uint32_t m = matchFree(group.ctrl);
+      return m != 0 ? base + countTrailingZeros(m) : NOT_FOUND;
+    });
+    if (slot == NOT_FOUND) {
+      throw std::runtime_error("HashMap is full");
+    }
+    return slot;
   }
 
-  ~HashMap() { delete[] buckets; }
+  // INFO: Slot pointing at entry index, found by probing with its hash
+  size_t slotOfEntry(size_t index) const {
+    const Node &node = entries[index];
+    int8_t h2 = fragment(node.hash);
+    size_t found = NOT_FOUND;
+    probe(node.hash, [&](const Group &group, size_t base) {
+      for (uint32_t m = matchByte(group.ctrl, h2); m != 0; m &= m - 1) {
+        int i = countTrailingZeros(m);
+        if (group.slots[i] == static_cast<uint32_t>(index)) {
+          found = base + i;
+          return found;
+        }
+      }
+      return NOT_FOUND;
+    });
+    return found;
+  }
 
-  void insert(const K &key, const V &value) {
-    growIfNeeded();
+  // NOTE: Tombstones count against the load factor, otherwise churn could
+  // leave no empty slot to end a probe. When they outnumber the live keys
+  // the table is rebuilt at the same size instead of doubled. Returns
+  // whether it rehashed.
+  bool growIfNeeded() {
+    if (capacity == 0) {
+      rehash(INITIAL_CAPACITY);
+    } else if (numElements + numDeleted + 1 > maxLoad(capacity)) {
+      rehash(numDeleted >= numElements ? capacity : capacity * 2);
+    } else {
+      return false;
+    }
+    return true;
+  }
 
-    int hash = hashFunction(key);
-    int i = 0;
-    int index;
-    int firstDeleted = capacity;
+  // NOTE: Only the control bytes and slot indices are rebuilt, entries stay
+  // where they are. At the same capacity the groups are reused in place.
+  void rehash(size_t newCapacity) {
+    std::chrono::steady_clock::time_point start;
+    if constexpr (Stats::ENABLED) {
+      start = std::chrono::steady_clock::now();
+    }
+    bool inPlace = newCapacity == capacity;
+
+    if (inPlace) {
+      clearControl();
+    } else {
+      delete[] groups;
+      capacity = newCapacity;
+      groups = allocateGroups(capacity);
+    }
+    numDeleted = 0;
 
-    do {
-      index = probe(hash, i++);
+    for (size_t i = 0; i < numElements; i++) {
+      size_t slot = findFreeSlot(entries[i].hash);
+      ctrlAt(slot) = fragment(entries[i].hash);
+      slotAt(slot) = static_cast<uint32_t>(i);
+    }
 
-      if (!buckets[index].isOccupied) {
-        if (firstDeleted != capacity) {
-          index = firstDeleted;
-        }
-        buckets[index] = Node(key, value);
-        numElements++;
-        return;
-      } else if (buckets[index].isDeleted && firstDeleted == capacity) {
-        firstDeleted = index;
-      } else if (!buckets[index].isDeleted && buckets[index].key == key) {
-        buckets[index].value = value;
-        return;
-      }
-    } while (i < capacity);
+    if constexpr (Stats::ENABLED) {
+      this->record_resize(
+          inPlace, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+                       .count());
+    }
+  }
 
-    throw std::runtime_error("HashMap is full");
+  void clearControl() {
+    for (size_t g = 0; g < capacity / GROUP_WIDTH; g++) {
+      std::memset(groups[g].ctrl, EMPTY, GROUP_WIDTH);
+    }
   }
 
-  V &operator[](const K &key) {
-    growIfNeeded();
+  // INFO: All slots empty
+  static Group *allocateGroups(size_t capacity) {
+    Group *groups = new Group[capacity / GROUP_WIDTH];
+    for (size_t g = 0; g < capacity / GROUP_WIDTH; g++) {
+      std::memset(groups[g].ctrl, EMPTY, GROUP_WIDTH);
+    }
+    return groups;
+  }
 
-    int hash = hashFunction(key);
-    int i = 0;
-    int index;
-    int firstDeleted = capacity;
+  static Node *allocateEntries(size_t n) {
+    return n == 0 ? nullptr : std::allocator<Node>().allocate(n);
+  }
 
-    do {
-      index = probe(hash, i++);
+  static void deallocateEntries(Node *entries, size_t n) {
+    if (entries != nullptr) {
+      std::allocator<Node>().deallocate(entries, n);
+    }
+  }
 
-      if (!buckets[index].isOccupied) {
-        if (firstDeleted != capacity) {
-          index = firstDeleted;
-        }
-        buckets[index] = Node(key, V());
-        numElements++;
-        return buckets[index].value;
-      } else if (buckets[index].isDeleted && firstDeleted == capacity) {
-        firstDeleted = index;
-      } else if (!buckets[index].isDeleted && buckets[index].key == key) {
-        return buckets[index].value;
+  // INFO: Destroys entries [from, numElements), the storage is kept
+  void destroyEntries(size_t from) {
+    if constexpr (!std::is_trivially_destructible<Node>::value) {
+      for (size_t i = from; i < numElements; i++) {
+        entries[i].~Node();
       }
-    } while (i < capacity);
+    }
+  }
 
-    throw std::runtime_error("HashMap is full");
+  // NOTE: Entries grow like an ArrayList, independently of the slots: raw
+  // storage, so spare room never constructs a K or V, and live entries are
+  // relocated with one memcpy when they are trivially copyable
+  void reserveEntries(size_t count) {
+    if (count > entryCapacity) {
+      size_t newCapacity = grownEntryCapacity(count);
+      relocateEntries(allocateEntries(newCapacity), newCapacity);
+    }
   }
 
-  bool erase(const K &key) {
-    int hash = hashFunction(key);
-    int i = 0;
-    int index;
+  // INFO: Entry capacity for count entries, doubling the current one
+  size_t grownEntryCapacity(size_t count) const {
+    size_t newCapacity = entryCapacity == 0 ? 4 : entryCapacity * 2;
+    while (newCapacity < count) {
+      newCapacity *= 2;
+    }
+    return newCapacity;
+  }
 
-    do {
-      index = probe(hash, i++);
+  // INFO: Moves the live entries into newEntries, which the map then owns
+  void relocateEntries(Node *newEntries, size_t newCapacity) {
+    if constexpr (std::is_trivially_copyable<Node>::value) {
+      if (numElements > 0) {
+        std::memcpy(static_cast<void *>(newEntries), entries,
+                    numElements * sizeof(Node));
+      }
+    } else {
+      for (size_t i = 0; i < numElements; i++) {
+        new (newEntries + i) Node(std::move_if_noexcept(entries[i]));
+        entries[i].~Node();
+      }
+    }
+    deallocateEntries(entries, entryCapacity);
+    entries = newEntries;
+    entryCapacity = newCapacity;
+  }
 
-      if (!buckets[index].isOccupied) {
-        return false;
+  // INFO: Claim the free slot for a new entry, returns its entry index. The
+  // key and value are moved in when given as rvalues.
+  template <typename KK, typename... Args>
+  size_t place(size_t slot, uint64_t hash, KK &&key, Args &&...args) {
+    if (numElements == MAX_ENTRIES) {
+      throw std::runtime_error("HashMap is full");
+    }
+    if (numElements < entryCapacity) {
+      new (entries + numElements)
+          Node(hash, std::forward<KK>(key), std::forward<Args>(args)...);
+    } else {
+      // NOTE: key or args may refer to an entry of this map, so the new
+      // entry is built in the new storage before the old ones move out,
+      // as std::vector::emplace_back does
+      size_t newCapacity = grownEntryCapacity(numElements + 1);
+      Node *newEntries = allocateEntries(newCapacity);
+      try {
+        new (newEntries + numElements)
+            Node(hash, std::forward<KK>(key), std::forward<Args>(args)...);
+      } catch (...) {
+        deallocateEntries(newEntries, newCapacity);
+        throw;
       }
+      relocateEntries(newEntries, newCapacity);
+    }
+    size_t index = numElements++;
+    if (ctrlAt(slot) == DELETED) {
+      numDeleted--;
+    }
+    ctrlAt(slot) = fragment(hash);
+    slotAt(slot) = static_cast<uint32_t>(index);
+    return index;
+  }
 
-      if (!buckets[index].isDeleted && buckets[index].key == key) {
-        buckets[index].isDeleted = true; // Lazy deletion
-        numElements--;
-        return true;
+  // NOTE: One probe, which also notes the free slot for a new key, so a hit
+  // never grows the table and a miss only probes again when growing
+  // rehashed. args are only used (and only moved from) when the key is new.
+  // hash is hashFunction(key), taken as given so ShardedHashMap can reuse
+  // the hash it picked the shard with.
+  template <typename KK, typename... Args>
+  std::pair<size_t, bool> tryEmplaceImpl(uint64_t hash, KK &&key,
+                                         Args &&...args) {
+    size_t freeSlot = NOT_FOUND;
+    if (capacity > 0) {
+      size_t slot = findSlot(key, hash, &freeSlot);
+      if (slot != NOT_FOUND) {
+        return {slotAt(slot), false};
       }
-    } while (i < capacity);
+    }
+
+    if (growIfNeeded() || freeSlot == NOT_FOUND) {
+      freeSlot = findFreeSlot(hash);
+    }
+    size_t index = place(freeSlot, hash, std::forward<KK>(key),
+                         std::forward<Args>(args)...);
+    return {index, true};
+  }
 
-    return false;
+  // NOTE: A moved-from map has no groups, so neither does its copy, and
+  // growIfNeeded allocates them on the first insert
+  void copyFrom(const HashMap &other) {
+    capacity = other.capacity;
+    numDeleted = other.numDeleted;
+    groups = nullptr;
+    if (capacity > 0) {
+      groups = new Group[capacity / GROUP_WIDTH];
+      std::memcpy(groups, other.groups,
+                  (capacity / GROUP_WIDTH) * sizeof(Group));
+    }
+    entryCapacity = other.numElements;
+    entries = allocateEntries(entryCapacity);
+    numElements = 0;
+    if constexpr (std::is_trivially_copyable<Node>::value) {
+      if (other.numElements > 0) {
+        std::memcpy(static_cast<void *>(entries), other.entries,
+                    other.numElements * sizeof(Node));
+      }
+      numElements = other.numElements;
+    } else {
+      // NOTE: No destructor runs for a half built copy, so undo it here
+      try {
+        for (; numElements < other.numElements; numElements++) {
+          new (entries + numElements) Node(other.entries[numElements]);
+        }
+      } catch (...) {
+        release();
+        throw;
+      }
+    }
   }
 
-  int size() const { return numElements; }
+  void release() {
+    delete[] groups;
+    destroyEntries(0);
+    deallocateEntries(entries, entryCapacity);
+  }
+
+public:
+  HashMap()
+      : entries(nullptr), capacity(INITIAL_CAPACITY), numElements(0),
+        numDeleted(0), entryCapacity(0) {
+    groups = allocateGroups(capacity);
+  }
+
+  ~HashMap() { release(); }
+
+  // NOTE: Deep copy
+  HashMap(const HashMap &other) { copyFrom(other); }
+
+  // NOTE: Copy first, then swap, so a throwing copy leaves this map as it was
+  HashMap &operator=(const HashMap &other) {
+    if (this != &other) {
+      HashMap copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  // INFO: Swaps the contents, each map keeps its own stats
+  void swap(HashMap &other) noexcept {
+    std::swap(groups, other.groups);
+    std::swap(entries, other.entries);
+    std::swap(capacity, other.capacity);
+    std::swap(numElements, other.numElements);
+    std::swap(numDeleted, other.numDeleted);
+    std::swap(entryCapacity, other.entryCapacity);
+  }
+
+  // NOTE: Move leaves other as an empty map
+  HashMap(HashMap &&other) noexcept
+      : groups(other.groups), entries(other.entries),
+        capacity(other.capacity), numElements(other.numElements),
+        numDeleted(other.numDeleted), entryCapacity(other.entryCapacity) {
+    other.groups = nullptr;
+    other.entries = nullptr;
+    other.capacity = 0;
+    other.numElements = 0;
+    other.numDeleted = 0;
+    other.entryCapacity = 0;
+  }
+
+  HashMap &operator=(HashMap &&other) noexcept {
+    if (this != &other) {
+      release();
+      groups = other.groups;
+      entries = other.entries;
+      capacity = other.capacity;
+      numElements = other.numElements;
+      numDeleted = other.numDeleted;
+      entryCapacity = other.entryCapacity;
+      other.groups = nullptr;
+      other.entries = nullptr;
+      other.capacity = 0;
+      other.numElements = 0;
+      other.numDeleted = 0;
+      other.entryCapacity = 0;
+    }
+    return *this;
+  }
+
+  class Iterator;
+
+  // INFO: Inserts V(args...) unless key is already present, in which case
+  // nothing is constructed or moved. Returns the entry and whether it is new.
+  template <typename KK, typename... Args>
+  std::pair<Iterator, bool> try_emplace(KK &&key, Args &&...args) {
+    // NOTE: Keys of another type are probed as they are when the policy is
+    // transparent, e.g. a std::string_view only becomes a std::string on
+    // insert. Otherwise they are converted to K first.
+    if constexpr (std::is_same<typename std::decay<KK>::type, K>::value ||
+                  IsTransparent<Hash>::value) {
+      std::pair<size_t, bool> result =
+          tryEmplaceImpl(hashFunction(key), std::forward<KK>(key),
+                         std::forward<Args>(args)...);
+      return {Iterator(entries, result.first), result.second};
+    } else {
+      return try_emplace(K(std::forward<KK>(key)),
+                         std::forward<Args>(args)...);
+    }
+  }
+
+  // INFO: Same as try_emplace, for code written against std::unordered_map
+  template <typename KK, typename... Args>
+  std::pair<Iterator, bool> emplace(KK &&key, Args &&...args) {
+    return try_emplace(std::forward<KK>(key), std::forward<Args>(args)...);
+  }
+
+  // INFO: Inserts or overwrites, returns whether the key is new
+  template <typename KK, typename M>
+  std::pair<Iterator, bool> insert_or_assign(KK &&key, M &&value) {
+    std::pair<Iterator, bool> result =
+        try_emplace(std::forward<KK>(key), std::forward<M>(value));
+    if (!result.second) {
+      (*result.first).value = std::forward<M>(value);
+    }
+    return result;
+  }
+
+  void insert(const K &key, const V &value) { insert_or_assign(key, value); }
+
+  void insert(K &&key, V &&value) {
+    insert_or_assign(std::move(key), std::move(value));
+  }
+
+  V &operator[](const K &key) { return (*try_emplace(key).first).value; }
+
+  V &operator[](K &&key) { return (*try_emplace(std::move(key)).first).value; }
+
+  // NOTE: Sizes the table and entries for count keys, so inserting that many
+  // never grows or rehashes
+  void reserve(size_t count) {
+    size_t newCapacity = capacity == 0 ? INITIAL_CAPACITY : capacity;
+    while (count > maxLoad(newCapacity)) {
+      newCapacity *= 2;
+    }
+    if (newCapacity != capacity) {
+      rehash(newCapacity);
+    }
+    reserveEntries(count);
+  }
+
+  bool erase(const K &key) { return eraseImpl(key, hashFunction(key)); }
+
+  template <typename Q, typename H = Hash, typename = IfTransparent<Q, H>>
+  bool erase(const Q &key) {
+    return eraseImpl(key, hashFunction(key));
+  }
+
+private:
+  template <typename Q> bool eraseImpl(const Q &key, uint64_t hash) {
+    if (numElements == 0) {
+      return false;
+    }
+
+    size_t slot = findSlot(key, hash);
+    if (slot == NOT_FOUND) {
+      return false;
+    }
+
+    // NOTE: A group that still has an empty slot never overflowed, so no
+    // probe continues past it and the slot can go straight back to empty
+    const Group &group = groups[slot / GROUP_WIDTH];
+    if (matchByte(group.ctrl, EMPTY) != 0) {
+      ctrlAt(slot) = EMPTY;
+    } else {
+      ctrlAt(slot) = DELETED;
+      numDeleted++;
+    }
+
+    // INFO: Keep entries dense by moving the last one into the hole
+    size_t index = slotAt(slot);
+    size_t last = numElements - 1;
+    if (index != last) {
+      slotAt(slotOfEntry(last)) = static_cast<uint32_t>(index);
+      entries[index] = std::move(entries[last]);
+    }
+    destroyEntries(last);
+    numElements--;
+    return true;
+  }
+
+public:
+  size_t size() const { return numElements; }
   bool empty() const { return numElements == 0; }
 
+  // INFO: Number of slots, live keys plus tombstones stay under 7/8 of it
+  size_t bucket_count() const { return capacity; }
+  size_t tombstone_count() const { return numDeleted; }
+
+  // INFO: Counters recorded so far, see hashmap_stats.hpp
+  const Stats &stats() const { return *this; }
+  void reset_stats() { Stats::reset(); }
+
   void clear() {
-    for (int i = 0; i < capacity; i++) {
-      buckets[i].isOccupied = false;
-      buckets[i].isDeleted = false;
-    }
+    clearControl();
+    destroyEntries(0);
     numElements = 0;
+    numDeleted = 0;
   }
 
-  // Iterator implementation
+  // Iterator implementation (entries in insertion order)
   class Iterator {
   private:
-    Node *buckets;
-    int capacity;
-    int index;
-
-    void findNext() {
-      while (index < capacity &&
-             (!buckets[index].isOccupied || buckets[index].isDeleted)) { // Check delete flag
-        ++index;
-      }
-    }
+    Node *entries;
+    size_t index;
 
   public:
-    Iterator(Node *b, int c, int i) : buckets(b), capacity(c), index(i) {
-      findNext();
-    }
+    Iterator() : entries(nullptr), index(0) {}
+    Iterator(Node *e, size_t i) : entries(e), index(i) {}
 
     Iterator &operator++() {
-      if (index < capacity) {
-        ++index;
-        findNext();
-      }
+      ++index;
       return *this;
     }
 
@@ -194,30 +656,72 @@ public:
 
     bool operator!=(const Iterator &other) const { return !(*this == other); }
 
-    Node &operator*() { return buckets[index]; }
+    Node &operator*() { return entries[index]; }
+    Node *operator->() { return &entries[index]; }
   };
 
-  Iterator begin() { return Iterator(buckets, capacity, 0); }
+  Iterator begin() { return Iterator(entries, 0); }
 
-  Iterator end() { return Iterator(buckets, capacity, capacity); }
+  Iterator end() { return Iterator(entries, numElements); }
 
-  Iterator find(const K &key) {
-    int hash = hashFunction(key);
-    int i = 0;
-    int index;
+  Iterator find(const K &key) { return findImpl(key, hashFunction(key)); }
 
-    do {
-      index = probe(hash, i++);
+  // INFO: e.g. find(std::string_view) on a std::string map, no allocation
+  template <typename Q, typename H = Hash, typename = IfTransparent<Q, H>>
+  Iterator find(const Q &key) {
+    return findImpl(key, hashFunction(key));
+  }
 
-      if (!buckets[index].isOccupied) {
-        return end();
+  // NOTE: Batched lookup, out[i] is find(keys[i]). BATCH keys at a time are
+  // hashed and their first groups prefetched, then the entries those groups
+  // point at, and only then probed, so the cache misses of independent
+  // lookups overlap instead of queueing.
+  template <typename Q>
+  void find_many(const Q *keys, size_t count, Iterator *out) {
+    static_assert(std::is_same<Q, K>::value || IsTransparent<Hash>::value,
+                  "find_many needs K keys or a transparent hash policy");
+    constexpr size_t BATCH = 16;
+    uint64_t hashes[BATCH];
+    size_t mask = capacity / GROUP_WIDTH - 1;
+
+    for (size_t first = 0; first < count; first += BATCH) {
+      size_t n = count - first < BATCH ? count - first : BATCH;
+      if (numElements == 0) {
+        for (size_t i = 0; i < n; i++) {
+          out[first + i] = end();
+        }
+        continue;
       }
 
-      if (!buckets[index].isDeleted && buckets[index].key == key) { // Check delete flag
-        return Iterator(buckets, capacity, index);
+      for (size_t i = 0; i < n; i++) {
+        hashes[i] = hashFunction(keys[first + i]);
+        prefetch(&groups[static_cast<size_t>(hashes[i] >> 7) & mask]);
       }
-    } while (i < capacity);
+      for (size_t i = 0; i < n; i++) {
+        const Group &group =
+            groups[static_cast<size_t>(hashes[i] >> 7) & mask];
+        uint32_t m = matchByte(group.ctrl, fragment(hashes[i]));
+        if (m != 0) {
+          prefetch(&entries[group.slots[countTrailingZeros(m)]]);
+        }
+      }
+      for (size_t i = 0; i < n; i++) {
+        size_t slot = findSlot(keys[first + i], hashes[i]);
+        out[first + i] =
+            slot == NOT_FOUND ? end() : Iterator(entries, slotAt(slot));
+      }
+    }
+  }
 
-    return end();
+private:
+  template <typename Q> Iterator findImpl(const Q &key, uint64_t hash) {
+    if (numElements == 0) {
+      return end();
+    }
+    size_t slot = findSlot(key, hash);
+    if (slot == NOT_FOUND) {
+      return end();
+    }
+    return Iterator(entries, slotAt(slot));
   }
 };
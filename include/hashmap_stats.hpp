@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// NOTE: Stats policies for HashMap, chosen at compile time. The default
+// records nothing: HashMap only calls into a policy inside
+// `if constexpr (Stats::ENABLED)` and inherits it as an empty base, so the
+// disabled map has the same size and code as one without the parameter.
+struct NoHashMapStats {
+  static constexpr bool ENABLED = false;
+};
+
+// INFO: Probe lengths are counted in 16-slot groups visited. Counters are
+// mutable so const lookups can record them.
+struct HashMapStats {
+  static constexpr bool ENABLED = true;
+
+  mutable uint64_t hits = 0;
+  mutable uint64_t hit_groups = 0;
+  mutable uint64_t misses = 0;
+  mutable uint64_t miss_groups = 0;
+  mutable uint64_t max_groups = 0;
+  mutable uint64_t key_compares = 0;
+  mutable uint64_t false_matches = 0; // INFO: Tag matched, key did not
+  mutable uint64_t resizes = 0;       // INFO: Table doubled
+  mutable uint64_t rehashes = 0;      // INFO: Rebuilt in place for tombstones
+  mutable uint64_t resize_nanoseconds = 0;
+
+  void record_lookup(uint64_t groups, uint64_t compares, bool hit) const {
+    if (hit) {
+      hits++;
+      hit_groups += groups;
+      false_matches += compares - 1;
+    } else {
+      misses++;
+      miss_groups += groups;
+      false_matches += compares;
+    }
+    key_compares += compares;
+    max_groups = groups > max_groups ? groups : max_groups;
+  }
+
+  void record_resize(bool in_place, uint64_t nanoseconds) const {
+    (in_place ? rehashes : resizes)++;
+    resize_nanoseconds += nanoseconds;
+  }
+
+  double average_hit_groups() const {
+    return hits == 0 ? 0 : hit_groups / static_cast<double>(hits);
+  }
+
+  double average_miss_groups() const {
+    return misses == 0 ? 0 : miss_groups / static_cast<double>(misses);
+  }
+
+  void reset() { *this = HashMapStats(); }
+};
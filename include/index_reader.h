@@ -0,0 +1,83 @@
+#pragma once
+
+#include "array_list.hpp"
+#include "indexer.h"
+#include "mapped_file.h"
+#include "postings_codec.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// NOTE: clouseau.idx layout (all integers host byte order, offsets are from
+// the start of the file)
+//
+//   header:     "CLSU", uint32 version, uint32 num_docs, uint32 num_terms,
+//               uint64 documents, postings, dictionary and term table offsets
+//   documents:  per doc uint32 name length, name, uint64 size, int64 mtime,
+//               uint64 hash, uint32 length
+//   postings:   each term's compressed postings (see postings_codec.h)
+//   dictionary: per term, sorted by term: uint32 term length, term,
+//               uint32 total, uint32 df, uint64 postings offset,
+//               uint32 postings bytes
+//   term table: uint64 dictionary entry offset per term
+//
+// The dictionary is contiguous and holds df, so lookups and idf never touch
+// the postings section. Document hashes are hash_bytes of the file, so
+// changing that hash needs a new version.
+inline constexpr char INDEX_MAGIC[4] = {'C', 'L', 'S', 'U'};
+inline constexpr uint32_t INDEX_VERSION = 6;
+inline constexpr size_t INDEX_HEADER_SIZE = 4 + 3 * 4 + 4 * 8;
+
+// INFO: One term's entry, pointing into the mapped file
+struct TermInfo {
+  std::string_view term;
+  uint32_t total;
+  uint32_t df;
+  const char *postings;
+  size_t postings_size;
+};
+
+// NOTE: Read-only view of a saved index. Opening maps the file and reads
+// only the header and document table; terms are binary searched in the
+// dictionary and a term's postings are decoded straight from the mapped
+// bytes when asked for, so only the pages a query uses are ever loaded.
+class IndexReader {
+public:
+  explicit IndexReader(const std::string &path);
+
+  const ArrayList<Document> &documents() const { return documents_; }
+  size_t num_documents() const { return documents_.size(); }
+  size_t num_terms() const { return num_terms_; }
+
+  // INFO: i-th term in sorted order
+  TermInfo term(size_t i) const;
+
+  // INFO: False when the term is not in the index
+  bool find(std::string_view term, TermInfo &info) const;
+
+  // NOTE: found[i] = find(terms[i], infos[i]) for a whole query at once. The
+  // binary searches advance in lockstep and each step prefetches every
+  // search's next probe, so their page and cache misses overlap.
+  void find_many(const std::string_view *terms, size_t count, TermInfo *infos,
+                 bool *found) const;
+
+  PostingsDecoder postings(const TermInfo &info) const {
+    return PostingsDecoder(info.postings, info.postings_size,
+                           static_cast<uint32_t>(documents_.size()));
+  }
+
+  double idf(const TermInfo &info) const;
+  double tf(uint32_t doc, uint32_t count) const;
+
+private:
+  MappedFile file_;
+  ArrayList<Document> documents_;
+  const char *term_table_;
+  size_t num_terms_;
+
+  // INFO: Term of the i-th dictionary entry, without parsing the rest of it
+  std::string_view term_at(size_t i) const;
+  uint64_t entry_offset(size_t i) const;
+};
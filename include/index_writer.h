@@ -0,0 +1,50 @@
+#pragma once
+
+#include "array_list.hpp"
+#include "indexer.h"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// INFO: Postings of freq sorted by doc ID and compressed (postings_codec.h)
+void encode_frequency(const Frequency &freq, std::string &out);
+
+// NOTE: Streams an index file in the layout described in index_reader.h.
+// Terms must be added in sorted order. Postings go straight to disk, and the
+// dictionary and term table are staged in two temporary files next to it
+// that finish() copies in a chunk at a time, so memory stays flat however
+// large the vocabulary. The index itself is written to a temporary file that
+// finish() renames over path, so readers that have the old index mapped keep
+// a whole file and never see a truncated or half-written one.
+class IndexWriter {
+public:
+  IndexWriter(const std::string &path, const ArrayList<Document> &documents);
+  ~IndexWriter(); // INFO: Removes the temporary files
+  IndexWriter(const IndexWriter &) = delete;
+  IndexWriter &operator=(const IndexWriter &) = delete;
+
+  void add(const std::string &term, const Frequency &freq);
+
+  // INFO: Write the dictionary, patch the header and move the file into
+  // place, returns the term count
+  uint32_t finish();
+
+private:
+  std::string path_;
+  std::ofstream out_;
+  std::ofstream dictionary_; // INFO: Encoded dictionary entries
+  std::ofstream term_table_; // INFO: Entry offsets from the dictionary start
+  uint64_t dictionary_size_;
+  uint32_t num_terms_;
+  std::string entry_;   // INFO: Reused dictionary entry buffer
+  std::string encoded_; // INFO: Reused postings buffer
+  uint64_t documents_offset_;
+  uint64_t postings_offset_;
+  uint32_t num_documents_;
+
+  std::string temp_path() const { return path_ + ".tmp"; }
+  std::string dictionary_path() const { return path_ + ".dictionary"; }
+  std::string term_table_path() const { return path_ + ".terms"; }
+};
@@ -3,56 +3,189 @@
 #include "array_list.hpp"
 #include "hashmap.hpp"
 #include "set.hpp"
+#include "sharded_hashmap.hpp"
+#include "small_array_list.hpp"
 #include "trie.hpp"
 
 #include <atomic>
-#include <mutex>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
 #include <string>
+#include <vector>
 
+// NOTE: One posting - doc is an index into Indexer::documents
 struct FileFrequency {
-  std::string file;
+  uint32_t doc;
   int count;
   double tf;
 };
 
+// NOTE: Most terms of a Zipfian vocabulary occur in a single document, so
+// one posting is kept inline and only longer lists allocate
+using PostingsList = SmallArrayList<FileFrequency, 1>;
+
 // NOTE: Associated with a word
 struct Frequency {
   int total;
   double idf;
-  ArrayList<FileFrequency> files;
+  PostingsList files;
+};
+
+// NOTE: An indexed file and what it looked like when it was indexed
+struct Document {
+  std::string file;
+  uint64_t size;
+  int64_t mtime;
+  uint64_t hash;   // INFO: hash_bytes of the whole file
+  uint32_t length; // INFO: Indexed words, the tf denominator
 };
 
+// INFO: What update_index found changed since the saved index
+enum class IndexChange {
+  None,     // INFO: Nothing to write
+  Manifest, // INFO: Only mtimes, the vocabulary and postings are the same
+  Postings, // INFO: Files were added, modified or removed
+};
+
+class IndexReader;
+
 class Indexer {
 public:
   Indexer(const std::string &directory);
 
-  void index_directory();
-  void serialize_index();
+  // INFO: num_threads <= 0 uses every hardware thread
+  void index_directory(int num_threads = 0);
+
+  // INFO: SPIMI-style indexing for corpora larger than RAM. Partial indexes
+  // are spilled as sorted runs once max_memory bytes are used, then k-way
+  // merged straight into the index file (no serialize_index needed).
+  void index_directory_external(size_t max_memory, int num_threads = 0);
+
+  // INFO: Re-index only files added or modified since the saved index was
+  // built, and drop deleted ones. Falls back to index_directory when there is
+  // no usable saved index. The manifest is compared first, so when nothing
+  // changed the postings are never decoded and `index` is left empty.
+  IndexChange update_index(int num_threads = 0);
+
+  // NOTE: update_index for index_directory_external: changed files are
+  // spilled as runs and merged with the surviving postings of the saved
+  // index, streamed from the mapped file, into a new index file. Writes the
+  // index itself, and the autocomplete trie only when postings changed.
+  IndexChange update_index_external(size_t max_memory, int num_threads = 0);
+
+  // INFO: autocomplete false keeps clouseau.ac, for an unchanged vocabulary
+  void serialize_index(bool autocomplete = true);
   void deserialize_index();
 
   // INFO: Build Trie from index during deserialization
   void deserialize_index(Trie &trie);
 
-  HashMap<std::string, Frequency> index;
+  // INFO: Partitioned by term hash so shards can be merged in parallel
+  ShardedHashMap<std::string, Frequency> index;
+
+  // INFO: Document table, a posting's doc ID is its position here
+  ArrayList<Document> documents;
+
+  // INFO: Ignore counting these
+  static const Set<std::string> stopwords;
 
 private:
   std::string directory;
   std::string indexFile;
+  std::string autocompleteFile;
   ArrayList<std::string> files;
-  std::mutex index_mutex;
+  HashMap<std::string, uint32_t> document_ids; // INFO: file -> doc ID
 
-  // INFO: Ignore counting these
-  const Set<std::string> stopwords = {"the", "and", "is",   "in",   "it",  "of",
-                                      "to",  "a",   "that", "with", "for", "on",
-                                      "as",  "by",  "at",   "an",   "be", "or", "not"};
+  // INFO: The directory's files compared with a saved index's manifest
+  struct ManifestDiff {
+    ArrayList<std::string> changed;       // INFO: Added or modified
+    HashMap<std::string, bool> stale;     // INFO: Modified or deleted
+    HashMap<std::string, int64_t> touched; // INFO: Same contents, new mtime
+    int added = 0, modified = 0, removed = 0;
+  };
+
+  // INFO: Files and progress shared by the workers of one indexing pass
+  struct IndexJob {
+    ArrayList<std::string> files;
+    uint32_t first_doc = 0; // INFO: files[i] has doc ID first_doc + i
+    std::atomic<size_t> next_file{0};
+    std::atomic<int> processed_files{0};
+  };
 
   // INFO: Walk through the directory and get all files
   ArrayList<std::string> get_directory_files();
 
-  // INFO: [THREAD WORKER] Index chunk of files
-  void index_selection(const ArrayList<std::string> &files,
-                       std::atomic<int> &processed_files, int total_files);
+  // INFO: Clamp a requested thread count to [1, number of files]
+  int resolve_threads(int num_threads, size_t num_files) const;
+
+  // INFO: Order files by decreasing size for scheduling
+  void sort_files_by_size(ArrayList<std::string> &file_list) const;
+
+  // INFO: Sort the job's files and give each one the next free doc ID
+  void prepare_job(IndexJob &job);
+
+  // INFO: Tokenize the job's files and merge them into `index`
+  void index_files(IndexJob &job, int num_threads);
+
+  // INFO: [THREAD WORKER] Index files claimed from the shared cursor
+  void index_selection(IndexJob &job,
+                       ShardedHashMap<std::string, Frequency> &local_index);
+
+  // INFO: [THREAD WORKER] Merge claimed shards of every local index
+  void merge_shards(
+      std::atomic<size_t> &next_shard,
+      std::vector<std::unique_ptr<ShardedHashMap<std::string, Frequency>>>
+          &local_indexes);
+
+  // INFO: [THREAD WORKER] Index claimed files, spilling sorted runs to disk
+  // whenever the local index grows past budget bytes
+  void spill_selection(IndexJob &job, size_t budget,
+                       std::atomic<int> &next_run);
+
+  // INFO: Tokenize the job's files into sorted runs, returns the run count
+  int spill_files(IndexJob &job, size_t max_memory, int num_threads);
+
+  // INFO: Write a local index as a run sorted by word
+  void write_run(HashMap<std::string, Frequency> &local_index, int run);
+  std::string run_path(int run) const;
+
+  // INFO: k-way merge of all runs into the index file. With a base index,
+  // its postings are merged in too, renumbered by remap (see
+  // renumber_documents).
+  void merge_runs(int num_runs, const IndexReader *base = nullptr,
+                  const std::vector<uint32_t> *remap = nullptr);
+
+  // INFO: Compare the directory with the manifest of a saved index, hashing
+  // files whose size or mtime changed
+  ManifestDiff diff_manifest(const ArrayList<Document> &saved) const;
+
+  // INFO: Take the saved document table, with the new mtimes of touched files
+  void load_documents(const ArrayList<Document> &saved,
+                      ManifestDiff &diff);
+
+  // INFO: Drop the given files from the document table and renumber the
+  // rest so doc IDs stay dense. Returns old doc ID -> new doc ID, UINT32_MAX
+  // for dropped ones.
+  std::vector<uint32_t> renumber_documents(HashMap<std::string, bool> &stale);
+
+  // INFO: Drop the given files and their postings, then renumber the
+  // remaining documents so doc IDs stay dense
+  void remove_documents(HashMap<std::string, bool> &stale);
+
+  void compute_idf();
+
+  // INFO: Write the autocomplete trie for the index file just written
+  void write_autocomplete();
+
+  // INFO: Decode the whole index file (and fill the trie, if given)
+  void load_index(Trie *trie);
+
+  // INFO: Size and mtime of a file (hash and length left at 0)
+  Document stat_file(const std::string &file) const;
 
-  // INFO: Count words in a file
-  HashMap<std::string, int> file_word_count(const std::string &file);
+  // INFO: Count words in a file, and fill in its document entry
+  HashMap<std::string, int> file_word_count(const std::string &file,
+                                            Document &document);
 };
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// NOTE: Levenshtein automaton for one query word, simulated bit-parallel
+// (Wu-Manber). rows[j] has bit i set when the first i characters of the
+// query are within j edits of the characters consumed so far, so a state is
+// MAX_EDITS + 1 words and a step is a few shifts and masks. Walking a trie
+// steps the state once per edge character and stops at the first state with
+// no bits left, where no completion can come back within max_edits.
+class LevenshteinAutomaton {
+public:
+  static constexpr uint8_t MAX_EDITS = 2;
+  static constexpr size_t MAX_LENGTH = 63; // INFO: Bits 0 to 63 of a row
+
+  struct State {
+    uint64_t rows[MAX_EDITS + 1];
+  };
+
+  // INFO: max_edits is clamped to MAX_EDITS. Throws std::invalid_argument
+  // for a word longer than MAX_LENGTH.
+  LevenshteinAutomaton(std::string_view word, uint8_t max_edits);
+
+  uint8_t max_edits() const { return max_edits_; }
+
+  State start() const;
+
+  State step(const State &state, unsigned char c) const {
+    const uint64_t match = masks_[c];
+    State next = {};
+    next.rows[0] = (state.rows[0] << 1) & match;
+    for (uint8_t j = 1; j <= max_edits_; j++) {
+      // INFO: Match, then the consumed character is extra, replaces a query
+      // character, or a query character is skipped
+      next.rows[j] = (((state.rows[j] << 1) & match) | state.rows[j - 1] |
+                      (state.rows[j - 1] << 1) | (next.rows[j - 1] << 1)) &
+                     live_;
+    }
+    return next;
+  }
+
+  // INFO: Edit distance from the whole query to the characters consumed,
+  // max_edits + 1 when it is further than that
+  uint8_t distance(const State &state) const {
+    uint8_t j = 0;
+    while (j <= max_edits_ && (state.rows[j] & done_) == 0) {
+      j++;
+    }
+    return j;
+  }
+
+  // INFO: Lowest distance any extension of the consumed characters can
+  // reach, so a walk prunes once it is over max_edits
+  uint8_t lower_bound(const State &state) const {
+    uint8_t j = 0;
+    while (j <= max_edits_ && state.rows[j] == 0) {
+      j++;
+    }
+    return j;
+  }
+
+private:
+  uint64_t masks_[256]; // INFO: Bit i + 1 set where the query's i-th is c
+  uint64_t live_;       // INFO: Bits 0 to the query length
+  uint64_t done_;       // INFO: The bit for the whole query
+  uint8_t max_edits_;
+};
+
+// NOTE: Edits allowed for a query word of the given length, the usual
+// 0 / 1 / 2 steps so short words are not matched against everything
+inline uint8_t edits_for_length(size_t length) {
+  return length <= 2 ? 0 : length <= 5 ? 1 : 2;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// NOTE: Read-only view of a whole file as one contiguous span. Uses mmap where
+// available and falls back to a single large buffered read otherwise.
+class MappedFile {
+public:
+  // INFO: Hint passed to madvise - tokenizing streams through a file once,
+  // index lookups jump around
+  enum class Access { Sequential, Random };
+
+  explicit MappedFile(const std::string &path,
+                      Access access = Access::Sequential);
+  ~MappedFile();
+
+  // NOTE: Owns the mapping, so no copies (moves transfer ownership)
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+
+  const char *data() const { return data_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  // INFO: False when the contents were read into a heap buffer instead
+  bool is_mapped() const { return mapped_; }
+
+private:
+  const char *data_;
+  size_t size_;
+  bool mapped_;
+  std::string buffer_; // INFO: Only used by the buffered fallback
+
+  void read_buffered(const std::string &path);
+  void release();
+};
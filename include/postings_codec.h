@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// NOTE: Compressed postings list. Doc IDs must be strictly increasing.
+//
+//   varint  number of postings
+//   blocks of POSTINGS_BLOCK_SIZE postings, each:
+//     uint8  doc bit width, uint8 count bit width
+//     doc gaps (doc - previous doc - 1), bit-packed
+//     counts - 1, bit-packed
+//   tail (fewer than POSTINGS_BLOCK_SIZE postings): gaps and counts - 1 as
+//   varints
+constexpr size_t POSTINGS_BLOCK_SIZE = 128;
+
+// INFO: Append the encoded postings to out
+void encode_postings(const uint32_t *docs, const uint32_t *counts, size_t n,
+                     std::string &out);
+
+// NOTE: Decodes one block at a time straight from the encoded bytes. Doc IDs
+// are used as indices by callers, so any at or past num_docs throws.
+class PostingsDecoder {
+public:
+  PostingsDecoder(const char *data, size_t size,
+                  uint32_t num_docs = UINT32_MAX);
+
+  // INFO: Number of postings (the term's document frequency)
+  size_t size() const { return size_; }
+
+  // INFO: Decode up to POSTINGS_BLOCK_SIZE postings into docs/counts,
+  // returns how many were decoded (0 once the list is exhausted)
+  size_t next(uint32_t *docs, uint32_t *counts);
+
+  // INFO: Bytes consumed so far (all of them once next() returned 0)
+  size_t consumed() const { return static_cast<size_t>(pos_ - data_); }
+
+private:
+  const char *data_;
+  const char *pos_;
+  const char *end_;
+  size_t size_;
+  size_t decoded_;
+  uint32_t last_doc_;
+  uint32_t num_docs_;
+};
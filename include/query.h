@@ -0,0 +1,25 @@
+#pragma once
+
+#include "doc_bitmap.h"
+#include "flat_trie.h"
+#include "index_reader.h"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+// INFO: Docs matching a query and the terms to score them by
+struct QueryResult {
+  DocBitmap docs;
+  std::vector<TermInfo> scored_terms; // INFO: Every term not under a "not"
+};
+
+// NOTE: Evaluate a lowercased, tokenized boolean query (terms joined by
+// "and", "or" and "not") left to right. Every term is looked up in one
+// batch. A term the index does not have is replaced by its closest word in
+// vocabulary, when given, unless it is a stopword the indexer drops on
+// purpose. Terms that are still missing are reported on out and skipped.
+QueryResult evaluate_query(const IndexReader &reader,
+                           const FlatTrie *vocabulary,
+                           const std::vector<std::string> &tokens,
+                           std::ostream &out);
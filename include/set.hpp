@@ -1,27 +1,35 @@
 #pragma once
 
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <initializer_list>
-#include <mutex>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SET_SSE2 1
+#endif
+
+// NOTE: Elements are kept sorted and unique in one contiguous array, so
+// contains is a binary search and set operations are merges. Intersection
+// gallops through the larger set when the sizes are lopsided (a rare term
+// AND a common one) and otherwise merges, four at a time with SSE2 for
+// 32-bit integers such as doc IDs. Input that is already sorted - a posting
+// list, another Set - is appended without any searching.
 template <typename T> class Set {
 public:
-  class Iterator {
-  public:
-    Iterator(T *ptr) : ptr_(ptr) {}
-    Iterator operator++() {
-      ++ptr_;
-      return *this;
-    }
-    bool operator!=(const Iterator &other) const { return ptr_ != other.ptr_; }
-    T &operator*() const { return *ptr_; }
-
-  private:
-    T *ptr_;
-  };
+  // NOTE: Elements are read-only, writing one could break the order
+  using Iterator = const T *;
 
   Set();
+  // NOTE: Reserves capacity, the set starts empty
   explicit Set(size_t capacity);
   Set(std::initializer_list<T> list);
   ~Set();
@@ -31,52 +39,73 @@ public:
   Set(Set &&other) noexcept;
   Set &operator=(Set &&other) noexcept;
 
+  // INFO: Builds a set from ascending input in one pass, duplicates are
+  // dropped. The input must already be sorted.
+  template <typename InputIt>
+  static Set<T> from_sorted(InputIt first, InputIt last);
+
   bool contains(const T &value) const;
   void insert(const T &value);
   template <typename InputIt> void insert(InputIt first, InputIt last);
   void erase(const T &value);
   Set<T> intersect(const Set<T> &other) const;
+  Set<T> unite(const Set<T> &other) const;      // NOTE: Union
+  Set<T> difference(const Set<T> &other) const; // NOTE: In this, not other
+  void reserve(size_t n);
   size_t size() const;
   size_t capacity() const;
   bool empty() const;
   void clear();
-  Iterator begin() { return Iterator(data_); }
-  Iterator end() { return Iterator(data_ + size_); }
+  void swap(Set &other) noexcept;
+  Iterator begin() const { return data_; }
+  Iterator end() const { return data_ + size_; }
 
 private:
+  // INFO: Below this size ratio a merge beats galloping
+  static constexpr size_t GALLOP_RATIO = 16;
+
   T *data_;
   size_t size_;
   size_t capacity_;
-  std::mutex mtx_;
 
-  void resize_if_needed();
+  static T *allocate(size_t n);
+  static void deallocate(T *data, size_t n);
+  void destroy_all();
+  void grow_to(size_t new_capacity);
+  void ensure_capacity(size_t n);
+  // INFO: Caller keeps the order and has reserved the capacity
+  void append(const T &value);
+  void append(T &&value);
   void copy_from(const Set &other);
   void move_from(Set &&other);
+  void intersect_gallop(const Set &larger, Set &result) const;
+  void intersect_merge(const Set &other, Set &result) const;
 };
 
 template <typename T> Set<T>::Set() : data_(nullptr), size_(0), capacity_(0) {}
 
 template <typename T>
-Set<T>::Set(size_t capacity) : size_(0), capacity_(capacity) {
-  data_ = new T[capacity];
-}
+Set<T>::Set(size_t capacity)
+    : data_(allocate(capacity)), size_(0), capacity_(capacity) {}
 
 template <typename T>
 Set<T>::Set(std::initializer_list<T> list) : Set(list.size()) {
-  size_ = 0;
-  for (const T &element : list) {
-    insert(element);
-  }
+  insert(list.begin(), list.end());
 }
 
-template <typename T> Set<T>::~Set() { delete[] data_; }
+template <typename T> Set<T>::~Set() {
+  destroy_all();
+  deallocate(data_, capacity_);
+}
 
 template <typename T> Set<T>::Set(const Set &other) { copy_from(other); }
 
+// NOTE: Copy first, then swap, so a throwing element copy leaves this set
+// as it was
 template <typename T> Set<T> &Set<T>::operator=(const Set &other) {
   if (this != &other) {
-    delete[] data_;
-    copy_from(other);
+    Set copy(other);
+    swap(copy);
   }
   return *this;
 }
@@ -87,89 +116,248 @@ template <typename T> Set<T>::Set(Set &&other) noexcept {
 
 template <typename T> Set<T> &Set<T>::operator=(Set &&other) noexcept {
   if (this != &other) {
-    delete[] data_;
+    destroy_all();
+    deallocate(data_, capacity_);
     move_from(std::move(other));
   }
   return *this;
 }
 
-template <typename T> bool Set<T>::contains(const T &value) const {
-  for (size_t i = 0; i < size_; ++i) {
-    if (data_[i] == value) {
-      return true;
+template <typename T>
+template <typename InputIt>
+Set<T> Set<T>::from_sorted(InputIt first, InputIt last) {
+  Set<T> result;
+  for (; first != last; ++first) {
+    if (result.size_ == 0 || result.data_[result.size_ - 1] < *first) {
+      result.ensure_capacity(result.size_ + 1);
+      result.append(*first);
     }
   }
-  return false;
+  return result;
+}
+
+template <typename T> bool Set<T>::contains(const T &value) const {
+  const T *it = std::lower_bound(data_, data_ + size_, value);
+  return it != data_ + size_ && !(value < *it);
 }
 
 template <typename T> void Set<T>::insert(const T &value) {
-  std::lock_guard<std::mutex> lock(mtx_);
-  if (!contains(value)) {
-    resize_if_needed();
-    data_[size_++] = value;
+  size_t index = std::lower_bound(data_, data_ + size_, value) - data_;
+  if (index < size_ && !(value < data_[index])) {
+    return;
+  }
+
+  T item(value); // NOTE: value may be an element of this set
+  ensure_capacity(size_ + 1);
+  if (index == size_) {
+    new (data_ + size_) T(std::move(item));
+  } else {
+    new (data_ + size_) T(std::move(data_[size_ - 1]));
+    std::move_backward(data_ + index, data_ + size_ - 1, data_ + size_);
+    data_[index] = std::move(item);
   }
+  size_++;
 }
 
+// NOTE: A sorted run past the current maximum (the next block of a posting
+// list) is appended as is. Anything else is sorted on the side and merged.
 template <typename T>
 template <typename InputIt>
 void Set<T>::insert(InputIt first, InputIt last) {
-  for (InputIt it = first; it != last; ++it) {
-    insert(*it);
+  using Traits = std::iterator_traits<InputIt>;
+  if constexpr (std::is_base_of<std::forward_iterator_tag,
+                                typename Traits::iterator_category>::value &&
+                std::is_same<typename Traits::value_type, T>::value &&
+                std::is_reference<typename Traits::reference>::value) {
+    bool ascending = true;
+    const T *previous = size_ == 0 ? nullptr : data_ + size_ - 1;
+    size_t count = 0;
+    for (InputIt it = first; it != last; ++it, ++count) {
+      if (previous != nullptr && !(*previous < *it)) {
+        ascending = false;
+        break;
+      }
+      previous = &*it;
+    }
+    if (ascending) {
+      ensure_capacity(size_ + count);
+      for (; first != last; ++first) {
+        append(*first);
+      }
+      return;
+    }
   }
+
+  std::vector<T> incoming(first, last);
+  std::sort(incoming.begin(), incoming.end());
+  incoming.erase(std::unique(incoming.begin(), incoming.end()),
+                 incoming.end());
+  if (incoming.empty()) {
+    return;
+  }
+
+  Set<T> merged(size_ + incoming.size());
+  size_t i = 0, j = 0;
+  while (i < size_ && j < incoming.size()) {
+    if (data_[i] < incoming[j]) {
+      merged.append(std::move(data_[i++]));
+    } else if (incoming[j] < data_[i]) {
+      merged.append(std::move(incoming[j++]));
+    } else {
+      merged.append(std::move(data_[i++]));
+      j++;
+    }
+  }
+  for (; i < size_; i++) {
+    merged.append(std::move(data_[i]));
+  }
+  for (; j < incoming.size(); j++) {
+    merged.append(std::move(incoming[j]));
+  }
+  *this = std::move(merged);
 }
 
 template <typename T> void Set<T>::erase(const T &value) {
-  std::lock_guard<std::mutex> lock(mtx_);
-  for (size_t i = 0; i < size_; ++i) {
-    if (data_[i] == value) {
-      data_[i] = data_[--size_];
-      break;
-    }
+  T *it = std::lower_bound(data_, data_ + size_, value);
+  if (it != data_ + size_ && !(value < *it)) {
+    std::move(it + 1, data_ + size_, it);
+    data_[--size_].~T();
   }
 }
 
 template <typename T> Set<T> Set<T>::intersect(const Set<T> &other) const {
-  Set<T> result;
-  for (size_t i = 0; i < size_; ++i) {
-    if (other.contains(data_[i])) {
-      result.insert(data_[i]);
+  const Set<T> &smaller = size_ <= other.size_ ? *this : other;
+  const Set<T> &larger = size_ <= other.size_ ? other : *this;
+  Set<T> result(smaller.size_);
+  if (smaller.size_ == 0) {
+    return result;
+  }
+  if (larger.size_ / smaller.size_ >= GALLOP_RATIO) {
+    smaller.intersect_gallop(larger, result);
+  } else {
+    smaller.intersect_merge(larger, result);
+  }
+  return result;
+}
+
+template <typename T> Set<T> Set<T>::unite(const Set<T> &other) const {
+  Set<T> result(size_ + other.size_);
+  size_t i = 0, j = 0;
+  while (i < size_ && j < other.size_) {
+    if (data_[i] < other.data_[j]) {
+      result.append(data_[i++]);
+    } else if (other.data_[j] < data_[i]) {
+      result.append(other.data_[j++]);
+    } else {
+      result.append(data_[i++]);
+      j++;
     }
   }
+  for (; i < size_; i++) {
+    result.append(data_[i]);
+  }
+  for (; j < other.size_; j++) {
+    result.append(other.data_[j]);
+  }
   return result;
 }
 
+template <typename T> Set<T> Set<T>::difference(const Set<T> &other) const {
+  Set<T> result(size_);
+  size_t j = 0;
+  for (size_t i = 0; i < size_; i++) {
+    while (j < other.size_ && other.data_[j] < data_[i]) {
+      j++;
+    }
+    if (j == other.size_ || data_[i] < other.data_[j]) {
+      result.append(data_[i]);
+    }
+  }
+  return result;
+}
+
+template <typename T> void Set<T>::reserve(size_t n) {
+  if (n > capacity_) {
+    grow_to(n);
+  }
+}
+
 template <typename T> size_t Set<T>::size() const { return size_; }
 
 template <typename T> size_t Set<T>::capacity() const { return capacity_; }
 
 template <typename T> bool Set<T>::empty() const { return size_ == 0; }
 
-template <typename T> void Set<T>::clear() {
-  std::lock_guard<std::mutex> lock(mtx_);
-  size_ = 0;
+template <typename T> void Set<T>::clear() { destroy_all(); }
+
+template <typename T> void Set<T>::swap(Set &other) noexcept {
+  std::swap(data_, other.data_);
+  std::swap(size_, other.size_);
+  std::swap(capacity_, other.capacity_);
 }
 
-template <typename T> void Set<T>::resize_if_needed() {
-  if (size_ == capacity_) {
-    size_t new_capacity = capacity_ == 0 ? 1 : capacity_ * 2;
-    T *new_data = new T[new_capacity];
+template <typename T> T *Set<T>::allocate(size_t n) {
+  return n == 0 ? nullptr : std::allocator<T>().allocate(n);
+}
 
+template <typename T> void Set<T>::deallocate(T *data, size_t n) {
+  if (data != nullptr) {
+    std::allocator<T>().deallocate(data, n);
+  }
+}
+
+template <typename T> void Set<T>::destroy_all() {
+  if constexpr (!std::is_trivially_destructible<T>::value) {
     for (size_t i = 0; i < size_; ++i) {
-      new_data[i] = std::move(data_[i]);
+      data_[i].~T();
     }
+  }
+  size_ = 0;
+}
+
+template <typename T> void Set<T>::grow_to(size_t new_capacity) {
+  T *new_data = allocate(new_capacity);
+  for (size_t i = 0; i < size_; ++i) {
+    new (new_data + i) T(std::move_if_noexcept(data_[i]));
+    data_[i].~T();
+  }
+  deallocate(data_, capacity_);
+  data_ = new_data;
+  capacity_ = new_capacity;
+}
 
-    delete[] data_;
-    data_ = new_data;
-    capacity_ = new_capacity;
+// INFO: Grows geometrically, so appending block by block stays linear
+template <typename T> void Set<T>::ensure_capacity(size_t n) {
+  if (n > capacity_) {
+    grow_to(std::max(n, capacity_ * 2));
   }
 }
 
+template <typename T> void Set<T>::append(const T &value) {
+  new (data_ + size_) T(value);
+  size_++;
+}
+
+template <typename T> void Set<T>::append(T &&value) {
+  new (data_ + size_) T(std::move(value));
+  size_++;
+}
+
 template <typename T> void Set<T>::copy_from(const Set &other) {
-  data_ = new T[other.capacity_];
-  size_ = other.size_;
-  capacity_ = other.capacity_;
-  for (size_t i = 0; i < size_; ++i) {
-    data_[i] = other.data_[i];
+  data_ = allocate(other.size_);
+  size_ = 0;
+  capacity_ = other.size_;
+  // NOTE: No destructor runs for a half built copy, so undo it here
+  try {
+    for (; size_ < other.size_; ++size_) {
+      new (data_ + size_) T(other.data_[size_]);
+    }
+  } catch (...) {
+    destroy_all();
+    deallocate(data_, capacity_);
+    data_ = nullptr;
+    capacity_ = 0;
+    throw;
   }
 }
 
@@ -182,3 +370,74 @@ template <typename T> void Set<T>::move_from(Set &&other) {
   other.size_ = 0;
   other.capacity_ = 0;
 }
+
+// NOTE: For each element of this (the smaller set), doubles a step through
+// larger until it passes the element, then binary searches that last step
+template <typename T>
+void Set<T>::intersect_gallop(const Set &larger, Set &result) const {
+  const T *low = larger.data_;
+  const T *end = larger.data_ + larger.size_;
+  for (size_t i = 0; i < size_ && low != end; i++) {
+    const T &value = data_[i];
+    size_t step = 1;
+    while (step < static_cast<size_t>(end - low) && low[step] < value) {
+      step *= 2;
+    }
+    const T *high =
+        step < static_cast<size_t>(end - low) ? low + step + 1 : end;
+    low = std::lower_bound(low + step / 2, high, value);
+    if (low != end && !(value < *low)) {
+      result.append(value);
+      ++low;
+    }
+  }
+}
+
+template <typename T>
+void Set<T>::intersect_merge(const Set &other, Set &result) const {
+  size_t i = 0, j = 0;
+#ifdef SET_SSE2
+  if constexpr (std::is_integral<T>::value && sizeof(T) == 4) {
+    // NOTE: Compares a block of four from each side against all four
+    // rotations of the other, then steps past whichever block ends first.
+    // Both sides are unique, so an element matches at most once and matches
+    // come out in order.
+    while (i + 4 <= size_ && j + 4 <= other.size_) {
+      __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data_ + i));
+      __m128i b =
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(other.data_ + j));
+      __m128i b1 = _mm_shuffle_epi32(b, _MM_SHUFFLE(0, 3, 2, 1));
+      __m128i b2 = _mm_shuffle_epi32(b, _MM_SHUFFLE(1, 0, 3, 2));
+      __m128i b3 = _mm_shuffle_epi32(b, _MM_SHUFFLE(2, 1, 0, 3));
+      __m128i equal = _mm_or_si128(
+          _mm_or_si128(_mm_cmpeq_epi32(a, b), _mm_cmpeq_epi32(a, b1)),
+          _mm_or_si128(_mm_cmpeq_epi32(a, b2), _mm_cmpeq_epi32(a, b3)));
+      int mask = _mm_movemask_ps(_mm_castsi128_ps(equal));
+      for (int k = 0; mask != 0; k++, mask >>= 1) {
+        if (mask & 1) {
+          result.append(data_[i + k]);
+        }
+      }
+
+      T a_max = data_[i + 3], b_max = other.data_[j + 3];
+      if (!(b_max < a_max)) {
+        i += 4;
+      }
+      if (!(a_max < b_max)) {
+        j += 4;
+      }
+    }
+  }
+#endif
+  while (i < size_ && j < other.size_) {
+    if (data_[i] < other.data_[j]) {
+      i++;
+    } else if (other.data_[j] < data_[i]) {
+      j++;
+    } else {
+      result.append(data_[i]);
+      i++;
+      j++;
+    }
+  }
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "hashmap.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// NOTE: A HashMap split into independent shards by key hash. A shard is a
+// plain HashMap, so different threads may each own a different shard without
+// locking. The map as a whole is not thread-safe. Keys are hashed once with
+// the Hash policy: the top bits pick the shard (HashMap itself uses the low
+// bits) and the same hash is handed to the shard.
+template <typename K, typename V, typename Hash = HashPolicy<K>>
+class ShardedHashMap {
+private:
+  using Shard = HashMap<K, V, Hash>;
+
+  Shard *shards;
+  size_t numShards;
+  int shardShift;
+
+  size_t shardOf(uint64_t hash) const {
+    return shardShift == 64 ? 0 : static_cast<size_t>(hash >> shardShift);
+  }
+
+public:
+  static constexpr size_t DEFAULT_SHARDS = 64;
+
+  // INFO: shardCount is rounded up to a power of two
+  explicit ShardedHashMap(size_t shardCount = DEFAULT_SHARDS)
+      : numShards(1), shardShift(64) {
+    while (numShards < shardCount) {
+      numShards *= 2;
+      shardShift--;
+    }
+    shards = new Shard[numShards];
+  }
+
+  ~ShardedHashMap() { delete[] shards; }
+
+  ShardedHashMap(const ShardedHashMap &) = delete;
+  ShardedHashMap &operator=(const ShardedHashMap &) = delete;
+
+  size_t shard_count() const { return numShards; }
+
+  size_t shard_of(const K &key) const { return shardOf(Hash{}(key)); }
+
+  Shard &shard(size_t i) { return shards[i]; }
+
+  void insert(const K &key, const V &value) {
+    std::pair<typename Shard::Iterator, bool> result = try_emplace(key, value);
+    if (!result.second) {
+      (*result.first).value = value;
+    }
+  }
+
+  V &operator[](const K &key) { return (*try_emplace(key).first).value; }
+
+  // INFO: The shard's entry and whether it was inserted, see HashMap
+  template <typename... Args>
+  std::pair<typename Shard::Iterator, bool> try_emplace(const K &key,
+                                                        Args &&...args) {
+    uint64_t hash = Hash{}(key);
+    Shard &shard = shards[shardOf(hash)];
+    std::pair<size_t, bool> result =
+        shard.tryEmplaceImpl(hash, key, std::forward<Args>(args)...);
+    return {typename Shard::Iterator(shard.entries, result.first),
+            result.second};
+  }
+
+  bool erase(const K &key) {
+    uint64_t hash = Hash{}(key);
+    return shards[shardOf(hash)].eraseImpl(key, hash);
+  }
+
+  size_t size() const {
+    size_t total = 0;
+    for (size_t i = 0; i < numShards; i++) {
+      total += shards[i].size();
+    }
+    return total;
+  }
+
+  bool empty() const { return size() == 0; }
+
+  void clear() {
+    for (size_t i = 0; i < numShards; i++) {
+      shards[i].clear();
+    }
+  }
+
+  // Iterator implementation (shard by shard)
+  class Iterator {
+  private:
+    Shard *shards;
+    size_t numShards;
+    size_t shardIndex;
+    typename Shard::Iterator current;
+
+    void skipEmptyShards() {
+      while (shardIndex < numShards && !(current != shards[shardIndex].end())) {
+        if (++shardIndex < numShards) {
+          current = shards[shardIndex].begin();
+        }
+      }
+    }
+
+  public:
+    Iterator(Shard *s, size_t n, size_t i, typename Shard::Iterator it)
+        : shards(s), numShards(n), shardIndex(i), current(it) {
+      skipEmptyShards();
+    }
+
+    Iterator &operator++() {
+      ++current;
+      skipEmptyShards();
+      return *this;
+    }
+
+    bool operator==(const Iterator &other) const {
+      return shardIndex == other.shardIndex &&
+             (shardIndex == numShards || current == other.current);
+    }
+
+    bool operator!=(const Iterator &other) const { return !(*this == other); }
+
+    auto &operator*() { return *current; }
+  };
+
+  Iterator begin() { return Iterator(shards, numShards, 0, shards[0].begin()); }
+
+  Iterator end() {
+    return Iterator(shards, numShards, numShards,
+                    shards[numShards - 1].end());
+  }
+
+  Iterator find(const K &key) {
+    uint64_t hash = Hash{}(key);
+    size_t i = shardOf(hash);
+    auto it = shards[i].findImpl(key, hash);
+    if (it == shards[i].end()) {
+      return end();
+    }
+    return Iterator(shards, numShards, i, it);
+  }
+};
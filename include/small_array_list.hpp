@@ -0,0 +1,224 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// NOTE: An ArrayList that keeps its first N elements inside the object and
+// only allocates once it outgrows them. The inline buffer shares space with
+// the heap pointer and the counts are 32-bit, so with N = 1 and a 16-byte T
+// the whole list is 24 bytes - the size of an empty ArrayList - and a single
+// element costs no allocation at all. Same interface as ArrayList, minus the
+// lock policy: it is meant for per-term postings owned by one thread.
+template <typename T, size_t N> class SmallArrayList {
+  static_assert(N > 0, "SmallArrayList needs at least one inline element");
+
+private:
+  union Storage {
+    T *heap;
+    alignas(T) unsigned char inline_[N * sizeof(T)];
+  };
+
+  Storage storage_;
+  uint32_t size_;
+  uint32_t capacity_; // INFO: N while the elements are inline
+
+  bool is_inline() const { return capacity_ == N; }
+
+  T *data() {
+    return is_inline() ? reinterpret_cast<T *>(storage_.inline_)
+                       : storage_.heap;
+  }
+
+  const T *data() const {
+    return is_inline() ? reinterpret_cast<const T *>(storage_.inline_)
+                       : storage_.heap;
+  }
+
+  // INFO: Moves count elements from src to uninitialised dst, destroying src
+  static void relocate(T *src, size_t count, T *dst) {
+    if constexpr (std::is_trivially_copyable<T>::value) {
+      if (count > 0) {
+        std::memcpy(static_cast<void *>(dst), src, count * sizeof(T));
+      }
+    } else {
+      for (size_t i = 0; i < count; i++) {
+        new (dst + i) T(std::move_if_noexcept(src[i]));
+        src[i].~T();
+      }
+    }
+  }
+
+  void destroy_all() {
+    if constexpr (!std::is_trivially_destructible<T>::value) {
+      T *elements = data();
+      for (uint32_t i = 0; i < size_; i++) {
+        elements[i].~T();
+      }
+    }
+    size_ = 0;
+  }
+
+  void release() {
+    destroy_all();
+    if (!is_inline()) {
+      std::allocator<T>().deallocate(storage_.heap, capacity_);
+    }
+    capacity_ = N;
+  }
+
+  void grow_to(size_t new_capacity) {
+    if (new_capacity > UINT32_MAX) {
+      throw std::runtime_error("SmallArrayList is full");
+    }
+    T *new_data = std::allocator<T>().allocate(new_capacity);
+    relocate(data(), size_, new_data);
+    if (!is_inline()) {
+      std::allocator<T>().deallocate(storage_.heap, capacity_);
+    }
+    storage_.heap = new_data;
+    capacity_ = static_cast<uint32_t>(new_capacity);
+  }
+
+  // NOTE: Into an empty list. A throwing element copy destroys the elements
+  // already built and frees the buffer before it propagates.
+  void copy_from(const SmallArrayList &other) {
+    if (other.size_ > N) {
+      grow_to(other.size_);
+    }
+    const T *source = other.data();
+    T *target = data();
+    try {
+      for (; size_ < other.size_; size_++) {
+        new (target + size_) T(source[size_]);
+      }
+    } catch (...) {
+      release();
+      throw;
+    }
+  }
+
+  // NOTE: Heap storage is stolen, inline elements have to be moved one by one
+  void move_from(SmallArrayList &other) {
+    if (other.is_inline()) {
+      relocate(other.data(), other.size_, data());
+      size_ = other.size_;
+      other.size_ = 0;
+    } else {
+      storage_.heap = other.storage_.heap;
+      size_ = other.size_;
+      capacity_ = other.capacity_;
+      other.size_ = 0;
+      other.capacity_ = N;
+    }
+  }
+
+public:
+  SmallArrayList() : size_(0), capacity_(N) {}
+
+  SmallArrayList(std::initializer_list<T> list) : SmallArrayList() {
+    reserve(list.size());
+    for (const T &element : list) {
+      push_back(element);
+    }
+  }
+
+  ~SmallArrayList() { release(); }
+
+  // NOTE: Deep copy
+  SmallArrayList(const SmallArrayList &other) : SmallArrayList() {
+    copy_from(other);
+  }
+
+  // NOTE: Copy first, then swap, so a throwing element copy leaves this list
+  // as it was
+  SmallArrayList &operator=(const SmallArrayList &other) {
+    if (this != &other) {
+      SmallArrayList copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  SmallArrayList(SmallArrayList &&other) noexcept : SmallArrayList() {
+    move_from(other);
+  }
+
+  SmallArrayList &operator=(SmallArrayList &&other) noexcept {
+    if (this != &other) {
+      release();
+      move_from(other);
+    }
+    return *this;
+  }
+
+  T &operator[](size_t index) { return data()[index]; }
+  const T &operator[](size_t index) const { return data()[index]; }
+
+  T &at(size_t index) {
+    if (index >= size_) {
+      throw std::out_of_range("Index out of range");
+    }
+    return data()[index];
+  }
+
+  const T &at(size_t index) const {
+    if (index >= size_) {
+      throw std::out_of_range("Index out of range");
+    }
+    return data()[index];
+  }
+
+  void push_back(const T &value) { emplace_back(value); }
+  void push_back(T &&value) { emplace_back(std::move(value)); }
+
+  template <typename... Args> T &emplace_back(Args &&...args) {
+    if (size_ == capacity_) {
+      // NOTE: args may refer to an element of this list
+      T value(std::forward<Args>(args)...);
+      grow_to(static_cast<size_t>(capacity_) * 2);
+      new (data() + size_) T(std::move(value));
+    } else {
+      new (data() + size_) T(std::forward<Args>(args)...);
+    }
+    return data()[size_++];
+  }
+
+  void pop_back() {
+    if (size_ > 0) {
+      --size_;
+      data()[size_].~T();
+    }
+  }
+
+  // INFO: Grows capacity to at least n, never shrinks
+  void reserve(size_t n) {
+    if (n > capacity_) {
+      grow_to(n);
+    }
+  }
+
+  // NOTE: Inline elements cannot trade places by pointer, so this goes
+  // through three moves
+  void swap(SmallArrayList &other) noexcept {
+    SmallArrayList tmp(std::move(other));
+    other = std::move(*this);
+    *this = std::move(tmp);
+  }
+
+  size_t size() const { return size_; }
+  size_t capacity() const { return capacity_; }
+  bool empty() const { return size_ == 0; }
+  void clear() { destroy_all(); }
+
+  T *begin() { return data(); }
+  T *end() { return data() + size_; }
+  const T *begin() const { return data(); }
+  const T *end() const { return data() + size_; }
+};
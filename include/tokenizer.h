@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// INFO: Word characters are ASCII letters, digits, apostrophes and hyphens
+inline bool is_word_char(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '\'' || c == '-';
+}
+
+inline bool is_word_special(char c) { return c == '\'' || c == '-'; }
+
+// NOTE: Reject words that start/end with, or repeat, a hyphen/apostrophe
+inline bool is_valid_word(std::string_view word) {
+  if (word.empty() || is_word_special(word.front()) ||
+      is_word_special(word.back())) {
+    return false;
+  }
+
+  bool prev_special = false;
+  for (char c : word) {
+    bool special = is_word_special(c);
+    if (special && prev_special) {
+      return false;
+    }
+    prev_special = special;
+  }
+  return true;
+}
+
+// NOTE: Character classification kernels, the best one is picked at runtime
+enum class TokenizerKernel { Scalar, SSE2, AVX2 };
+
+bool tokenizer_kernel_supported(TokenizerKernel kernel);
+TokenizerKernel best_tokenizer_kernel();
+const char *tokenizer_kernel_name(TokenizerKernel kernel);
+
+// INFO: Lowercase `size` bytes of src into dst and set bit (i % 64) of
+// mask[i / 64] when src[i] is a word character. Bits past `size` are cleared.
+void classify_block(TokenizerKernel kernel, const char *src, size_t size,
+                    char *dst, uint64_t *mask);
+
+inline unsigned count_trailing_zeros(uint64_t bits) {
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward64(&index, bits);
+  return static_cast<unsigned>(index);
+#else
+  return static_cast<unsigned>(__builtin_ctzll(bits));
+#endif
+}
+
+// INFO: Scan a contiguous span and call emit(std::string_view) with every
+// valid, lowercased word. The view is only valid for the duration of the call.
+template <typename Emit>
+void tokenize(TokenizerKernel kernel, const char *data, size_t size,
+              Emit &&emit) {
+  constexpr size_t BLOCK_SIZE = 4096;
+  char lower[BLOCK_SIZE];
+  uint64_t mask[BLOCK_SIZE / 64];
+
+  std::string carry; // INFO: Word that straddles a block boundary
+  bool in_word = false;
+  size_t start = 0;
+
+  auto finish = [&](const char *block, size_t end) {
+    std::string_view word;
+    if (carry.empty()) {
+      word = std::string_view(block + start, end - start);
+    } else {
+      carry.append(block, end);
+      word = carry;
+    }
+    if (is_valid_word(word)) {
+      emit(word);
+    }
+    carry.clear();
+    in_word = false;
+  };
+
+  for (size_t offset = 0; offset < size; offset += BLOCK_SIZE) {
+    size_t length = size - offset < BLOCK_SIZE ? size - offset : BLOCK_SIZE;
+    classify_block(kernel, data + offset, length, lower, mask);
+
+    // NOTE: Walk the mask by jumping between run starts and run ends
+    for (size_t w = 0; w * 64 < length; ++w) {
+      uint64_t bits = mask[w];
+      unsigned pos = 0;
+      while (pos < 64) {
+        uint64_t rest = (in_word ? ~bits : bits) >> pos;
+        if (rest == 0) {
+          break;
+        }
+        pos += count_trailing_zeros(rest);
+        if (in_word) {
+          finish(lower, w * 64 + pos);
+        } else {
+          start = w * 64 + pos;
+          in_word = true;
+        }
+      }
+    }
+
+    if (in_word) {
+      carry.append(lower + start, length - start);
+      start = 0;
+    }
+  }
+
+  if (in_word) {
+    finish(lower, 0);
+  }
+}
+
+template <typename Emit>
+void tokenize(const char *data, size_t size, Emit &&emit) {
+  static const TokenizerKernel kernel = best_tokenizer_kernel();
+  tokenize(kernel, data, size, std::forward<Emit>(emit));
+}
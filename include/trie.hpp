@@ -1,28 +1,105 @@
 #pragma once
 
 #include "array_list.hpp"
-#include "hashmap.hpp"
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
+// NOTE: A node of the radix trie. It holds the run of characters on the edge
+// into it, so a chain of single-child nodes is one node. Children are kept in
+// a small array sorted by their first character, searched linearly; once a
+// node has more than DENSE_CHILDREN it switches to a 256-slot table indexed
+// by that character. max_score bounds the score of every word in the subtree,
+// which is what lets top_k skip subtrees that cannot make the cut.
 class TrieNode {
 public:
-  char character;
+  std::string label; // INFO: Characters on the edge into this node
+  uint32_t score;     // INFO: The word's score when is_end_of_word
+  uint32_t max_score; // INFO: At least the score of any word below
   bool is_end_of_word;
-  HashMap<char, TrieNode *> children;
 
-  TrieNode(char character) : character(character), is_end_of_word(false) {}
+  explicit TrieNode(std::string label);
+  ~TrieNode(); // NOTE: Deletes the whole subtree
+  TrieNode(const TrieNode &) = delete;
+  TrieNode &operator=(const TrieNode &) = delete;
+
+  // INFO: Child whose label starts with c, nullptr if none
+  TrieNode *child(unsigned char c) const;
+  // INFO: Adds node, or replaces the child whose label starts with the same
+  // character
+  void set_child(TrieNode *node);
+  size_t num_children() const { return count; }
+
+  // INFO: Calls f(child) for every child in order of first character
+  template <typename F> void for_each_child(F f) const;
+
+private:
+  static constexpr uint16_t DENSE_CHILDREN = 48;
+  static constexpr uint16_t DENSE_SLOTS = 256;
+
+  TrieNode **children;
+  uint16_t count;
+  uint16_t capacity; // INFO: DENSE_SLOTS once the node is dense
+
+  bool dense() const { return capacity == DENSE_SLOTS; }
+  static unsigned char first(const TrieNode *node) {
+    return static_cast<unsigned char>(node->label[0]);
+  }
+};
+
+struct Completion {
+  std::string word;
+  uint32_t score;
+  uint8_t distance = 0; // INFO: Edits away from the query, fuzzy lookups only
 };
 
+// NOTE: Path-compressed (radix) trie over the vocabulary. Words come back
+// from search in lexicographic (byte) order, and from top_k best score first.
 class Trie {
 public:
-  TrieNode *root;
+  Trie() : root(new TrieNode("")) {}
+  ~Trie() { delete root; }
+  Trie(const Trie &) = delete;
+  Trie &operator=(const Trie &) = delete;
+
+  // INFO: score ranks the word in top_k (e.g. its corpus frequency).
+  // Inserting a word again replaces its score.
+  void insert(const std::string &word, uint32_t score = 0);
+  ArrayList<std::string> search(const std::string &prefix) const;
+
+  // NOTE: The k highest scoring words under prefix, best first. Best-first
+  // over the max_score bounds, so the work grows with k and the depth of
+  // the words found rather than with the number of words under the prefix.
+  ArrayList<Completion> top_k(const std::string &prefix, size_t k) const;
 
-  Trie() : root(new TrieNode('\0')) {}
+private:
+  friend class FlatTrie; // NOTE: Flattens the nodes into clouseau.ac
 
-  void insert(const std::string &word);
-  void collect_all_words(TrieNode *node, const std::string &prefix,
-                         ArrayList<std::string> &results);
+  TrieNode *root;
+
+  // INFO: Node reached by prefix, or nullptr. path is set to the word
+  // spelled by the edges down to that node, which extends prefix when it
+  // ends part way along an edge.
+  const TrieNode *find_prefix(const std::string &prefix,
+                              std::string &path) const;
 
-  ArrayList<std::string> search(const std::string &prefix);
+  // INFO: Appends every word under node; word holds the path to node and is
+  // restored before returning
+  void collect_all_words(const TrieNode *node, std::string &word,
+                         ArrayList<std::string> &results) const;
 };
+
+template <typename F> void TrieNode::for_each_child(F f) const {
+  if (dense()) {
+    for (uint16_t c = 0; c < DENSE_SLOTS; c++) {
+      if (children[c] != nullptr) {
+        f(children[c]);
+      }
+    }
+  } else {
+    for (uint16_t i = 0; i < count; i++) {
+      f(children[i]);
+    }
+  }
+}
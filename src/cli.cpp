@@ -1,5 +1,8 @@
 #include "cli.h"
+#include <cctype>
+#include <cstdint>
 #include <iostream>
+#include <stdexcept>
 
 CLI::CLI(std::string name, int argc, char *argv[]) {
   this->name = name;
@@ -39,3 +42,50 @@ void CLI::run() {
 
   (*iter).value.fn(args);
 }
+
+std::string get_option(const ArrayList<std::string> &args,
+                       const std::string &name, const std::string &fallback) {
+  for (size_t i = 0; i + 1 < args.size(); i++) {
+    if (args[i] == name) {
+      return args[i + 1];
+    }
+  }
+  return fallback;
+}
+
+size_t parse_size(const std::string &text) {
+  // NOTE: std::stoull skips whitespace and accepts a sign, so "-1" would
+  // wrap around to an unlimited size
+  if (text.empty() || !std::isdigit(static_cast<unsigned char>(text[0]))) {
+    throw std::invalid_argument("Size must start with a digit");
+  }
+  size_t pos = 0;
+  unsigned long long value = std::stoull(text, &pos);
+  std::string suffix = text.substr(pos);
+  int shift = 0;
+  if (suffix == "K" || suffix == "k") {
+    shift = 10;
+  } else if (suffix == "M" || suffix == "m") {
+    shift = 20;
+  } else if (suffix == "G" || suffix == "g") {
+    shift = 30;
+  } else if (!suffix.empty()) {
+    throw std::invalid_argument("Unknown size suffix");
+  }
+  if (value > (SIZE_MAX >> shift)) {
+    throw std::invalid_argument("Size too large");
+  }
+  return static_cast<size_t>(value) << shift;
+}
+
+ArrayList<std::string> positional_args(const ArrayList<std::string> &args) {
+  ArrayList<std::string> positional;
+  for (size_t i = 0; i < args.size(); i++) {
+    if (args[i].rfind("--", 0) == 0) {
+      i++; // NOTE: skip the flag's value too
+      continue;
+    }
+    positional.push_back(args[i]);
+  }
+  return positional;
+}
@@ -0,0 +1,444 @@
+#include "doc_bitmap.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DOC_BITMAP_SSE2 1
+#endif
+
+namespace {
+
+enum class Op { And, Or, AndNot };
+
+int popcount(uint64_t word) {
+#ifdef _MSC_VER
+  return static_cast<int>(__popcnt64(word));
+#else
+  return __builtin_popcountll(word);
+#endif
+}
+
+// INFO: target = target op source, over count words (count is even)
+void combine(uint64_t *target, const uint64_t *source, size_t count, Op op) {
+#ifdef DOC_BITMAP_SSE2
+  for (size_t i = 0; i < count; i += 2) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(target + i));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i));
+    __m128i result = op == Op::And  ? _mm_and_si128(a, b)
+                     : op == Op::Or ? _mm_or_si128(a, b)
+                                    : _mm_andnot_si128(b, a);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(target + i), result);
+  }
+#else
+  for (size_t i = 0; i < count; i++) {
+    target[i] = op == Op::And  ? target[i] & source[i]
+                : op == Op::Or ? target[i] | source[i]
+                               : target[i] & ~source[i];
+  }
+#endif
+}
+
+// INFO: Sets bits first..last, both inclusive
+void set_range(uint64_t *words, uint32_t first, uint32_t last) {
+  size_t first_word = first >> 6, last_word = last >> 6;
+  uint64_t first_mask = ~uint64_t(0) << (first & 63);
+  uint64_t last_mask = ~uint64_t(0) >> (63 - (last & 63));
+  if (first_word == last_word) {
+    words[first_word] |= first_mask & last_mask;
+    return;
+  }
+  words[first_word] |= first_mask;
+  for (size_t i = first_word + 1; i < last_word; i++) {
+    words[i] = ~uint64_t(0);
+  }
+  words[last_word] |= last_mask;
+}
+
+// NOTE: A run starts at every set bit whose lower neighbour is clear
+size_t count_runs(const uint64_t *words, size_t count) {
+  size_t runs = 0;
+  uint64_t carry = 0;
+  for (size_t i = 0; i < count; i++) {
+    runs += popcount(words[i] & ~((words[i] << 1) | carry));
+    carry = words[i] >> 63;
+  }
+  return runs;
+}
+
+} // namespace
+
+void DocBitmap::add_many(const uint32_t *docs, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    uint16_t key = static_cast<uint16_t>(docs[i] >> 16);
+    uint16_t low = static_cast<uint16_t>(docs[i] & 0xffff);
+    if (!containers_.empty() && containers_.back().key == key) {
+      Container &last = containers_.back();
+      if (last.kind == Kind::Array && last.cardinality < MAX_ARRAY &&
+          last.values.back() < low) {
+        last.values.push_back(low);
+        last.cardinality++;
+        continue;
+      }
+      if (last.kind == Kind::Bitmap) {
+        uint64_t bit = uint64_t(1) << (low & 63);
+        last.cardinality += (last.words[low >> 6] & bit) == 0;
+        last.words[low >> 6] |= bit;
+        continue;
+      }
+    }
+    add(docs[i]);
+  }
+}
+
+void DocBitmap::add(uint32_t doc) {
+  add_low(container_for(static_cast<uint16_t>(doc >> 16)),
+          static_cast<uint16_t>(doc & 0xffff));
+}
+
+bool DocBitmap::contains(uint32_t doc) const {
+  uint16_t key = static_cast<uint16_t>(doc >> 16);
+  auto it = std::lower_bound(
+      containers_.begin(), containers_.end(), key,
+      [](const Container &container, uint16_t k) { return container.key < k; });
+  return it != containers_.end() && it->key == key &&
+         contains_low(*it, static_cast<uint16_t>(doc & 0xffff));
+}
+
+size_t DocBitmap::cardinality() const {
+  size_t total = 0;
+  for (const Container &container : containers_) {
+    total += container.cardinality;
+  }
+  return total;
+}
+
+void DocBitmap::run_optimize() {
+  for (Container &container : containers_) {
+    if (container.kind == Kind::Bitmap) {
+      container = from_words(container.key, std::move(container.words));
+    } else if (container.kind == Kind::Array) {
+      size_t runs = 1;
+      for (size_t i = 1; i < container.values.size(); i++) {
+        runs += container.values[i] != container.values[i - 1] + 1;
+      }
+      if (4 * runs < 2 * container.values.size()) {
+        std::vector<uint16_t> pairs;
+        pairs.reserve(2 * runs);
+        for (uint16_t low : container.values) {
+          if (!pairs.empty() &&
+              pairs[pairs.size() - 2] + pairs.back() + 1 == low) {
+            pairs.back()++;
+          } else {
+            pairs.push_back(low);
+            pairs.push_back(0);
+          }
+        }
+        container.kind = Kind::Run;
+        container.values = std::move(pairs);
+      }
+    }
+  }
+}
+
+DocBitmap DocBitmap::intersect(const DocBitmap &other) const {
+  DocBitmap result;
+  size_t i = 0, j = 0;
+  while (i < containers_.size() && j < other.containers_.size()) {
+    const Container &a = containers_[i];
+    const Container &b = other.containers_[j];
+    if (a.key < b.key) {
+      i++;
+    } else if (b.key < a.key) {
+      j++;
+    } else {
+      Container both = intersect(a, b);
+      if (both.cardinality > 0) {
+        result.containers_.push_back(std::move(both));
+      }
+      i++;
+      j++;
+    }
+  }
+  return result;
+}
+
+DocBitmap DocBitmap::unite(const DocBitmap &other) const {
+  DocBitmap result;
+  result.containers_.reserve(containers_.size() + other.containers_.size());
+  size_t i = 0, j = 0;
+  while (i < containers_.size() || j < other.containers_.size()) {
+    if (j == other.containers_.size() ||
+        (i < containers_.size() &&
+         containers_[i].key < other.containers_[j].key)) {
+      result.containers_.push_back(containers_[i++]);
+    } else if (i == containers_.size() ||
+               other.containers_[j].key < containers_[i].key) {
+      result.containers_.push_back(other.containers_[j++]);
+    } else {
+      result.containers_.push_back(
+          unite(containers_[i++], other.containers_[j++]));
+    }
+  }
+  return result;
+}
+
+DocBitmap DocBitmap::difference(const DocBitmap &other) const {
+  DocBitmap result;
+  size_t j = 0;
+  for (const Container &a : containers_) {
+    while (j < other.containers_.size() && other.containers_[j].key < a.key) {
+      j++;
+    }
+    if (j < other.containers_.size() && other.containers_[j].key == a.key) {
+      Container rest = difference(a, other.containers_[j]);
+      if (rest.cardinality > 0) {
+        result.containers_.push_back(std::move(rest));
+      }
+    } else {
+      result.containers_.push_back(a);
+    }
+  }
+  return result;
+}
+
+size_t DocBitmap::size_in_bytes() const {
+  size_t bytes = sizeof(DocBitmap) + containers_.capacity() * sizeof(Container);
+  for (const Container &container : containers_) {
+    bytes += container.values.capacity() * sizeof(uint16_t) +
+             container.words.capacity() * sizeof(uint64_t);
+  }
+  return bytes;
+}
+
+DocBitmap::Container &DocBitmap::container_for(uint16_t key) {
+  auto it = std::lower_bound(
+      containers_.begin(), containers_.end(), key,
+      [](const Container &container, uint16_t k) { return container.key < k; });
+  if (it == containers_.end() || it->key != key) {
+    it = containers_.insert(it, Container{key, Kind::Array, 0, {}, {}});
+  }
+  return *it;
+}
+
+void DocBitmap::add_low(Container &container, uint16_t low) {
+  if (container.kind == Kind::Array) {
+    auto it = std::lower_bound(container.values.begin(),
+                               container.values.end(), low);
+    if (it != container.values.end() && *it == low) {
+      return;
+    }
+    container.values.insert(it, low);
+    container.cardinality++;
+    if (container.cardinality > MAX_ARRAY) {
+      container.words.assign(WORDS, 0);
+      to_words(container, container.words.data());
+      container.kind = Kind::Bitmap;
+      container.values = std::vector<uint16_t>();
+    }
+  } else if (container.kind == Kind::Bitmap) {
+    uint64_t bit = uint64_t(1) << (low & 63);
+    if ((container.words[low >> 6] & bit) == 0) {
+      container.words[low >> 6] |= bit;
+      container.cardinality++;
+    }
+  } else if (!contains_low(container, low)) {
+    std::vector<uint64_t> words(WORDS, 0);
+    to_words(container, words.data());
+    words[low >> 6] |= uint64_t(1) << (low & 63);
+    container = from_words(container.key, std::move(words));
+  }
+}
+
+bool DocBitmap::contains_low(const Container &container, uint16_t low) {
+  if (container.kind == Kind::Array) {
+    return std::binary_search(container.values.begin(),
+                              container.values.end(), low);
+  }
+  if (container.kind == Kind::Bitmap) {
+    return (container.words[low >> 6] >> (low & 63)) & 1;
+  }
+  // NOTE: Last run starting at or before low
+  size_t lo = 0, hi = container.values.size() / 2;
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if (container.values[2 * mid] <= low) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo > 0 && static_cast<uint32_t>(low - container.values[2 * lo - 2]) <=
+                       container.values[2 * lo - 1];
+}
+
+// INFO: ORs the container's bits into words
+void DocBitmap::to_words(const Container &container, uint64_t *words) {
+  if (container.kind == Kind::Array) {
+    for (uint16_t low : container.values) {
+      words[low >> 6] |= uint64_t(1) << (low & 63);
+    }
+  } else if (container.kind == Kind::Run) {
+    for (size_t i = 0; i < container.values.size(); i += 2) {
+      set_range(words, container.values[i],
+                static_cast<uint32_t>(container.values[i]) +
+                    container.values[i + 1]);
+    }
+  } else {
+    combine(words, container.words.data(), WORDS, Op::Or);
+  }
+}
+
+// NOTE: Picks the smallest container for the bits: runs at 4 bytes each,
+// an array at 2 bytes per doc, or the 8 KB bitmap
+DocBitmap::Container DocBitmap::from_words(uint16_t key,
+                                           std::vector<uint64_t> &&words) {
+  size_t cardinality = 0;
+  for (uint64_t word : words) {
+    cardinality += popcount(word);
+  }
+  size_t runs = count_runs(words.data(), WORDS);
+  size_t other_bytes = cardinality <= MAX_ARRAY ? 2 * cardinality
+                                                : WORDS * sizeof(uint64_t);
+
+  Container container{key, Kind::Bitmap, static_cast<uint32_t>(cardinality),
+                      {}, {}};
+  if (4 * runs < other_bytes) {
+    container.kind = Kind::Run;
+    container.values.reserve(2 * runs);
+    for (size_t i = 0; i < WORDS; i++) {
+      uint64_t word = words[i];
+      while (word != 0) {
+        int first = trailing_zeros(word);
+        uint64_t clear = ~(word | (word - 1)); // INFO: Zeros up to the run end
+        int end = clear == 0 ? 64 : trailing_zeros(clear);
+        uint32_t start = static_cast<uint32_t>(i * 64 + first);
+        uint32_t last = static_cast<uint32_t>(i * 64 + end - 1);
+        size_t size = container.values.size();
+        if (size > 0 && container.values[size - 2] +
+                                container.values[size - 1] + 1u ==
+                            start) {
+          // NOTE: The run carried on from the previous word
+          container.values[size - 1] =
+              static_cast<uint16_t>(last - container.values[size - 2]);
+        } else {
+          container.values.push_back(static_cast<uint16_t>(start));
+          container.values.push_back(static_cast<uint16_t>(last - start));
+        }
+        word = end == 64 ? 0 : word & (~uint64_t(0) << end);
+      }
+    }
+  } else if (cardinality <= MAX_ARRAY) {
+    container.kind = Kind::Array;
+    container.values.reserve(cardinality);
+    for (size_t i = 0; i < WORDS; i++) {
+      for (uint64_t word = words[i]; word != 0; word &= word - 1) {
+        container.values.push_back(
+            static_cast<uint16_t>(i * 64 + trailing_zeros(word)));
+      }
+    }
+  } else {
+    container.words = std::move(words);
+  }
+  return container;
+}
+
+DocBitmap::Container DocBitmap::from_array(uint16_t key,
+                                           std::vector<uint16_t> &&values) {
+  Container container{key, Kind::Array, static_cast<uint32_t>(values.size()),
+                      std::move(values), {}};
+  if (container.cardinality > MAX_ARRAY) {
+    container.words.assign(WORDS, 0);
+    to_words(container, container.words.data());
+    container.kind = Kind::Bitmap;
+    container.values = std::vector<uint16_t>();
+  }
+  return container;
+}
+
+// INFO: The array's values that are (or are not) in other
+DocBitmap::Container DocBitmap::filter(const Container &array,
+                                       const Container &other,
+                                       bool keep_present) {
+  std::vector<uint16_t> kept;
+  kept.reserve(array.values.size());
+  for (uint16_t low : array.values) {
+    if (contains_low(other, low) == keep_present) {
+      kept.push_back(low);
+    }
+  }
+  return from_array(array.key, std::move(kept));
+}
+
+DocBitmap::Container DocBitmap::intersect(const Container &a,
+                                          const Container &b) {
+  if (a.full()) {
+    return b;
+  }
+  if (b.full()) {
+    return a;
+  }
+  if (a.kind == Kind::Array && b.kind == Kind::Array) {
+    std::vector<uint16_t> both;
+    both.reserve(std::min(a.values.size(), b.values.size()));
+    std::set_intersection(a.values.begin(), a.values.end(), b.values.begin(),
+                          b.values.end(), std::back_inserter(both));
+    return from_array(a.key, std::move(both));
+  }
+  if (a.kind == Kind::Array) {
+    return filter(a, b, true);
+  }
+  if (b.kind == Kind::Array) {
+    return filter(b, a, true);
+  }
+  std::vector<uint64_t> words(WORDS, 0), other(WORDS, 0);
+  to_words(a, words.data());
+  to_words(b, other.data());
+  combine(words.data(), other.data(), WORDS, Op::And);
+  return from_words(a.key, std::move(words));
+}
+
+DocBitmap::Container DocBitmap::unite(const Container &a, const Container &b) {
+  if (a.full()) {
+    return a;
+  }
+  if (b.full()) {
+    return b;
+  }
+  if (a.kind == Kind::Array && b.kind == Kind::Array) {
+    std::vector<uint16_t> either;
+    either.reserve(a.values.size() + b.values.size());
+    std::set_union(a.values.begin(), a.values.end(), b.values.begin(),
+                   b.values.end(), std::back_inserter(either));
+    return from_array(a.key, std::move(either));
+  }
+  std::vector<uint64_t> words(WORDS, 0);
+  to_words(a, words.data());
+  to_words(b, words.data());
+  return from_words(a.key, std::move(words));
+}
+
+DocBitmap::Container DocBitmap::difference(const Container &a,
+                                           const Container &b) {
+  if (b.full()) {
+    return Container{a.key, Kind::Array, 0, {}, {}};
+  }
+  if (a.kind == Kind::Array) {
+    return filter(a, b, false);
+  }
+  std::vector<uint64_t> words(WORDS, 0);
+  to_words(a, words.data());
+  if (b.kind == Kind::Array) {
+    for (uint16_t low : b.values) {
+      words[low >> 6] &= ~(uint64_t(1) << (low & 63));
+    }
+  } else {
+    std::vector<uint64_t> other(WORDS, 0);
+    to_words(b, other.data());
+    combine(words.data(), other.data(), WORDS, Op::AndNot);
+  }
+  return from_words(a.key, std::move(words));
+}
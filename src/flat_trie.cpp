@@ -0,0 +1,616 @@
+#include "flat_trie.h"
+#include "byte_io.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+
+MappedFile open_flat_trie(const std::string &path) {
+  try {
+    return MappedFile(path, MappedFile::Access::Random);
+  } catch (const std::runtime_error &) {
+    throw std::runtime_error(
+        "Unable to open autocomplete file for reading, re-run index");
+  }
+}
+
+// INFO: A node still to be written: words [first, end) all start with its
+// path, which runs from byte start (the parent's path length) to length
+struct PendingNode {
+  uint32_t first;
+  uint32_t end;
+  uint32_t start;
+  uint32_t length;
+};
+
+// INFO: Removes the staging files however the write ends
+struct TemporaryFiles {
+  std::vector<std::string> paths;
+  ~TemporaryFiles() {
+    std::error_code ec;
+    for (const std::string &path : paths) {
+      std::filesystem::remove(path, ec);
+    }
+  }
+};
+
+size_t common_prefix(std::string_view a, std::string_view b, size_t from) {
+  size_t n = std::min(a.size(), b.size());
+  while (from < n && a[from] == b[from]) {
+    from++;
+  }
+  return from;
+}
+
+} // namespace
+
+FlatTrie::FlatTrie(const std::string &path)
+    : file_(open_flat_trie(path)), nodes_(nullptr), labels_(nullptr),
+      labels_size_(0), num_nodes_(0), num_words_(0) {
+  ByteReader in(file_.data(), file_.size());
+  if (in.remaining() < FLAT_TRIE_HEADER_SIZE) {
+    throw std::runtime_error("Unsupported autocomplete format, re-run index");
+  }
+  std::string_view magic = in.read_bytes(sizeof(FLAT_TRIE_MAGIC));
+  uint32_t version = in.read<uint32_t>();
+  if (!std::equal(magic.begin(), magic.end(), FLAT_TRIE_MAGIC) ||
+      version != FLAT_TRIE_VERSION) {
+    throw std::runtime_error("Unsupported autocomplete format, re-run index");
+  }
+  num_nodes_ = in.read<uint32_t>();
+  num_words_ = in.read<uint32_t>();
+  uint64_t labels_offset = in.read<uint64_t>();
+
+  if (num_nodes_ == 0 || labels_offset > file_.size() ||
+      labels_offset - FLAT_TRIE_HEADER_SIZE !=
+          static_cast<uint64_t>(num_nodes_) * FLAT_TRIE_NODE_SIZE) {
+    throw std::runtime_error("Autocomplete file is truncated");
+  }
+  nodes_ = file_.data() + FLAT_TRIE_HEADER_SIZE;
+  labels_ = file_.data() + labels_offset;
+  labels_size_ = file_.size() - labels_offset;
+}
+
+// NOTE: Breadth-first, so each node's children get consecutive indices
+void FlatTrie::write(const Trie &trie, const std::string &path) {
+  std::vector<const TrieNode *> order = {trie.root};
+  std::vector<uint32_t> first_child;
+  std::string labels;
+  std::string nodes;
+  uint32_t num_words = 0;
+  for (size_t i = 0; i < order.size(); i++) {
+    first_child.push_back(static_cast<uint32_t>(order.size()));
+    order[i]->for_each_child(
+        [&order](const TrieNode *child) { order.push_back(child); });
+  }
+  if (order.size() > UINT32_MAX) {
+    throw std::runtime_error("Too many trie nodes for the autocomplete file");
+  }
+
+  for (size_t i = 0; i < order.size(); i++) {
+    const TrieNode *trie_node = order[i];
+    if (trie_node->label.size() > UINT16_MAX ||
+        labels.size() > UINT32_MAX - trie_node->label.size()) {
+      throw std::runtime_error("Label too long for the autocomplete file");
+    }
+    append_value(nodes, static_cast<uint32_t>(labels.size()));
+    append_value(nodes, first_child[i]);
+    append_value(nodes, trie_node->score);
+    append_value(nodes, trie_node->max_score);
+    append_value(nodes, static_cast<uint16_t>(trie_node->label.size()));
+    append_value(nodes, static_cast<uint16_t>(trie_node->num_children()));
+    append_value(nodes, static_cast<uint8_t>(
+                            trie_node->label.empty() ? 0 : trie_node->label[0]));
+    append_value(nodes, static_cast<uint8_t>(trie_node->is_end_of_word));
+    append_value(nodes, static_cast<uint16_t>(0));
+    labels += trie_node->label;
+    num_words += trie_node->is_end_of_word;
+  }
+
+  // NOTE: Written beside the live file and renamed over it, so processes
+  // that have it mapped never see it truncated or half-written
+  TemporaryFiles staging{{path + ".tmp"}};
+  std::ofstream out(staging.paths[0], std::ios::binary | std::ios::trunc);
+  if (!out) {
+    throw std::runtime_error("Unable to open autocomplete file for writing");
+  }
+  out.write(FLAT_TRIE_MAGIC, sizeof(FLAT_TRIE_MAGIC));
+  write_value(out, FLAT_TRIE_VERSION);
+  write_value(out, static_cast<uint32_t>(order.size()));
+  write_value(out, num_words);
+  write_value(out, static_cast<uint64_t>(FLAT_TRIE_HEADER_SIZE + nodes.size()));
+  out.write(nodes.data(), static_cast<std::streamsize>(nodes.size()));
+  out.write(labels.data(), static_cast<std::streamsize>(labels.size()));
+  out.close();
+  if (!out) {
+    throw std::runtime_error("Unable to write autocomplete file");
+  }
+  std::filesystem::rename(staging.paths[0], path);
+}
+
+// NOTE: Level by level, so records come out in the breadth-first order of
+// write(const Trie &). A node's words are split by their byte at its path
+// length into one child each, whose path is the longest prefix its words
+// share; only the first word can end at the node itself. Labels are written
+// in the same order to a staging file that is appended last.
+void FlatTrie::write(size_t num_words,
+                     const std::function<ScoredWord(size_t)> &word_at,
+                     const std::string &path) {
+  if (num_words > UINT32_MAX) {
+    throw std::runtime_error("Too many words for the autocomplete file");
+  }
+  TemporaryFiles staging{{path + ".level", path + ".next", path + ".labels",
+                          path + ".tmp"}};
+  const std::string &level_path = staging.paths[0];
+  const std::string &next_path = staging.paths[1];
+
+  // NOTE: Renamed over path once complete, as in write(const Trie &)
+  std::ofstream out(staging.paths[3], std::ios::binary | std::ios::trunc);
+  std::ofstream labels(staging.paths[2], std::ios::binary);
+  if (!out || !labels) {
+    throw std::runtime_error("Unable to open autocomplete file for writing");
+  }
+  // NOTE: Header is rewritten once the counts are known
+  out.write(std::string(FLAT_TRIE_HEADER_SIZE, '\0').data(),
+            FLAT_TRIE_HEADER_SIZE);
+  {
+    std::ofstream root(level_path, std::ios::binary);
+    write_value(root, PendingNode{0, static_cast<uint32_t>(num_words), 0, 0});
+  }
+
+  uint64_t num_nodes = 0, level_nodes = 1, labels_size = 0;
+  uint32_t words = 0;
+  std::string previous;
+  while (level_nodes > 0) {
+    std::ifstream level(level_path, std::ios::binary);
+    std::ofstream next(next_path, std::ios::binary);
+    uint64_t next_nodes = 0;
+    uint64_t first_child = num_nodes + level_nodes;
+
+    for (uint64_t k = 0; k < level_nodes; k++) {
+      PendingNode node;
+      if (!level.read(reinterpret_cast<char *>(&node), sizeof(node))) {
+        throw std::runtime_error("Unable to write autocomplete file");
+      }
+
+      std::string_view label;
+      bool is_word = false;
+      uint32_t score = 0;
+      if (node.first < node.end) {
+        ScoredWord first = word_at(node.first);
+        label = first.word.substr(node.start, node.length - node.start);
+        is_word = first.word.size() == node.length;
+        score = is_word ? first.score : 0;
+      }
+      if (label.size() > UINT16_MAX ||
+          labels_size > UINT32_MAX - label.size()) {
+        throw std::runtime_error("Label too long for the autocomplete file");
+      }
+      uint32_t label_offset = static_cast<uint32_t>(labels_size);
+      uint8_t first_byte = label.empty() ? 0 : static_cast<uint8_t>(label[0]);
+      uint16_t label_length = static_cast<uint16_t>(label.size());
+      labels.write(label.data(), static_cast<std::streamsize>(label.size()));
+      labels_size += label.size();
+
+      uint32_t max_score = 0;
+      uint16_t children = 0;
+      PendingNode child{0, 0, node.length, 0};
+      auto add_child = [&]() {
+        write_value(next, child);
+        children++;
+      };
+      for (uint32_t i = node.first; i < node.end; i++) {
+        ScoredWord word = word_at(i);
+        max_score = std::max(max_score, word.score);
+        if (word.word.size() <= node.length) {
+          continue;
+        }
+        if (child.first < child.end &&
+            word.word[node.length] == previous[node.length]) {
+          child.length = static_cast<uint32_t>(std::min<size_t>(
+              child.length, common_prefix(previous, word.word,
+                                          node.length + 1)));
+        } else {
+          if (child.first < child.end) {
+            add_child();
+          }
+          child.first = i;
+          child.length = static_cast<uint32_t>(word.word.size());
+        }
+        child.end = i + 1;
+        previous.assign(word.word);
+      }
+      if (child.first < child.end) {
+        add_child();
+      }
+
+      if (first_child + next_nodes + children > UINT32_MAX) {
+        throw std::runtime_error(
+            "Too many trie nodes for the autocomplete file");
+      }
+      write_value(out, label_offset);
+      write_value(out, static_cast<uint32_t>(first_child + next_nodes));
+      write_value(out, score);
+      write_value(out, max_score);
+      write_value(out, label_length);
+      write_value(out, children);
+      write_value(out, first_byte);
+      write_value(out, static_cast<uint8_t>(is_word));
+      write_value(out, static_cast<uint16_t>(0));
+      next_nodes += children;
+      words += is_word;
+    }
+
+    level.close();
+    next.close();
+    if (!next) {
+      throw std::runtime_error("Unable to write autocomplete file");
+    }
+    std::filesystem::rename(next_path, level_path);
+    num_nodes += level_nodes;
+    level_nodes = next_nodes;
+  }
+
+  labels.close();
+  if (!labels) {
+    throw std::runtime_error("Unable to write autocomplete file");
+  }
+  append_file(out, staging.paths[2]);
+  out.seekp(0);
+  out.write(FLAT_TRIE_MAGIC, sizeof(FLAT_TRIE_MAGIC));
+  write_value(out, FLAT_TRIE_VERSION);
+  write_value(out, static_cast<uint32_t>(num_nodes));
+  write_value(out, words);
+  write_value(out, static_cast<uint64_t>(FLAT_TRIE_HEADER_SIZE +
+                                         num_nodes * FLAT_TRIE_NODE_SIZE));
+  out.close();
+  if (!out) {
+    throw std::runtime_error("Unable to write autocomplete file");
+  }
+  std::filesystem::rename(staging.paths[3], path);
+}
+
+ArrayList<std::string> FlatTrie::search(const std::string &prefix) const {
+  uint32_t index;
+  std::string word;
+  ArrayList<std::string> results;
+  if (find_prefix(prefix, index, word)) {
+    collect_all_words(index, word, results);
+  }
+  return results;
+}
+
+// NOTE: Trie::top_k over node indices: best-first on the max score bounds,
+// words spelled from parent links only when they are emitted
+ArrayList<Completion> FlatTrie::top_k(const std::string &prefix,
+                                      size_t k) const {
+  ArrayList<Completion> results;
+  uint32_t start;
+  std::string path;
+  if (k == 0 || !find_prefix(prefix, start, path)) {
+    return results;
+  }
+
+  struct Candidate {
+    uint32_t node;
+    size_t parent;
+    uint32_t rank;
+    bool word;
+  };
+  std::vector<Candidate> candidates;
+  auto worse = [&candidates](size_t a, size_t b) {
+    return candidates[a].rank != candidates[b].rank
+               ? candidates[a].rank < candidates[b].rank
+               : a > b;
+  };
+  std::priority_queue<size_t, std::vector<size_t>, decltype(worse)> queue(
+      worse);
+
+  candidates.push_back(Candidate{start, SIZE_MAX, node(start).max_score, false});
+  queue.push(0);
+  while (!queue.empty() && results.size() < k) {
+    size_t index = queue.top();
+    queue.pop();
+    Candidate candidate = candidates[index];
+    Node current = node(candidate.node);
+    if (candidate.word) {
+      std::string suffix;
+      for (size_t i = candidate.parent; i != 0; i = candidates[i].parent) {
+        std::string_view edge = label(node(candidates[i].node));
+        suffix.insert(suffix.begin(), edge.begin(), edge.end());
+      }
+      results.push_back(Completion{path + suffix, current.score});
+      continue;
+    }
+    if (current.is_word) {
+      candidates.push_back(Candidate{candidate.node, index, current.score, true});
+      queue.push(candidates.size() - 1);
+    }
+    for (uint32_t i = 0; i < current.children; i++) {
+      uint32_t child = current.first_child + i;
+      candidates.push_back(Candidate{child, index, node(child).max_score, false});
+      queue.push(candidates.size() - 1);
+    }
+  }
+  return results;
+}
+
+FlatTrie::Node FlatTrie::node(uint32_t index) const {
+  if (index >= num_nodes_) {
+    throw std::runtime_error("Autocomplete file references unknown node");
+  }
+  const char *record = nodes_ + static_cast<size_t>(index) * FLAT_TRIE_NODE_SIZE;
+  Node node;
+  std::memcpy(&node.label, record, 4);
+  std::memcpy(&node.first_child, record + 4, 4);
+  std::memcpy(&node.score, record + 8, 4);
+  std::memcpy(&node.max_score, record + 12, 4);
+  std::memcpy(&node.label_length, record + 16, 2);
+  std::memcpy(&node.children, record + 18, 2);
+  node.first = static_cast<uint8_t>(record[20]);
+  node.is_word = static_cast<uint8_t>(record[21]);
+  if (static_cast<uint64_t>(node.label) + node.label_length > labels_size_ ||
+      static_cast<uint64_t>(node.first_child) + node.children > num_nodes_) {
+    throw std::runtime_error("Autocomplete file is truncated");
+  }
+  return node;
+}
+
+std::string_view FlatTrie::label(const Node &node) const {
+  return std::string_view(labels_ + node.label, node.label_length);
+}
+
+// NOTE: Binary search on the first label byte stored in each child record
+bool FlatTrie::child(const Node &node, unsigned char c,
+                     uint32_t &index) const {
+  uint32_t lo = node.first_child, hi = node.first_child + node.children;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (static_cast<uint8_t>(nodes_[static_cast<size_t>(mid) *
+                                        FLAT_TRIE_NODE_SIZE +
+                                    20]) < c) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo < node.first_child + node.children && this->node(lo).first == c) {
+    index = lo;
+    return true;
+  }
+  return false;
+}
+
+bool FlatTrie::find_prefix(const std::string &prefix, uint32_t &index,
+                           std::string &path) const {
+  index = 0;
+  size_t pos = 0;
+  while (pos < prefix.size()) {
+    uint32_t next;
+    if (!child(node(index), static_cast<unsigned char>(prefix[pos]), next)) {
+      return false;
+    }
+    std::string_view edge = label(node(next));
+    size_t common = 1;
+    while (common < edge.size() && pos + common < prefix.size() &&
+           edge[common] == prefix[pos + common]) {
+      common++;
+    }
+    if (common < edge.size() && pos + common < prefix.size()) {
+      return false; // NOTE: Diverges inside the edge
+    }
+    path += edge;
+    index = next;
+    pos += common;
+  }
+  return true;
+}
+
+void FlatTrie::collect_all_words(uint32_t index, std::string &word,
+                                 ArrayList<std::string> &results) const {
+  Node current = node(index);
+  if (current.is_word) {
+    results.push_back(word);
+  }
+  for (uint32_t i = 0; i < current.children; i++) {
+    size_t length = word.size();
+    word += label(node(current.first_child + i));
+    collect_all_words(current.first_child + i, word, results);
+    word.resize(length);
+  }
+}
+
+ArrayList<Completion> FlatTrie::fuzzy_top_k(const std::string &prefix,
+                                            size_t k,
+                                            uint8_t max_edits) const {
+  if (prefix.size() > LevenshteinAutomaton::MAX_LENGTH) {
+    return top_k(prefix, k);
+  }
+  ArrayList<Completion> results;
+  if (k == 0) {
+    return results;
+  }
+  LevenshteinAutomaton automaton(prefix, max_edits);
+  LevenshteinAutomaton::State state = automaton.start();
+
+  std::vector<FuzzyMatch> seeds;
+  std::string path;
+  uint8_t covered = automaton.max_edits() + 1;
+  if (automaton.distance(state) < covered) {
+    covered = automaton.distance(state); // NOTE: Every word matches
+    seeds.push_back(FuzzyMatch{0, covered, ""});
+  }
+  fuzzy_walk(automaton, 0, state, path, covered, true, seeds);
+
+  // NOTE: top_k with one start per seed. A seed's words all take its
+  // distance, and seeds below it are closer, so its expansion skips them.
+  std::vector<uint32_t> seed_nodes;
+  for (const FuzzyMatch &seed : seeds) {
+    seed_nodes.push_back(seed.node);
+  }
+  std::sort(seed_nodes.begin(), seed_nodes.end());
+
+  struct Candidate {
+    uint32_t node;
+    size_t parent; // INFO: SIZE_MAX for a seed
+    uint32_t seed;
+    uint32_t rank;
+    uint8_t distance;
+    bool word;
+  };
+  std::vector<Candidate> candidates;
+  auto worse = [&candidates](size_t a, size_t b) {
+    const Candidate &x = candidates[a], &y = candidates[b];
+    if (x.distance != y.distance) {
+      return x.distance > y.distance;
+    }
+    return x.rank != y.rank ? x.rank < y.rank : a > b;
+  };
+  std::priority_queue<size_t, std::vector<size_t>, decltype(worse)> queue(
+      worse);
+
+  for (uint32_t i = 0; i < seeds.size(); i++) {
+    candidates.push_back(Candidate{seeds[i].node, SIZE_MAX, i,
+                                   node(seeds[i].node).max_score,
+                                   seeds[i].distance, false});
+    queue.push(candidates.size() - 1);
+  }
+  while (!queue.empty() && results.size() < k) {
+    size_t index = queue.top();
+    queue.pop();
+    Candidate candidate = candidates[index];
+    Node current = node(candidate.node);
+    if (candidate.word) {
+      std::string suffix;
+      for (size_t i = candidate.parent; candidates[i].parent != SIZE_MAX;
+           i = candidates[i].parent) {
+        std::string_view edge = label(node(candidates[i].node));
+        suffix.insert(suffix.begin(), edge.begin(), edge.end());
+      }
+      results.push_back(Completion{seeds[candidate.seed].path + suffix,
+                                   current.score, candidate.distance});
+      continue;
+    }
+    if (current.is_word) {
+      candidates.push_back(Candidate{candidate.node, index, candidate.seed,
+                                     current.score, candidate.distance, true});
+      queue.push(candidates.size() - 1);
+    }
+    for (uint32_t i = 0; i < current.children; i++) {
+      uint32_t child = current.first_child + i;
+      if (std::binary_search(seed_nodes.begin(), seed_nodes.end(), child)) {
+        continue;
+      }
+      candidates.push_back(Candidate{child, index, candidate.seed,
+                                     node(child).max_score,
+                                     candidate.distance, false});
+      queue.push(candidates.size() - 1);
+    }
+  }
+  return results;
+}
+
+ArrayList<Completion> FlatTrie::fuzzy_find(const std::string &word, size_t k,
+                                           uint8_t max_edits) const {
+  std::vector<FuzzyMatch> matches;
+  if (word.size() > LevenshteinAutomaton::MAX_LENGTH) {
+    uint32_t index;
+    std::string path;
+    if (find_prefix(word, index, path) && path == word &&
+        node(index).is_word) {
+      matches.push_back(FuzzyMatch{index, 0, word});
+    }
+  } else {
+    LevenshteinAutomaton automaton(word, max_edits);
+    LevenshteinAutomaton::State state = automaton.start();
+    std::string path;
+    if (automaton.distance(state) <= automaton.max_edits() &&
+        node(0).is_word) {
+      matches.push_back(FuzzyMatch{0, automaton.distance(state), ""});
+    }
+    fuzzy_walk(automaton, 0, state, path, automaton.max_edits() + 1, false,
+               matches);
+  }
+
+  std::vector<Completion> found;
+  for (FuzzyMatch &match : matches) {
+    found.push_back(Completion{std::move(match.path), node(match.node).score,
+                               match.distance});
+  }
+  std::sort(found.begin(), found.end(),
+            [](const Completion &a, const Completion &b) {
+              if (a.distance != b.distance) {
+                return a.distance < b.distance;
+              }
+              return a.score != b.score ? a.score > b.score : a.word < b.word;
+            });
+
+  ArrayList<Completion> results;
+  for (size_t i = 0; i < found.size() && i < k; i++) {
+    results.push_back(std::move(found[i]));
+  }
+  return results;
+}
+
+void FlatTrie::fuzzy_walk(const LevenshteinAutomaton &automaton,
+                          uint32_t index,
+                          const LevenshteinAutomaton::State &state,
+                          std::string &path, uint8_t covered, bool prefix,
+                          std::vector<FuzzyMatch> &matches) const {
+  const uint8_t max_edits = automaton.max_edits();
+  Node current = node(index);
+  for (uint32_t i = 0; i < current.children; i++) {
+    // NOTE: Most children are ruled out by their first character, which is
+    // read straight from the record before decoding the rest
+    uint32_t child = current.first_child + i;
+    LevenshteinAutomaton::State end = automaton.step(
+        state, static_cast<uint8_t>(
+                   nodes_[static_cast<size_t>(child) * FLAT_TRIE_NODE_SIZE +
+                          20]));
+    if (automaton.lower_bound(end) > max_edits) {
+      continue;
+    }
+    Node next = node(child);
+    std::string_view edge = label(next);
+
+    // NOTE: Step along the rest of the edge. A prefix can match part way
+    // along it, which still makes every word below the child a completion.
+    uint8_t best = std::min(covered, automaton.distance(end));
+    bool alive = true;
+    for (char c : edge.substr(1)) {
+      end = automaton.step(end, static_cast<unsigned char>(c));
+      best = std::min(best, automaton.distance(end));
+      if (automaton.lower_bound(end) > max_edits) {
+        alive = false;
+        break;
+      }
+    }
+    if (!alive && (!prefix || best == covered)) {
+      continue;
+    }
+
+    size_t length = path.size();
+    path += edge;
+    if (prefix) {
+      if (best < covered) {
+        matches.push_back(FuzzyMatch{child, best, path});
+      }
+      if (alive && automaton.lower_bound(end) < best) {
+        fuzzy_walk(automaton, child, end, path, best, true, matches);
+      }
+    } else {
+      if (next.is_word && automaton.distance(end) <= max_edits) {
+        matches.push_back(FuzzyMatch{child, automaton.distance(end), path});
+      }
+      fuzzy_walk(automaton, child, end, path, covered, false, matches);
+    }
+    path.resize(length);
+  }
+}
@@ -0,0 +1,179 @@
+#include "index_reader.h"
+#include "byte_io.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+
+void prefetch(const void *address) {
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(address);
+#else
+  (void)address;
+#endif
+}
+
+MappedFile open_index(const std::string &path) {
+  try {
+    return MappedFile(path, MappedFile::Access::Random);
+  } catch (const std::runtime_error &) {
+    throw std::runtime_error("Unable to open index file for reading");
+  }
+}
+
+} // namespace
+
+IndexReader::IndexReader(const std::string &path)
+    : file_(open_index(path)), term_table_(nullptr), num_terms_(0) {
+  ByteReader in(file_.data(), file_.size());
+  if (in.remaining() < INDEX_HEADER_SIZE) {
+    throw std::runtime_error("Unsupported index format, re-run index");
+  }
+  std::string_view magic = in.read_bytes(sizeof(INDEX_MAGIC));
+  uint32_t version = in.read<uint32_t>();
+  if (!std::equal(magic.begin(), magic.end(), INDEX_MAGIC) ||
+      version != INDEX_VERSION) {
+    throw std::runtime_error("Unsupported index format, re-run index");
+  }
+
+  uint32_t num_documents = in.read<uint32_t>();
+  num_terms_ = in.read<uint32_t>();
+  uint64_t documents_offset = in.read<uint64_t>();
+  uint64_t postings_offset = in.read<uint64_t>();
+  uint64_t dictionary_offset = in.read<uint64_t>();
+  uint64_t term_table_offset = in.read<uint64_t>();
+
+  // NOTE: Sections are laid out in order, the term table ends the file
+  if (documents_offset > postings_offset ||
+      postings_offset > dictionary_offset ||
+      dictionary_offset > term_table_offset ||
+      term_table_offset > file_.size() ||
+      file_.size() - term_table_offset != num_terms_ * sizeof(uint64_t)) {
+    throw std::runtime_error("Index file is truncated");
+  }
+
+  ByteReader documents(file_.data() + documents_offset,
+                       postings_offset - documents_offset);
+  documents_.reserve(num_documents);
+  for (uint32_t i = 0; i < num_documents; i++) {
+    Document document;
+    uint32_t name_length = documents.read<uint32_t>();
+    document.file.assign(documents.read_bytes(name_length));
+    document.size = documents.read<uint64_t>();
+    document.mtime = documents.read<int64_t>();
+    document.hash = documents.read<uint64_t>();
+    document.length = documents.read<uint32_t>();
+    documents_.push_back(std::move(document));
+  }
+  term_table_ = file_.data() + term_table_offset;
+}
+
+uint64_t IndexReader::entry_offset(size_t i) const {
+  uint64_t offset;
+  std::memcpy(&offset, term_table_ + i * sizeof(offset), sizeof(offset));
+  if (offset >= file_.size()) {
+    throw std::runtime_error("Index file is truncated");
+  }
+  return offset;
+}
+
+std::string_view IndexReader::term_at(size_t i) const {
+  uint64_t offset = entry_offset(i);
+  ByteReader in(file_.data() + offset, file_.size() - offset);
+  uint32_t length = in.read<uint32_t>();
+  return in.read_bytes(length);
+}
+
+TermInfo IndexReader::term(size_t i) const {
+  uint64_t offset = entry_offset(i);
+  ByteReader in(file_.data() + offset, file_.size() - offset);
+
+  TermInfo info;
+  uint32_t length = in.read<uint32_t>();
+  info.term = in.read_bytes(length);
+  info.total = in.read<uint32_t>();
+  info.df = in.read<uint32_t>();
+  uint64_t postings = in.read<uint64_t>();
+  info.postings_size = in.read<uint32_t>();
+  if (postings > file_.size() || file_.size() - postings < info.postings_size) {
+    throw std::runtime_error("Index file is truncated");
+  }
+  info.postings = file_.data() + postings;
+  return info;
+}
+
+// INFO: Lower bound over the sorted term table
+bool IndexReader::find(std::string_view term, TermInfo &info) const {
+  size_t low = 0, high = num_terms_;
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    if (term_at(mid) < term) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  if (low == num_terms_ || term_at(low) != term) {
+    return false;
+  }
+  info = this->term(low);
+  return true;
+}
+
+void IndexReader::find_many(const std::string_view *terms, size_t count,
+                            TermInfo *infos, bool *found) const {
+  std::vector<size_t> low(count, 0), high(count, num_terms_);
+
+  for (bool searching = true; searching;) {
+    searching = false;
+    for (size_t i = 0; i < count; i++) {
+      if (low[i] < high[i]) {
+        prefetch(term_table_ + (low[i] + (high[i] - low[i]) / 2) *
+                                   sizeof(uint64_t));
+      }
+    }
+    for (size_t i = 0; i < count; i++) {
+      if (low[i] < high[i]) {
+        prefetch(file_.data() +
+                 entry_offset(low[i] + (high[i] - low[i]) / 2));
+      }
+    }
+    for (size_t i = 0; i < count; i++) {
+      if (low[i] < high[i]) {
+        size_t mid = low[i] + (high[i] - low[i]) / 2;
+        if (term_at(mid) < terms[i]) {
+          low[i] = mid + 1;
+        } else {
+          high[i] = mid;
+        }
+        searching = true;
+      }
+    }
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    found[i] = low[i] != num_terms_ && term_at(low[i]) == terms[i];
+    if (found[i]) {
+      infos[i] = term(low[i]);
+    }
+  }
+}
+
+double IndexReader::idf(const TermInfo &info) const {
+  double idf = std::log(documents_.size() / (double)info.df);
+  return idf == -INFINITY ? 0 : idf;
+}
+
+double IndexReader::tf(uint32_t doc, uint32_t count) const {
+  if (doc >= documents_.size()) {
+    throw std::runtime_error("Index file references unknown document");
+  }
+  uint32_t length = documents_[doc].length;
+  return length == 0 ? 0 : count / (double)length;
+}
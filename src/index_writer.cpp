@@ -0,0 +1,134 @@
+#include "index_writer.h"
+#include "byte_io.h"
+#include "index_reader.h"
+#include "postings_codec.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+void encode_frequency(const Frequency &freq, std::string &out) {
+  // INFO: The codec wants doc IDs in increasing order
+  std::vector<std::pair<uint32_t, uint32_t>> postings;
+  postings.reserve(freq.files.size());
+  for (auto const &file_freq : freq.files) {
+    postings.emplace_back(file_freq.doc, static_cast<uint32_t>(file_freq.count));
+  }
+  std::sort(postings.begin(), postings.end());
+
+  std::vector<uint32_t> docs(postings.size()), counts(postings.size());
+  for (size_t i = 0; i < postings.size(); i++) {
+    docs[i] = postings[i].first;
+    counts[i] = postings[i].second;
+  }
+  encode_postings(docs.data(), counts.data(), docs.size(), out);
+}
+
+IndexWriter::IndexWriter(const std::string &path,
+                         const ArrayList<Document> &documents)
+    : path_(path), out_(temp_path(), std::ios::binary),
+      dictionary_(dictionary_path(), std::ios::binary),
+      term_table_(term_table_path(), std::ios::binary), dictionary_size_(0),
+      num_terms_(0), documents_offset_(INDEX_HEADER_SIZE),
+      num_documents_(static_cast<uint32_t>(documents.size())) {
+  if (!out_.is_open() || !dictionary_.is_open() || !term_table_.is_open()) {
+    throw std::runtime_error("Unable to open index file for writing");
+  }
+
+  // NOTE: Header is rewritten by finish() once the offsets are known
+  out_.write(std::string(INDEX_HEADER_SIZE, '\0').data(), INDEX_HEADER_SIZE);
+
+  for (const Document &document : documents) {
+    write_value(out_, static_cast<uint32_t>(document.file.length()));
+    out_.write(document.file.c_str(), document.file.length());
+    write_value(out_, document.size);
+    write_value(out_, document.mtime);
+    write_value(out_, document.hash);
+    write_value(out_, document.length);
+  }
+  postings_offset_ = static_cast<uint64_t>(out_.tellp());
+}
+
+void IndexWriter::add(const std::string &term, const Frequency &freq) {
+  uint64_t postings = static_cast<uint64_t>(out_.tellp());
+  encoded_.clear();
+  encode_frequency(freq, encoded_);
+  out_.write(encoded_.data(), encoded_.size());
+
+  entry_.clear();
+  append_value(entry_, static_cast<uint32_t>(term.length()));
+  entry_.append(term);
+  append_value(entry_, static_cast<uint32_t>(freq.total));
+  append_value(entry_, static_cast<uint32_t>(freq.files.size()));
+  append_value(entry_, postings);
+  append_value(entry_, static_cast<uint32_t>(encoded_.size()));
+  dictionary_.write(entry_.data(), entry_.size());
+  write_value(term_table_, dictionary_size_);
+  dictionary_size_ += entry_.size();
+  num_terms_++;
+}
+
+IndexWriter::~IndexWriter() {
+  dictionary_.close();
+  term_table_.close();
+  out_.close();
+  std::error_code ec;
+  std::filesystem::remove(temp_path(), ec);
+  std::filesystem::remove(dictionary_path(), ec);
+  std::filesystem::remove(term_table_path(), ec);
+}
+
+uint32_t IndexWriter::finish() {
+  dictionary_.close();
+  term_table_.close();
+  if (!dictionary_ || !term_table_) {
+    throw std::runtime_error("Unable to write index file");
+  }
+
+  uint64_t dictionary_offset = static_cast<uint64_t>(out_.tellp());
+  append_file(out_, dictionary_path());
+
+  // NOTE: Entry offsets were staged relative to the dictionary, which only
+  // now has a place in the file
+  uint64_t term_table_offset = static_cast<uint64_t>(out_.tellp());
+  std::ifstream entries(term_table_path(), std::ios::binary);
+  if (!entries.is_open()) {
+    throw std::runtime_error("Unable to write index file");
+  }
+  std::vector<uint64_t> chunk(8192);
+  size_t n;
+  do {
+    entries.read(reinterpret_cast<char *>(chunk.data()),
+                 static_cast<std::streamsize>(chunk.size() * sizeof(uint64_t)));
+    n = static_cast<size_t>(entries.gcount()) / sizeof(uint64_t);
+    for (size_t i = 0; i < n; i++) {
+      chunk[i] += dictionary_offset;
+    }
+    out_.write(reinterpret_cast<const char *>(chunk.data()),
+               static_cast<std::streamsize>(n * sizeof(uint64_t)));
+  } while (n == chunk.size());
+  entries.close();
+  std::filesystem::remove(dictionary_path());
+  std::filesystem::remove(term_table_path());
+
+  out_.seekp(0);
+  out_.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+  write_value(out_, INDEX_VERSION);
+  write_value(out_, num_documents_);
+  write_value(out_, num_terms_);
+  write_value(out_, documents_offset_);
+  write_value(out_, postings_offset_);
+  write_value(out_, dictionary_offset);
+  write_value(out_, term_table_offset);
+  out_.close();
+
+  if (!out_) {
+    throw std::runtime_error("Unable to write index file");
+  }
+
+  // NOTE: Replaces the old index in one step, mappings of it stay valid
+  std::filesystem::rename(temp_path(), path_);
+  return num_terms_;
+}
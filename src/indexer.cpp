@@ -1,16 +1,26 @@
 #include "indexer.h"
 #include "array_list.hpp"
+#include "flat_trie.h"
+#include "hash_policy.hpp"
 #include "hashmap.hpp"
+#include "index_reader.h"
+#include "index_writer.h"
+#include "byte_io.h"
+#include "mapped_file.h"
+#include "postings_codec.h"
+#include "tokenizer.h"
 
 #include <algorithm>
-#include <cctype>
 #include <cmath>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <queue>
 #include <stdexcept>
 #include <string>
 #include <thread>
+#include <vector>
 
 #ifdef _WIN32
 #include <direct.h>
@@ -19,9 +29,105 @@
 #include <unistd.h>
 #endif
 
+namespace {
+
+// NOTE: One run file record: word, total, then the compressed postings. The
+// lengths are fixed width so a record can be skipped without decoding it.
+void write_entry(std::ostream &out, const std::string &word,
+                 const Frequency &freq) {
+  write_value(out, static_cast<uint32_t>(word.length()));
+  out.write(word.c_str(), word.length());
+  write_value(out, static_cast<uint32_t>(freq.total));
+
+  std::string encoded;
+  encode_frequency(freq, encoded);
+  write_value(out, static_cast<uint32_t>(encoded.size()));
+  out.write(encoded.data(), encoded.size());
+}
+
+// INFO: Appends postings (doc and count, tf left at 0) to freq.files
+void read_entry(ByteReader &in, std::string &word, Frequency &freq) {
+  uint32_t word_length = in.read<uint32_t>();
+  word.assign(in.read_bytes(word_length));
+  freq.total = static_cast<int>(in.read<uint32_t>());
+  freq.idf = 0;
+
+  uint32_t encoded_length = in.read<uint32_t>();
+  std::string_view encoded = in.read_bytes(encoded_length);
+
+  PostingsDecoder decoder(encoded.data(), encoded.size());
+  uint32_t docs[POSTINGS_BLOCK_SIZE], counts[POSTINGS_BLOCK_SIZE];
+  for (size_t n = decoder.next(docs, counts); n > 0;
+       n = decoder.next(docs, counts)) {
+    for (size_t i = 0; i < n; i++) {
+      freq.files.push_back(
+          FileFrequency{docs[i], static_cast<int>(counts[i]), 0.0});
+    }
+  }
+}
+
+// INFO: Rough heap cost of a new term and of one posting, for --max-memory
+size_t term_bytes(const std::string &word) {
+  // NOTE: A HashMap term is one entry (key, value and cached hash) in an
+  // array grown by doubling, charged at 1.5x for the spare room, plus a
+  // control byte and a 4-byte slot index at up to 7/8 load
+  constexpr size_t ENTRY = sizeof(std::string) + sizeof(Frequency) +
+                           sizeof(uint64_t);
+  constexpr size_t SLOT = (sizeof(int8_t) + sizeof(uint32_t)) * 8 / 7;
+  return ENTRY * 3 / 2 + SLOT + word.capacity();
+}
+
+constexpr size_t POSTING_BYTES = sizeof(FileFrequency);
+
+// NOTE: Add one file's word counts to a local index, returns bytes added
+template <typename Map>
+size_t add_postings(Map &local_index, uint32_t doc,
+                    HashMap<std::string, int> &word_count) {
+  int total_words = word_count["__total_words__"];
+  word_count.erase("__total_words__");
+
+  size_t bytes = 0;
+  for (auto const &pair : word_count) {
+    FileFrequency file_freq{doc, pair.value,
+                            pair.value / (double)total_words};
+    bytes += POSTING_BYTES;
+
+    auto entry = local_index.try_emplace(pair.key);
+    if (entry.second) {
+      bytes += term_bytes(pair.key);
+    }
+    Frequency &freq = entry.first->value;
+    freq.total += pair.value;
+    freq.files.push_back(file_freq);
+  }
+  return bytes;
+}
+
+// INFO: renumber_documents' new ID for a dropped document
+constexpr uint32_t DROPPED_DOC = UINT32_MAX;
+
+void report_changes(int added, int modified, int removed, size_t num_files) {
+  std::cout << "Added " << added << ", modified " << modified << ", removed "
+            << removed << ", unchanged "
+            << static_cast<int>(num_files) - added - modified << " files"
+            << std::endl;
+}
+
+double inverse_document_frequency(size_t num_files, size_t df) {
+  double idf = std::log(num_files / (double)df);
+  return idf == -INFINITY ? 0 : idf;
+}
+
+} // namespace
+
+const Set<std::string> Indexer::stopwords = {
+    "the", "and", "is", "in", "it", "of", "to", "a",  "that", "with",
+    "for", "on",  "as", "by", "at", "an", "be", "or", "not"};
+
 Indexer::Indexer(const std::string &directory) {
   this->directory = directory;
   this->indexFile = "clouseau.idx";
+  this->autocompleteFile = "clouseau.ac";
 
   if (!std::filesystem::exists(directory)) { // Exists?
     throw std::runtime_error("Directory does not exist");
@@ -55,302 +161,650 @@ ArrayList<std::string> Indexer::get_directory_files() {
   return files;
 }
 
+Document Indexer::stat_file(const std::string &file) const {
+  std::string path = directory + "/" + file;
+  Document document{file, 0, 0, 0, 0};
+  document.size = std::filesystem::file_size(path);
+  document.mtime = static_cast<int64_t>(
+      std::filesystem::last_write_time(path).time_since_epoch().count());
+  return document;
+}
+
 // NOTE: Do word count for one file
-HashMap<std::string, int> Indexer::file_word_count(const std::string &file) {
+HashMap<std::string, int> Indexer::file_word_count(const std::string &file,
+                                                   Document &document) {
   HashMap<std::string, int> word_count;
-  std::ifstream input(directory + "/" + file,
-                      std::ios::binary); // Binary mode for faster reading
-  if (!input.is_open()) {
-    throw std::runtime_error("Could not open file");
-  }
 
-  // Pre-allocate buffers
-  const size_t BUFFER_SIZE = 16384; // 16KB buffer
-  std::string buffer;
-  buffer.reserve(BUFFER_SIZE);
+  // INFO: Whole file as one span (mmap, or one large read as a fallback)
+  MappedFile input(directory + "/" + file);
+  document = stat_file(file);
+  document.hash = hash_bytes(input.data(), input.size());
+
   std::string word;
   word.reserve(100); // Reserve space for reasonably sized words
-
   int total_words = 0;
-  char c;
-  bool in_word = false;
 
-  // Read file in chunks
-  while (input.get(c)) {
-    if (c >= 'A' && c <= 'Z') {
-      c += 32; // Fast lowercase conversion for ASCII
+  tokenize(input.data(), input.size(), [&](std::string_view token) {
+    word.assign(token);
+    if (!stopwords.contains(word)) {
+      word_count[word]++;
+      total_words++;
     }
+  });
 
-    // Check if character is valid for a word
-    bool is_valid = (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') ||
-                    (c == '\'' || c == '-');
+  document.length = static_cast<uint32_t>(total_words);
 
-    if (is_valid) {
-      if (!in_word) {
-        word.clear();
-        in_word = true;
-      }
-      word += c;
-    }
+  word_count["__total_words__"] = total_words;
+  return word_count;
+}
 
-    // Word boundary found
-    else if (in_word) {
-      if (word.length() > 0) {
-        // Handle contractions and hyphenated words
-        bool valid_word = true;
-        if (word.front() == '\'' || word.front() == '-' ||
-            word.back() == '\'' || word.back() == '-') {
-          valid_word = false;
-        }
+void Indexer::index_selection(
+    IndexJob &job, ShardedHashMap<std::string, Frequency> &local_index) {
+  int total_files = static_cast<int>(job.files.size());
 
-        // Check for multiple hyphens/apostrophes
-        bool prev_special = false;
-        for (size_t i = 0; valid_word && i < word.length(); ++i) {
-          if (word[i] == '\'' || word[i] == '-') {
-            if (prev_special) {
-              valid_word = false;
-              break;
-            }
-            prev_special = true;
-          } else {
-            prev_special = false;
-          }
-        }
+  // NOTE: Shared cursor - each worker claims the next (largest) unclaimed file
+  for (size_t i = job.next_file++; i < job.files.size(); i = job.next_file++) {
+    uint32_t doc = job.first_doc + static_cast<uint32_t>(i);
+    HashMap<std::string, int> word_count =
+        file_word_count(job.files[i], documents[doc]);
+    add_postings(local_index, doc, word_count);
 
-        if (valid_word && !stopwords.contains(word)) {
-          word_count[word]++;
-          total_words++;
+    // Update progress
+    int current = ++job.processed_files;
+    int percentage = (current * 100) / total_files;
+    std::cout << "\r" << percentage << "% (" << current << "/" << total_files
+              << " files)" << std::flush;
+  }
+}
+
+// NOTE: Each shard is only ever touched by the one worker that claimed it,
+// so no lock is needed
+void Indexer::merge_shards(
+    std::atomic<size_t> &next_shard,
+    std::vector<std::unique_ptr<ShardedHashMap<std::string, Frequency>>>
+        &local_indexes) {
+  for (size_t s = next_shard++; s < index.shard_count(); s = next_shard++) {
+    HashMap<std::string, Frequency> &target = index.shard(s);
+
+    // NOTE: Worker vocabularies mostly overlap, so room for the largest one
+    // is reserved once and any terms past it grow the shard as usual
+    size_t largest = 0;
+    for (auto &local_index : local_indexes) {
+      largest = std::max(largest, local_index->shard(s).size());
+    }
+    target.reserve(target.size() + largest);
+
+    for (auto &local_index : local_indexes) {
+      HashMap<std::string, Frequency> &source = local_index->shard(s);
+
+      // NOTE: First sighting of a term moves the whole Frequency over, later
+      // ones move their postings onto the longer of the two lists
+      for (auto &pair : source) {
+        auto entry =
+            target.try_emplace(std::move(pair.key), std::move(pair.value));
+        if (!entry.second) {
+          Frequency &freq = entry.first->value;
+          PostingsList &files = pair.value.files;
+          freq.total += pair.value.total;
+          if (freq.files.size() < files.size()) {
+            std::swap(freq.files, files);
+          }
+          for (auto &file_freq : files) {
+            freq.files.push_back(std::move(file_freq));
+          }
         }
       }
-      in_word = false;
+      source.clear();
     }
   }
+}
 
-  // Process last word if file ends with word character
-  if (in_word && !stopwords.contains(word)) {
-    word_count[word]++;
-    total_words++;
+// NOTE: Largest files first, so the last files handed out are the cheap ones
+void Indexer::sort_files_by_size(ArrayList<std::string> &file_list) const {
+  std::vector<std::pair<std::uintmax_t, std::string>> sized;
+  sized.reserve(file_list.size());
+  for (const std::string &file : file_list) {
+    std::error_code ec;
+    std::uintmax_t size = std::filesystem::file_size(directory + "/" + file, ec);
+    sized.emplace_back(ec ? 0 : size, file);
   }
 
-  word_count["__total_words__"] = total_words;
-  return word_count;
+  std::stable_sort(sized.begin(), sized.end(), [](const auto &a, const auto &b) {
+    return a.first > b.first;
+  });
+
+  for (size_t i = 0; i < sized.size(); i++) {
+    file_list[i] = std::move(sized[i].second);
+  }
+}
+
+int Indexer::resolve_threads(int num_threads, size_t num_files) const {
+  if (num_threads <= 0)
+    num_threads = std::thread::hardware_concurrency();
+  if (num_threads > static_cast<int>(num_files))
+    num_threads = static_cast<int>(num_files);
+  if (num_threads <= 0)
+    num_threads = 1;
+  return num_threads;
+}
+
+// NOTE: Slots are reserved up front so workers can fill documents[doc]
+// without touching the table's size
+void Indexer::prepare_job(IndexJob &job) {
+  sort_files_by_size(job.files);
+  job.first_doc = static_cast<uint32_t>(documents.size());
+  for (size_t i = 0; i < job.files.size(); i++) {
+    document_ids[job.files[i]] = job.first_doc + static_cast<uint32_t>(i);
+    documents.push_back(Document{job.files[i], 0, 0, 0, 0});
+  }
 }
 
-void Indexer::index_selection(const ArrayList<std::string> &files,
-                              std::atomic<int> &processed_files,
-                              int total_files) {
-  HashMap<std::string, Frequency> local_index;
+void Indexer::index_files(IndexJob &job, int num_threads) {
+  num_threads = resolve_threads(num_threads, job.files.size());
+  prepare_job(job);
+
+  // Phase 1: tokenize into per-thread indexes, pre-partitioned like `index`
+  std::vector<std::unique_ptr<ShardedHashMap<std::string, Frequency>>>
+      local_indexes;
+  for (int i = 0; i < num_threads; i++) {
+    local_indexes.push_back(
+        std::make_unique<ShardedHashMap<std::string, Frequency>>(
+            index.shard_count()));
+  }
+
+  ArrayList<std::thread> threads;
+  for (int i = 0; i < num_threads; i++) {
+    threads.push_back(std::thread(&Indexer::index_selection, this,
+                                  std::ref(job), std::ref(*local_indexes[i])));
+  }
+
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  // Phase 2: merge shard by shard in parallel
+  threads.clear();
+  std::atomic<size_t> next_shard(0);
+  for (int i = 0; i < num_threads; i++) {
+    threads.push_back(std::thread(&Indexer::merge_shards, this,
+                                  std::ref(next_shard),
+                                  std::ref(local_indexes)));
+  }
+
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+}
+
+void Indexer::index_directory(int num_threads) {
+  IndexJob job;
+  job.files = files;
+  index_files(job, num_threads);
+  compute_idf();
+}
+
+IndexChange Indexer::update_index(int num_threads) {
+  ManifestDiff diff;
+  try {
+    IndexReader reader(directory + "/" + indexFile);
+    diff = diff_manifest(reader.documents());
+  } catch (const std::runtime_error &) { // NOTE: Missing, older or damaged
+    index_directory(num_threads);
+    return IndexChange::Postings;
+  }
+
+  report_changes(diff.added, diff.modified, diff.removed, files.size());
+  if (diff.changed.empty() && diff.stale.empty() && diff.touched.empty()) {
+    return IndexChange::None;
+  }
+
+  try {
+    deserialize_index();
+  } catch (const std::runtime_error &) { // NOTE: Damaged postings
+    index.clear();
+    documents = ArrayList<Document>();
+    document_ids.clear();
+    index_directory(num_threads);
+    return IndexChange::Postings;
+  }
+  for (auto &pair : diff.touched) {
+    documents[document_ids[pair.key]].mtime = pair.value;
+  }
+  if (diff.changed.empty() && diff.stale.empty()) {
+    return IndexChange::Manifest;
+  }
+
+  IndexJob job;
+  job.files = diff.changed;
+  if (!diff.stale.empty()) {
+    remove_documents(diff.stale);
+  }
+  if (!job.files.empty()) {
+    index_files(job, num_threads);
+  }
+  compute_idf();
+  return IndexChange::Postings;
+}
+
+Indexer::ManifestDiff
+Indexer::diff_manifest(const ArrayList<Document> &saved) const {
+  ManifestDiff diff;
+  HashMap<std::string, uint32_t> saved_ids;
+  for (size_t doc = 0; doc < saved.size(); doc++) {
+    saved_ids[saved[doc].file] = static_cast<uint32_t>(doc);
+  }
+  HashMap<std::string, bool> present; // Still in the directory
 
   for (const std::string &file : files) {
-    HashMap<std::string, int> word_count = file_word_count(file);
-    int total_words = word_count["__total_words__"];
-    word_count.erase("__total_words__");
-
-    for (auto const &pair : word_count) {
-      FileFrequency file_freq{file, pair.value,
-                              pair.value / (double)total_words};
-
-      if (local_index.find(pair.key) == local_index.end()) {
-        Frequency freq;
-        freq.total = pair.value;
-        freq.files.push_back(file_freq);
-        local_index[pair.key] = freq;
-      } else {
-        local_index[pair.key].total += pair.value;
-        local_index[pair.key].files.push_back(file_freq);
-      }
+    present[file] = true;
+    auto it = saved_ids.find(file);
+    if (it == saved_ids.end()) {
+      diff.changed.push_back(file);
+      diff.added++;
+      continue;
     }
 
-    // Update progress
-    int current = ++processed_files;
-    int percentage = (current * 100) / total_files;
-    std::cout << "\r" << percentage << "% (" << current << "/" << total_files
-              << " files)" << std::flush;
+    const Document &known = saved[(*it).value];
+    Document current = stat_file(file);
+    if (current.size == known.size && current.mtime == known.mtime) {
+      continue;
+    }
+
+    // INFO: Touched but identical contents only needs a new mtime
+    MappedFile input(directory + "/" + file);
+    if (hash_bytes(input.data(), input.size()) == known.hash) {
+      diff.touched[file] = current.mtime;
+      continue;
+    }
+
+    diff.stale[file] = true;
+    diff.changed.push_back(file);
+    diff.modified++;
+  }
+
+  for (const Document &document : saved) {
+    if (present.find(document.file) == present.end()) {
+      diff.stale[document.file] = true;
+      diff.removed++;
+    }
+  }
+  return diff;
+}
+
+void Indexer::load_documents(const ArrayList<Document> &saved,
+                             ManifestDiff &diff) {
+  documents = saved;
+  document_ids.clear();
+  for (size_t doc = 0; doc < documents.size(); doc++) {
+    document_ids[documents[doc].file] = static_cast<uint32_t>(doc);
   }
+  for (auto &pair : diff.touched) {
+    documents[document_ids[pair.key]].mtime = pair.value;
+  }
+}
+
+std::vector<uint32_t>
+Indexer::renumber_documents(HashMap<std::string, bool> &stale) {
+  // Old doc ID -> new doc ID, keeping the survivors in order
+  std::vector<uint32_t> remap(documents.size(), DROPPED_DOC);
+  ArrayList<Document> kept_documents;
+  document_ids.clear();
+  for (size_t doc = 0; doc < documents.size(); doc++) {
+    if (stale.find(documents[doc].file) != stale.end()) {
+      continue;
+    }
+    remap[doc] = static_cast<uint32_t>(kept_documents.size());
+    document_ids[documents[doc].file] = remap[doc];
+    kept_documents.push_back(documents[doc]);
+  }
+  documents = std::move(kept_documents);
+  return remap;
+}
 
-  {
-    std::lock_guard<std::mutex> lock(index_mutex);
-    for (auto const &pair : local_index) {
-      if (index.find(pair.key) == index.end()) {
-        index[pair.key] = pair.value;
+void Indexer::remove_documents(HashMap<std::string, bool> &stale) {
+  std::vector<uint32_t> remap = renumber_documents(stale);
+
+  ArrayList<std::string> empty_terms;
+  for (auto &pair : index) {
+    Frequency &freq = pair.value;
+    PostingsList kept;
+
+    for (const auto &file_freq : freq.files) {
+      if (remap[file_freq.doc] == DROPPED_DOC) {
+        freq.total -= file_freq.count;
       } else {
-        index[pair.key].total += pair.value.total;
-        for (const auto &file_freq : pair.value.files) {
-          index[pair.key].files.push_back(file_freq);
-        }
+        kept.push_back(
+            FileFrequency{remap[file_freq.doc], file_freq.count, file_freq.tf});
       }
     }
+
+    if (kept.empty()) {
+      empty_terms.push_back(pair.key);
+    } else {
+      freq.files = std::move(kept);
+    }
+  }
+
+  for (const std::string &term : empty_terms) {
+    index.erase(term);
   }
 }
 
-void Indexer::index_directory() {
-  int num_threads = std::thread::hardware_concurrency();
-  if (num_threads == 0)
-    num_threads = 1;
+void Indexer::compute_idf() {
+  for (auto &pair : index) {
+    pair.value.idf =
+        inverse_document_frequency(files.size(), pair.value.files.size());
+  }
+}
 
-  ArrayList<std::thread> threads;
-  int files_per_thread =
-      static_cast<int>(std::ceil(files.size() / (double)num_threads));
+void Indexer::index_directory_external(size_t max_memory, int num_threads) {
+  IndexJob job;
+  job.files = files;
+  merge_runs(spill_files(job, max_memory, num_threads));
+  write_autocomplete();
+}
 
-  // Atomic counter for progress tracking
-  std::atomic<int> processed_files(0);
-  int total_files = static_cast<int>(files.size());
+IndexChange Indexer::update_index_external(size_t max_memory,
+                                           int num_threads) {
+  std::unique_ptr<IndexReader> base;
+  ManifestDiff diff;
+  try {
+    base = std::make_unique<IndexReader>(directory + "/" + indexFile);
+    diff = diff_manifest(base->documents());
+  } catch (const std::runtime_error &) { // NOTE: Missing, older or damaged
+    index_directory_external(max_memory, num_threads);
+    return IndexChange::Postings;
+  }
 
-  for (int i = 0; i < num_threads; i++) {
-    ArrayList<std::string> thread_files;
-    int start = i * files_per_thread;
-    int end = std::min(start + files_per_thread, (int)files.size());
+  report_changes(diff.added, diff.modified, diff.removed, files.size());
+  if (diff.changed.empty() && diff.stale.empty() && diff.touched.empty()) {
+    return IndexChange::None;
+  }
 
-    if (start >= files.size())
-      break;
+  // NOTE: Survivors keep their order and come first, then the changed files
+  load_documents(base->documents(), diff);
+  std::vector<uint32_t> remap = renumber_documents(diff.stale);
+  IndexJob job;
+  job.files = diff.changed;
+  int num_runs = spill_files(job, max_memory, num_threads);
+
+  // NOTE: The new file is renamed over the mapped one, so base stays whole
+  // until the merge is done
+  merge_runs(num_runs, base.get(), &remap);
+  if (diff.changed.empty() && diff.stale.empty()) {
+    return IndexChange::Manifest;
+  }
+  base.reset();
+  write_autocomplete();
+  return IndexChange::Postings;
+}
 
-    for (int j = start; j < end; j++) {
-      thread_files.push_back(files[j]);
-    }
+int Indexer::spill_files(IndexJob &job, size_t max_memory, int num_threads) {
+  num_threads = resolve_threads(num_threads, job.files.size());
+  prepare_job(job);
 
-    threads.push_back(std::thread(&Indexer::index_selection, this, thread_files,
-                                  std::ref(processed_files), total_files));
+  // NOTE: Every worker gets an equal slice of the memory budget
+  size_t budget = std::max<size_t>(max_memory / num_threads, 1);
+
+  ArrayList<std::thread> threads;
+  std::atomic<int> next_run(0);
+
+  for (int i = 0; i < num_threads; i++) {
+    threads.push_back(std::thread(&Indexer::spill_selection, this,
+                                  std::ref(job), budget, std::ref(next_run)));
   }
 
   for (std::thread &thread : threads) {
     thread.join();
   }
+  return next_run.load();
+}
 
-  for (auto &pair : index) {
-    pair.value.idf = std::log(files.size() / (double)pair.value.files.size());
-    if (pair.value.idf == -INFINITY) {
-      pair.value.idf = 0;
+void Indexer::spill_selection(IndexJob &job, size_t budget,
+                              std::atomic<int> &next_run) {
+  int total_files = static_cast<int>(job.files.size());
+
+  // NOTE: Replaced after a spill so every bucket and posting list is freed
+  // (HashMap::clear keeps them)
+  auto local_index = std::make_unique<HashMap<std::string, Frequency>>();
+  size_t used = 0;
+
+  for (size_t i = job.next_file++; i < job.files.size(); i = job.next_file++) {
+    uint32_t doc = job.first_doc + static_cast<uint32_t>(i);
+    HashMap<std::string, int> word_count =
+        file_word_count(job.files[i], documents[doc]);
+    used += add_postings(*local_index, doc, word_count);
+
+    if (used >= budget) {
+      write_run(*local_index, next_run++);
+      local_index = std::make_unique<HashMap<std::string, Frequency>>();
+      used = 0;
     }
+
+    // Update progress
+    int current = ++job.processed_files;
+    int percentage = (current * 100) / total_files;
+    std::cout << "\r" << percentage << "% (" << current << "/" << total_files
+              << " files)" << std::flush;
   }
-}
 
-// NOTE: serialize index to file (binary)
-void Indexer::serialize_index() {
-  std::ofstream index_file(directory + "/" + indexFile, std::ios::binary);
-  if (!index_file.is_open()) {
-    throw std::runtime_error("Unable to open index file for writing");
+  if (!local_index->empty()) {
+    write_run(*local_index, next_run++);
   }
+}
 
-  int num_words = static_cast<int>(index.size());
-  index_file.write(reinterpret_cast<char *>(&num_words), sizeof(int));
+std::string Indexer::run_path(int run) const {
+  return directory + "/" + indexFile + ".run" + std::to_string(run);
+}
 
-  for (auto const &pair : index) {
-    // Write the word
-    int word_length = pair.key.length();
-    index_file.write(reinterpret_cast<char *>(&word_length), sizeof(int));
-    index_file.write(pair.key.c_str(), word_length);
-
-    // Write the frequency
-    Frequency const &freq = pair.value;
-    index_file.write(reinterpret_cast<const char *>(&freq.idf), sizeof(double));
-    index_file.write(reinterpret_cast<const char *>(&freq.total), sizeof(int));
-
-    // Write the files array
-    int files_size = static_cast<int>(freq.files.size());
-    index_file.write(reinterpret_cast<char *>(&files_size), sizeof(int));
-    for (auto const &file_freq : freq.files) {
-      // Write the file frequency
-      int file_length = file_freq.file.length();
-      index_file.write(reinterpret_cast<char *>(&file_length), sizeof(int));
-      index_file.write(file_freq.file.c_str(), file_length);
-      index_file.write(reinterpret_cast<const char *>(&file_freq.tf),
-                       sizeof(double));
-      index_file.write(reinterpret_cast<const char *>(&file_freq.count),
-                       sizeof(int));
-    }
+// NOTE: Same record layout as the index file, without the word count header
+void Indexer::write_run(HashMap<std::string, Frequency> &local_index,
+                        int run) {
+  std::vector<std::pair<const std::string *, const Frequency *>> entries;
+  entries.reserve(local_index.size());
+  for (auto const &pair : local_index) {
+    entries.emplace_back(&pair.key, &pair.value);
   }
+  std::sort(entries.begin(), entries.end(),
+            [](const auto &a, const auto &b) { return *a.first < *b.first; });
 
-  std::cout << std::endl
-            << "Index saved to " << directory + "/" + indexFile << std::endl;
+  std::ofstream run_file(run_path(run), std::ios::binary);
+  if (!run_file.is_open()) {
+    throw std::runtime_error("Unable to open run file for writing");
+  }
+  for (const auto &entry : entries) {
+    write_entry(run_file, *entry.first, *entry.second);
+  }
 }
 
-void Indexer::deserialize_index() {
-  std::ifstream index_file(directory + "/" + indexFile, std::ios::binary);
-  if (!index_file.is_open()) {
-    throw std::runtime_error("Unable to open index file for reading");
+void Indexer::merge_runs(int num_runs, const IndexReader *base,
+                         const std::vector<uint32_t> *remap) {
+  struct Cursor {
+    MappedFile input;
+    ByteReader reader;
+    std::string word;
+    Frequency freq;
+    bool valid = false;
+
+    explicit Cursor(const std::string &path)
+        : input(path), reader(input.data(), input.size()) {}
+
+    void advance() {
+      freq = Frequency();
+      valid = !reader.done();
+      if (valid) {
+        read_entry(reader, word, freq);
+      }
+    }
+  };
+
+  std::vector<std::unique_ptr<Cursor>> cursors;
+  for (int run = 0; run < num_runs; run++) {
+    auto cursor = std::make_unique<Cursor>(run_path(run));
+    cursor->advance();
+    cursors.push_back(std::move(cursor));
   }
 
-  index.clear(); // Clear existing index
+  // INFO: Min-heap of run numbers ordered by their current word
+  auto greater = [&](int a, int b) { return cursors[a]->word > cursors[b]->word; };
+  std::priority_queue<int, std::vector<int>, decltype(greater)> heap(greater);
+  for (int run = 0; run < num_runs; run++) {
+    if (cursors[run]->valid) {
+      heap.push(run);
+    }
+  }
 
-  int num_words;
-  index_file.read(reinterpret_cast<char *>(&num_words), sizeof(int));
+  // NOTE: The base index is one more sorted source, its terms read in
+  // dictionary order
+  size_t base_term = 0;
+  size_t base_terms = base != nullptr ? base->num_terms() : 0;
+  uint32_t docs[POSTINGS_BLOCK_SIZE], counts[POSTINGS_BLOCK_SIZE];
 
-  for (int i = 0; i < num_words; i++) {
-    // Read the word
-    int word_length;
-    index_file.read(reinterpret_cast<char *>(&word_length), sizeof(int));
+  IndexWriter writer(directory + "/" + indexFile, documents);
+
+  while (!heap.empty() || base_term < base_terms) {
     std::string word;
-    word.resize(word_length);
-    index_file.read(&word[0], word_length);
+    if (heap.empty() ||
+        (base_term < base_terms &&
+         base->term(base_term).term < cursors[heap.top()]->word)) {
+      word = base->term(base_term).term;
+    } else {
+      word = cursors[heap.top()]->word;
+    }
+    Frequency merged;
+    merged.total = 0;
+
+    // Surviving postings of the base index, with their new doc IDs
+    if (base_term < base_terms && base->term(base_term).term == word) {
+      PostingsDecoder decoder = base->postings(base->term(base_term++));
+      for (size_t n = decoder.next(docs, counts); n > 0;
+           n = decoder.next(docs, counts)) {
+        for (size_t i = 0; i < n; i++) {
+          uint32_t doc = (*remap)[docs[i]];
+          if (doc != DROPPED_DOC) {
+            merged.total += static_cast<int>(counts[i]);
+            merged.files.push_back(
+                FileFrequency{doc, static_cast<int>(counts[i]), 0.0});
+          }
+        }
+      }
+    }
 
-    // Read the frequency
-    Frequency freq;
-    index_file.read(reinterpret_cast<char *>(&freq.idf), sizeof(double));
-    index_file.read(reinterpret_cast<char *>(&freq.total), sizeof(int));
-
-    // Read the files array
-    int files_size;
-    index_file.read(reinterpret_cast<char *>(&files_size), sizeof(int));
-    for (int j = 0; j < files_size; j++) {
-      FileFrequency file_freq;
-      // Read the file frequency
-      int file_length;
-      index_file.read(reinterpret_cast<char *>(&file_length), sizeof(int));
-      file_freq.file.resize(file_length);
-      index_file.read(&file_freq.file[0], file_length);
-      index_file.read(reinterpret_cast<char *>(&file_freq.tf), sizeof(double));
-      index_file.read(reinterpret_cast<char *>(&file_freq.count), sizeof(int));
-      freq.files.push_back(file_freq);
+    // Pull the same word from every run that has it
+    while (!heap.empty() && cursors[heap.top()]->word == word) {
+      int run = heap.top();
+      heap.pop();
+
+      Cursor &cursor = *cursors[run];
+      merged.total += cursor.freq.total;
+      for (const auto &file_freq : cursor.freq.files) {
+        merged.files.push_back(file_freq);
+      }
+
+      cursor.advance();
+      if (cursor.valid) {
+        heap.push(run);
+      }
+    }
+
+    if (!merged.files.empty()) { // NOTE: Every posting may have been dropped
+      writer.add(word, merged);
     }
+  }
+  writer.finish();
 
-    index[word] = freq;
+  cursors.clear(); // NOTE: Unmap before deleting
+  for (int run = 0; run < num_runs; run++) {
+    std::filesystem::remove(run_path(run));
   }
 
-  index_file.close();
+  std::cout << std::endl
+            << "Merged " << num_runs << " runs into "
+            << directory + "/" + indexFile << std::endl;
 }
 
-// INFO: deserialize index to Trie structure for autocomplete
-void Indexer::deserialize_index(Trie &trie) {
-  std::ifstream index_file(directory + "/" + indexFile, std::ios::binary);
-  if (!index_file.is_open()) {
-    throw std::runtime_error("Unable to open index file for reading");
+// NOTE: serialize index to file (binary)
+void Indexer::serialize_index(bool autocomplete) {
+  IndexWriter writer(directory + "/" + indexFile, documents);
+
+  // NOTE: The dictionary is written in term order so readers can binary
+  // search it
+  std::vector<std::pair<const std::string *, const Frequency *>> terms;
+  terms.reserve(index.size());
+  for (auto const &pair : index) {
+    terms.emplace_back(&pair.key, &pair.value);
   }
+  std::sort(terms.begin(), terms.end(),
+            [](const auto &a, const auto &b) { return *a.first < *b.first; });
+
+  for (auto const &term : terms) {
+    writer.add(*term.first, *term.second);
+  }
+  writer.finish();
+
+  std::cout << std::endl
+            << "Index saved to " << directory + "/" + indexFile << std::endl;
+  if (autocomplete) {
+    write_autocomplete();
+  }
+}
+
+// NOTE: Built from the index file rather than `index`, which the external
+// build never holds. Only the terms and totals are read, no postings, and
+// the dictionary is already sorted, so the file is written straight from it
+// without building a Trie.
+void Indexer::write_autocomplete() {
+  IndexReader reader(directory + "/" + indexFile);
+  FlatTrie::write(
+      reader.num_terms(),
+      [&reader](size_t i) {
+        TermInfo info = reader.term(i);
+        return ScoredWord{info.term, info.total};
+      },
+      directory + "/" + autocompleteFile);
+
+  std::cout << "Autocomplete saved to " << directory + "/" + autocompleteFile
+            << std::endl;
+}
+
+void Indexer::deserialize_index() { load_index(nullptr); }
+
+// INFO: deserialize index to Trie structure for autocomplete
+void Indexer::deserialize_index(Trie &trie) { load_index(&trie); }
+
+void Indexer::load_index(Trie *trie) {
+  IndexReader reader(directory + "/" + indexFile);
 
   index.clear(); // Clear existing index
-  int num_words;
-  index_file.read(reinterpret_cast<char *>(&num_words), sizeof(int));
+  documents = reader.documents();
+  document_ids.clear();
+  for (size_t i = 0; i < documents.size(); i++) {
+    document_ids[documents[i].file] = static_cast<uint32_t>(i);
+  }
 
-  for (int i = 0; i < num_words; i++) {
-    // Read the word
-    int word_length;
-    index_file.read(reinterpret_cast<char *>(&word_length), sizeof(int));
-    std::string word;
-    word.resize(word_length);
-    index_file.read(&word[0], word_length);
+  uint32_t docs[POSTINGS_BLOCK_SIZE], counts[POSTINGS_BLOCK_SIZE];
+  for (size_t i = 0; i < reader.num_terms(); i++) {
+    TermInfo info = reader.term(i);
+    std::string word(info.term);
 
-    // Read the frequency
+    // NOTE: tf and idf are not stored, they follow from the counts, the
+    // document lengths and the document frequency
     Frequency freq;
-    index_file.read(reinterpret_cast<char *>(&freq.idf), sizeof(double));
-    index_file.read(reinterpret_cast<char *>(&freq.total), sizeof(int));
-
-    // Read the files array
-    int files_size;
-    index_file.read(reinterpret_cast<char *>(&files_size), sizeof(int));
-    for (int j = 0; j < files_size; j++) {
-      FileFrequency file_freq;
-      // Read the file frequency
-      int file_length;
-      index_file.read(reinterpret_cast<char *>(&file_length), sizeof(int));
-      file_freq.file.resize(file_length);
-      index_file.read(&file_freq.file[0], file_length);
-      index_file.read(reinterpret_cast<char *>(&file_freq.tf), sizeof(double));
-      index_file.read(reinterpret_cast<char *>(&file_freq.count), sizeof(int));
-      freq.files.push_back(file_freq);
+    freq.total = static_cast<int>(info.total);
+    freq.idf = reader.idf(info);
+    freq.files.reserve(info.df);
+    PostingsDecoder decoder = reader.postings(info);
+    for (size_t n = decoder.next(docs, counts); n > 0;
+         n = decoder.next(docs, counts)) {
+      for (size_t j = 0; j < n; j++) {
+        freq.files.push_back(FileFrequency{
+            docs[j], static_cast<int>(counts[j]), reader.tf(docs[j], counts[j])});
+      }
     }
 
-    index[word] = freq;
-    trie.insert(word); // Insert word into trie
+    if (trie != nullptr) {
+      trie->insert(word, info.total); // Ranked by corpus frequency
+    }
+    index.try_emplace(word, std::move(freq));
   }
-
-  index_file.close();
 }
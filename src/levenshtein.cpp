@@ -0,0 +1,27 @@
+#include "levenshtein.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+LevenshteinAutomaton::LevenshteinAutomaton(std::string_view word,
+                                           uint8_t max_edits)
+    : masks_(), max_edits_(std::min(max_edits, MAX_EDITS)) {
+  if (word.size() > MAX_LENGTH) {
+    throw std::invalid_argument("Word too long for fuzzy matching");
+  }
+  for (size_t i = 0; i < word.size(); i++) {
+    masks_[static_cast<unsigned char>(word[i])] |= uint64_t(1) << (i + 1);
+  }
+  done_ = uint64_t(1) << word.size();
+  live_ = done_ | (done_ - 1);
+}
+
+// NOTE: Before consuming anything the first j query characters are j
+// deletions away
+LevenshteinAutomaton::State LevenshteinAutomaton::start() const {
+  State state = {};
+  for (uint8_t j = 0; j <= max_edits_; j++) {
+    state.rows[j] = ((uint64_t(2) << j) - 1) & live_;
+  }
+  return state;
+}
@@ -1,11 +1,19 @@
 #include "array_list.hpp"
 #include "cli.h"
+#include "doc_bitmap.h"
+#include "flat_trie.h"
 #include "hashmap.hpp"
+#include "index_reader.h"
 #include "indexer.h"
-#include "set.hpp"
+#include "levenshtein.h"
+#include "query.h"
 #include <algorithm>
 #include <iostream>
+#include <memory>
 #include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
 
 #ifdef _WIN32
 #include <direct.h>
@@ -19,8 +27,16 @@ void search_handler(ArrayList<std::string> args) {
     return;
   }
 
-  Indexer indexer(args[1]);
-  indexer.deserialize_index();
+  // NOTE: Maps the index, postings are only decoded for the query's terms
+  IndexReader reader(args[1] + "/clouseau.idx");
+
+  // NOTE: Misspelled query words are matched against the autocomplete trie.
+  // Indexes built before it existed still search, just without that.
+  std::unique_ptr<FlatTrie> vocabulary;
+  try {
+    vocabulary = std::make_unique<FlatTrie>(args[1] + "/clouseau.ac");
+  } catch (const std::runtime_error &) {
+  }
 
   while (true) {
     std::string query;
@@ -51,68 +67,37 @@ void search_handler(ArrayList<std::string> args) {
       tokens.push_back(token);
     }
 
-    Set<std::string> result_set;
-    bool and_op = false, or_op = false, not_op = false;
-
-    for (const std::string &term : tokens) {
-      if (term == "and") {
-        and_op = true;
-        continue;
-      } else if (term == "or") {
-        or_op = true;
-        continue;
-      } else if (term == "not") {
-        not_op = true;
-        continue;
-      }
-
-      if (indexer.index.find(term) != indexer.index.end()) {
-        Frequency freq = indexer.index[term];
-        Set<std::string> term_set;
-
-        for (const auto &file_freq : freq.files) {
-          term_set.insert(file_freq.file);
-        }
-
-        if (not_op) {
-          for (const auto &file : term_set) {
-            result_set.erase(file);
-          }
-          not_op = false;
-        } else if (and_op) {
-          result_set = result_set.intersect(term_set);
-          and_op = false;
-        } else if (or_op || result_set.empty()) {
-          result_set.insert(term_set.begin(), term_set.end());
-          or_op = false;
-        }
-      } else {
-        std::cout << "Word '" << term << "' not found in the index."
-                  << std::endl;
-      }
-    }
-
-    if (!result_set.empty()) {
-      HashMap<std::string, double> relevance_scores;
-
-      for (const auto &file : result_set) {
-        for (const auto &entry : indexer.index) {
-          const Frequency &freq = entry.value;
-          for (const auto &file_freq : freq.files) {
-            if (file_freq.file == file) {
-              double relevance = freq.idf * file_freq.tf;
-              relevance_scores[file] += relevance;
+    QueryResult query_result =
+        evaluate_query(reader, vocabulary.get(), tokens, std::cout);
+    const DocBitmap &result_docs = query_result.docs;
+
+    if (!result_docs.empty()) {
+      // NOTE: tf-idf over the query's own terms, one pass over their
+      // postings, flagging result docs by ID
+      std::vector<bool> in_results(reader.num_documents(), false);
+      result_docs.for_each(
+          [&in_results](uint32_t doc) { in_results[doc] = true; });
+
+      std::vector<double> relevance_scores(reader.num_documents(), 0.0);
+      uint32_t docs[POSTINGS_BLOCK_SIZE], counts[POSTINGS_BLOCK_SIZE];
+      for (const TermInfo &info : query_result.scored_terms) {
+        double idf = reader.idf(info);
+        PostingsDecoder decoder = reader.postings(info);
+        for (size_t n = decoder.next(docs, counts); n > 0;
+             n = decoder.next(docs, counts)) {
+          for (size_t i = 0; i < n; i++) {
+            if (in_results[docs[i]]) {
+              relevance_scores[docs[i]] += idf * reader.tf(docs[i], counts[i]);
             }
           }
         }
       }
 
       std::vector<std::pair<std::string, double>> sortedResults;
-      for (auto it = relevance_scores.begin(); it != relevance_scores.end();
-           ++it) {
-        auto &node = *it;
-        sortedResults.push_back(std::make_pair(node.key, node.value));
-      }
+      result_docs.for_each([&](uint32_t doc) {
+        sortedResults.push_back(std::make_pair(reader.documents()[doc].file,
+                                               relevance_scores[doc]));
+      });
 
       std::sort(
           sortedResults.begin(), sortedResults.end(),
@@ -168,14 +153,36 @@ void search_handler(ArrayList<std::string> args) {
 }
 
 void index_handler(ArrayList<std::string> args) {
-  if (args.size() != 2) {
-    std::cerr << "Usage: index <input directory>" << std::endl;
+  ArrayList<std::string> positional = positional_args(args);
+  if (positional.size() != 2) {
+    std::cerr << "Usage: index <input directory> [--threads N] "
+                 "[--max-memory SIZE]"
+              << std::endl;
     return;
   }
 
-  Indexer indexer(args[1]);
-  indexer.index_directory();
-  indexer.serialize_index();
+  int num_threads = 0;
+  size_t max_memory = 0;
+  try {
+    num_threads = std::stoi(get_option(args, "--threads", "0"));
+    max_memory = parse_size(get_option(args, "--max-memory", "0"));
+  } catch (const std::exception &) {
+    std::cerr << "Invalid value for --threads or --max-memory" << std::endl;
+    return;
+  }
+
+  // NOTE: Only re-tokenizes files changed since the last run, and only
+  // rewrites what they changed
+  Indexer indexer(positional[1]);
+  if (max_memory > 0) {
+    indexer.update_index_external(max_memory, num_threads);
+    return;
+  }
+
+  IndexChange change = indexer.update_index(num_threads);
+  if (change != IndexChange::None) {
+    indexer.serialize_index(change == IndexChange::Postings);
+  }
 }
 
 void autocomplete_handler(ArrayList<std::string> args) {
@@ -186,61 +193,113 @@ void autocomplete_handler(ArrayList<std::string> args) {
 
   std::cout << "Autocompleting: " << args[1] << std::endl;
 
-  Trie trie;
-  Indexer indexer(args[1]);
-  indexer.deserialize_index(trie);
+  // NOTE: The trie `index` wrote is mapped as is, nothing is built here.
+  // Completions are ranked by corpus frequency.
+  FlatTrie trie(args[1] + "/clouseau.ac");
 
+  std::string line;
   while (true) {
-    std::string prefix;
-    std::cout << "Enter a prefix to autocomplete ('q' to quit): ";
-    std::cin >> prefix;
+    std::cout << "Enter a prefix and how many completions to show, e.g. "
+                 "'hol 5' ('q' to quit): ";
+    if (!std::getline(std::cin, line)) {
+      break;
+    }
 
+    std::istringstream iss(line);
+    std::string prefix, count;
+    size_t k = 10;
+    if (!(iss >> prefix)) {
+      continue;
+    }
     if (prefix == "q") {
       break;
     }
-    ArrayList<std::string> results = trie.search(prefix);
+    if (iss >> count) {
+      try {
+        k = std::stoul(count);
+      } catch (const std::exception &) {
+        std::cout << "Invalid count." << std::endl;
+        continue;
+      }
+    }
 
+    // NOTE: Exact completions rank first, then ones a typo or two away
+    ArrayList<Completion> results =
+        trie.fuzzy_top_k(prefix, k, edits_for_length(prefix.size()));
     if (results.size() == 0) {
       std::cout << "No keywords found for the given prefix." << std::endl;
-    } else {
-      int result_count = static_cast<int>(results.size());
-      int display_count = 0;
-
-      while (result_count > 0) {
-        for (int i = 0; i < 10 && i < result_count; i++) {
-          std::string word = results[display_count];
-
-          std::cout << "Word: " << word << std::endl;
-          display_count++;
-        }
-
-        result_count -= 10;
-
-        if (result_count > 0) {
-          while (prefix != "d" || prefix != "r") {
-            std::cout << "Do you want to see more results? (y/n): ";
-            std::cin >> prefix;
-
-            if (prefix == "y") {
-              break;
-            } else if (prefix == "n") {
-              result_count = 0;
-              break;
-            } else {
-              std::cout << "Invalid input." << std::endl;
-            }
-          }
-        }
+    }
+    for (const Completion &completion : results) {
+      std::cout << "Word: " << completion.word << " (" << completion.score;
+      if (completion.distance > 0) {
+        std::cout << ", " << static_cast<int>(completion.distance)
+                  << (completion.distance == 1 ? " edit" : " edits");
       }
+      std::cout << ")" << std::endl;
     }
   }
 }
 
+// NOTE: Loads the index vocabulary into an instrumented HashMap (same hash
+// and load factor as the indexer's maps), then looks every term up once and
+// a suffixed copy of every term once to measure hit and miss probes. The
+// figures describe this rebuilt map, not the indexer's shards: terms go in
+// once each in sorted order and nothing is erased, so it never has
+// tombstones or in-place rehashes.
+void stats_handler(ArrayList<std::string> args) {
+  if (args.size() != 2) {
+    std::cerr << "Usage: stats <index name>" << std::endl;
+    return;
+  }
+
+  IndexReader reader(args[1] + "/clouseau.idx");
+  HashMap<std::string_view, uint32_t, HashPolicy<std::string_view>,
+          HashMapStats>
+      vocabulary;
+  for (size_t i = 0; i < reader.num_terms(); i++) {
+    vocabulary.try_emplace(reader.term(i).term, static_cast<uint32_t>(i));
+  }
+  const HashMapStats &stats = vocabulary.stats();
+  uint64_t resizes = stats.resizes, rehashes = stats.rehashes;
+  double resize_ms = stats.resize_nanoseconds / 1e6;
+
+  vocabulary.reset_stats();
+  std::string missing;
+  for (size_t i = 0; i < reader.num_terms(); i++) {
+    std::string_view term = reader.term(i).term;
+    vocabulary.find(term);
+    missing.assign(term).push_back('#');
+    vocabulary.find(std::string_view(missing));
+  }
+
+  size_t buckets = vocabulary.bucket_count();
+  std::cout << "Index: " << args[1] << " (" << reader.num_documents()
+            << " documents, " << reader.num_terms() << " terms)" << std::endl;
+  std::cout << "Map: the vocabulary rebuilt into one HashMap, inserts only"
+            << std::endl;
+  std::cout << "Buckets: " << buckets << ", load factor "
+            << vocabulary.size() / (double)buckets << ", tombstones "
+            << vocabulary.tombstone_count() << " ("
+            << 100.0 * vocabulary.tombstone_count() / buckets << "%)"
+            << std::endl;
+  std::cout << "Build: " << resizes << " resizes, " << rehashes
+            << " in-place rehashes, " << resize_ms << " ms resizing"
+            << std::endl;
+  std::cout << "Hit probe: " << stats.average_hit_groups()
+            << " groups on average" << std::endl;
+  std::cout << "Miss probe: " << stats.average_miss_groups()
+            << " groups on average" << std::endl;
+  std::cout << "Longest probe: " << stats.max_groups << " groups" << std::endl;
+  std::cout << "Key compares: " << stats.key_compares << " ("
+            << stats.false_matches << " tag collisions)" << std::endl;
+}
+
 int main(int argc, char *argv[]) {
   CLI cli("clouseau", argc, argv);
   cli.add_cmd("search", Cmd{"Search for a file", search_handler});
   cli.add_cmd("index", Cmd{"Index a directory", index_handler});
   cli.add_cmd("autocomplete", Cmd{"Autocomplete a word", autocomplete_handler});
+  cli.add_cmd("stats", Cmd{"Show probe stats of the vocabulary rebuilt into a HashMap", stats_handler});
   cli.run();
 
   return 0;
@@ -0,0 +1,103 @@
+#include "mapped_file.h"
+
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string &path, Access access)
+    : data_(nullptr), size_(0), mapped_(false) {
+#ifndef _WIN32
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    throw std::runtime_error("Could not open file");
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    size_ = static_cast<size_t>(st.st_size);
+    void *addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr != MAP_FAILED) {
+      madvise(addr, size_,
+              access == Access::Random ? MADV_RANDOM : MADV_SEQUENTIAL);
+      data_ = static_cast<const char *>(addr);
+      mapped_ = true;
+    }
+  }
+  close(fd);
+
+  if (mapped_ || size_ == 0) {
+    return;
+  }
+#endif
+
+  read_buffered(path);
+}
+
+MappedFile::~MappedFile() { release(); }
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : data_(other.data_), size_(other.size_), mapped_(other.mapped_),
+      buffer_(std::move(other.buffer_)) {
+  if (!mapped_) {
+    data_ = buffer_.data();
+  }
+  other.data_ = nullptr;
+  other.size_ = 0;
+  other.mapped_ = false;
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+  if (this != &other) {
+    release();
+    data_ = other.data_;
+    size_ = other.size_;
+    mapped_ = other.mapped_;
+    buffer_ = std::move(other.buffer_);
+    if (!mapped_) {
+      data_ = buffer_.data();
+    }
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.mapped_ = false;
+  }
+  return *this;
+}
+
+// NOTE: Fallback - one read() of the whole file into a heap buffer
+void MappedFile::read_buffered(const std::string &path) {
+  std::ifstream input(path, std::ios::binary | std::ios::ate);
+  if (!input.is_open()) {
+    throw std::runtime_error("Could not open file");
+  }
+
+  std::streamsize length = input.tellg();
+  input.seekg(0, std::ios::beg);
+
+  buffer_.resize(length > 0 ? static_cast<size_t>(length) : 0);
+  if (length > 0 && !input.read(&buffer_[0], length)) {
+    throw std::runtime_error("Could not read file");
+  }
+
+  data_ = buffer_.data();
+  size_ = buffer_.size();
+  mapped_ = false;
+}
+
+void MappedFile::release() {
+#ifndef _WIN32
+  if (mapped_ && data_ != nullptr) {
+    munmap(const_cast<char *>(data_), size_);
+  }
+#endif
+  data_ = nullptr;
+  size_ = 0;
+  mapped_ = false;
+  buffer_.clear();
+}
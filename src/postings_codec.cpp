@@ -0,0 +1,152 @@
+#include "postings_codec.h"
+#include "byte_io.h"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+uint8_t bit_width(const uint32_t *values, size_t n) {
+  uint32_t all = 0;
+  for (size_t i = 0; i < n; i++) {
+    all |= values[i];
+  }
+  uint8_t width = 0;
+  while (all != 0) {
+    width++;
+    all >>= 1;
+  }
+  return width;
+}
+
+// NOTE: POSTINGS_BLOCK_SIZE values of `width` bits take exactly 16 * width
+// bytes (128 * width / 8)
+void pack(const uint32_t *values, uint8_t width, std::string &out) {
+  uint64_t acc = 0;
+  int bits = 0;
+  for (size_t i = 0; i < POSTINGS_BLOCK_SIZE; i++) {
+    acc |= static_cast<uint64_t>(values[i]) << bits;
+    bits += width;
+    while (bits >= 8) {
+      out.push_back(static_cast<char>(acc & 0xff));
+      acc >>= 8;
+      bits -= 8;
+    }
+  }
+}
+
+// INFO: The packed bytes are copied to a zero-padded buffer first, so every
+// value is a single unaligned 64-bit load, shift and mask
+void unpack(const char *packed, uint8_t width, uint32_t *values) {
+  if (width == 0) {
+    std::memset(values, 0, POSTINGS_BLOCK_SIZE * sizeof(uint32_t));
+    return;
+  }
+
+  char buffer[16 * 32 + 8] = {};
+  std::memcpy(buffer, packed, 16 * width);
+
+  const uint64_t mask = (width == 32) ? 0xffffffffULL : ((1ULL << width) - 1);
+  size_t bit = 0;
+  for (size_t i = 0; i < POSTINGS_BLOCK_SIZE; i++, bit += width) {
+    uint64_t word;
+    std::memcpy(&word, buffer + (bit >> 3), sizeof(word));
+    values[i] = static_cast<uint32_t>((word >> (bit & 7)) & mask);
+  }
+}
+
+} // namespace
+
+void encode_postings(const uint32_t *docs, const uint32_t *counts, size_t n,
+                     std::string &out) {
+  append_varint(out, n);
+
+  uint32_t gaps[POSTINGS_BLOCK_SIZE];
+  uint32_t freqs[POSTINGS_BLOCK_SIZE];
+  uint32_t prev = UINT32_MAX; // NOTE: So the first gap is the doc ID itself
+
+  size_t i = 0;
+  for (; i + POSTINGS_BLOCK_SIZE <= n; i += POSTINGS_BLOCK_SIZE) {
+    for (size_t j = 0; j < POSTINGS_BLOCK_SIZE; j++) {
+      gaps[j] = docs[i + j] - prev - 1;
+      freqs[j] = counts[i + j] - 1;
+      prev = docs[i + j];
+    }
+
+    uint8_t gap_width = bit_width(gaps, POSTINGS_BLOCK_SIZE);
+    uint8_t count_width = bit_width(freqs, POSTINGS_BLOCK_SIZE);
+    out.push_back(static_cast<char>(gap_width));
+    out.push_back(static_cast<char>(count_width));
+    pack(gaps, gap_width, out);
+    pack(freqs, count_width, out);
+  }
+
+  for (; i < n; i++) {
+    append_varint(out, docs[i] - prev - 1);
+    append_varint(out, counts[i] - 1);
+    prev = docs[i];
+  }
+}
+
+PostingsDecoder::PostingsDecoder(const char *data, size_t size,
+                                 uint32_t num_docs)
+    : data_(data), pos_(data), end_(data + size), decoded_(0),
+      last_doc_(UINT32_MAX), num_docs_(num_docs) {
+  ByteReader reader(data, size);
+  size_ = static_cast<size_t>(reader.read_varint());
+  pos_ = reader.position();
+}
+
+size_t PostingsDecoder::next(uint32_t *docs, uint32_t *counts) {
+  size_t left = size_ - decoded_;
+  if (left == 0) {
+    return 0;
+  }
+
+  if (left >= POSTINGS_BLOCK_SIZE) {
+    if (end_ - pos_ < 2) {
+      throw std::runtime_error("Index file is truncated");
+    }
+    uint8_t gap_width = static_cast<uint8_t>(pos_[0]);
+    uint8_t count_width = static_cast<uint8_t>(pos_[1]);
+    if (gap_width > 32 || count_width > 32 ||
+        static_cast<size_t>(end_ - pos_) < 2 + 16u * (gap_width + count_width)) {
+      throw std::runtime_error("Index file is truncated");
+    }
+    pos_ += 2;
+
+    unpack(pos_, gap_width, docs);
+    pos_ += 16 * gap_width;
+    unpack(pos_, count_width, counts);
+    pos_ += 16 * count_width;
+
+    // NOTE: Prefix sum turns gaps back into doc IDs
+    uint32_t doc = last_doc_;
+    bool in_range = true;
+    for (size_t j = 0; j < POSTINGS_BLOCK_SIZE; j++) {
+      doc += docs[j] + 1;
+      docs[j] = doc;
+      counts[j] += 1;
+      in_range &= doc < num_docs_;
+    }
+    if (!in_range) {
+      throw std::runtime_error("Index file references an unknown document");
+    }
+    last_doc_ = doc;
+    decoded_ += POSTINGS_BLOCK_SIZE;
+    return POSTINGS_BLOCK_SIZE;
+  }
+
+  ByteReader reader(pos_, static_cast<size_t>(end_ - pos_));
+  for (size_t j = 0; j < left; j++) {
+    last_doc_ += static_cast<uint32_t>(reader.read_varint()) + 1;
+    if (last_doc_ >= num_docs_) {
+      throw std::runtime_error("Index file references an unknown document");
+    }
+    docs[j] = last_doc_;
+    counts[j] = static_cast<uint32_t>(reader.read_varint()) + 1;
+  }
+  pos_ = reader.position();
+  decoded_ += left;
+  return left;
+}
@@ -0,0 +1,85 @@
+#include "query.h"
+#include "indexer.h"
+#include "levenshtein.h"
+
+#include <memory>
+#include <string_view>
+
+QueryResult evaluate_query(const IndexReader &reader,
+                           const FlatTrie *vocabulary,
+                           const std::vector<std::string> &tokens,
+                           std::ostream &out) {
+  std::vector<std::string_view> terms;
+  for (const std::string &term : tokens) {
+    if (term != "and" && term != "or" && term != "not") {
+      terms.push_back(term);
+    }
+  }
+  std::vector<TermInfo> infos(terms.size());
+  std::unique_ptr<bool[]> found(new bool[terms.size()]);
+  reader.find_many(terms.data(), terms.size(), infos.data(), found.get());
+  for (size_t i = 0; i < terms.size() && vocabulary != nullptr; i++) {
+    // NOTE: Stopwords are missing on purpose, the closest indexed word to
+    // "the" is not what the query asked for
+    std::string term(terms[i]);
+    if (found[i] || Indexer::stopwords.contains(term)) {
+      continue;
+    }
+    ArrayList<Completion> closest =
+        vocabulary->fuzzy_find(term, 1, edits_for_length(term.size()));
+    if (closest.size() > 0 && reader.find(closest[0].word, infos[i])) {
+      found[i] = true;
+      out << "Word '" << term << "' not found in the index, "
+          << "searching '" << closest[0].word << "' instead." << std::endl;
+    }
+  }
+
+  QueryResult result;
+  bool and_op = false, or_op = false, not_op = false;
+  size_t next_term = 0;
+
+  for (const std::string &term : tokens) {
+    if (term == "and") {
+      and_op = true;
+      continue;
+    } else if (term == "or") {
+      or_op = true;
+      continue;
+    } else if (term == "not") {
+      not_op = true;
+      continue;
+    }
+
+    const TermInfo &info = infos[next_term];
+    if (found[next_term++]) {
+      // NOTE: Doc IDs come out of the decoder ascending, so each block is
+      // appended as is
+      DocBitmap term_docs;
+      uint32_t docs[POSTINGS_BLOCK_SIZE], counts[POSTINGS_BLOCK_SIZE];
+      PostingsDecoder decoder = reader.postings(info);
+      for (size_t n = decoder.next(docs, counts); n > 0;
+           n = decoder.next(docs, counts)) {
+        term_docs.add_many(docs, n);
+      }
+      term_docs.run_optimize();
+
+      if (!not_op) {
+        result.scored_terms.push_back(info);
+      }
+
+      if (not_op) {
+        result.docs = result.docs.difference(term_docs);
+        not_op = false;
+      } else if (and_op) {
+        result.docs = result.docs.intersect(term_docs);
+        and_op = false;
+      } else if (or_op || result.docs.empty()) {
+        result.docs = result.docs.unite(term_docs);
+        or_op = false;
+      }
+    } else {
+      out << "Word '" << term << "' not found in the index." << std::endl;
+    }
+  }
+  return result;
+}
@@ -0,0 +1,172 @@
+#include "tokenizer.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CLOUSEAU_X86 1
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define CLOUSEAU_AVX2 1
+#include <immintrin.h>
+#endif
+#endif
+
+namespace {
+
+// INFO: Per byte: lowercased value, and whether it is a word character
+struct ByteClass {
+  char lower[256];
+  bool word[256];
+
+  ByteClass() {
+    for (int i = 0; i < 256; i++) {
+      char c = static_cast<char>(i);
+      lower[i] = (c >= 'A' && c <= 'Z') ? static_cast<char>(c + 32) : c;
+      word[i] = is_word_char(c);
+    }
+  }
+};
+
+const ByteClass byte_class;
+
+void classify_scalar(const char *src, size_t size, char *dst,
+                     uint64_t *mask) {
+  std::memset(mask, 0, ((size + 63) / 64) * sizeof(uint64_t));
+  for (size_t i = 0; i < size; i++) {
+    unsigned char c = static_cast<unsigned char>(src[i]);
+    dst[i] = byte_class.lower[c];
+    mask[i / 64] |= static_cast<uint64_t>(byte_class.word[c]) << (i % 64);
+  }
+}
+
+#ifdef CLOUSEAU_X86
+// NOTE: 16 bytes at a time. Bytes >= 0x80 are negative as signed chars, so
+// they fall outside every range compare and count as boundaries.
+inline __m128i in_range_sse2(__m128i v, char lo, char hi) {
+  return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)),
+                       _mm_cmplt_epi8(v, _mm_set1_epi8(hi + 1)));
+}
+
+void classify_sse2(const char *src, size_t size, char *dst, uint64_t *mask) {
+  size_t i = 0;
+  for (; i + 64 <= size; i += 64) {
+    uint64_t bits = 0;
+    for (int lane = 0; lane < 4; lane++) {
+      __m128i v = _mm_loadu_si128(
+          reinterpret_cast<const __m128i *>(src + i + lane * 16));
+      __m128i upper = in_range_sse2(v, 'A', 'Z');
+      __m128i lower = _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + lane * 16), lower);
+
+      __m128i word = _mm_or_si128(in_range_sse2(lower, 'a', 'z'),
+                                  in_range_sse2(v, '0', '9'));
+      word = _mm_or_si128(word, _mm_cmpeq_epi8(v, _mm_set1_epi8('\'')));
+      word = _mm_or_si128(word, _mm_cmpeq_epi8(v, _mm_set1_epi8('-')));
+      bits |= static_cast<uint64_t>(
+                  static_cast<uint16_t>(_mm_movemask_epi8(word)))
+              << (lane * 16);
+    }
+    mask[i / 64] = bits;
+  }
+  classify_scalar(src + i, size - i, dst + i, mask + i / 64);
+}
+#endif
+
+#ifdef CLOUSEAU_AVX2
+// NOTE: Same as SSE2 but 32 bytes at a time, compiled for AVX2 only here
+__attribute__((target("avx2"))) inline __m256i
+in_range_avx2(__m256i v, char lo, char hi) {
+  return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(lo - 1)),
+                          _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), v));
+}
+
+__attribute__((target("avx2"))) void
+classify_avx2(const char *src, size_t size, char *dst, uint64_t *mask) {
+  size_t i = 0;
+  for (; i + 64 <= size; i += 64) {
+    uint64_t bits = 0;
+    for (int lane = 0; lane < 2; lane++) {
+      __m256i v = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i *>(src + i + lane * 32));
+      __m256i upper = in_range_avx2(v, 'A', 'Z');
+      __m256i lower = _mm256_or_si256(
+          v, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i + lane * 32),
+                          lower);
+
+      __m256i word = _mm256_or_si256(in_range_avx2(lower, 'a', 'z'),
+                                     in_range_avx2(v, '0', '9'));
+      word = _mm256_or_si256(word, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\'')));
+      word = _mm256_or_si256(word, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('-')));
+      bits |= static_cast<uint64_t>(
+                  static_cast<uint32_t>(_mm256_movemask_epi8(word)))
+              << (lane * 32);
+    }
+    mask[i / 64] = bits;
+  }
+  classify_scalar(src + i, size - i, dst + i, mask + i / 64);
+}
+#endif
+
+} // namespace
+
+bool tokenizer_kernel_supported(TokenizerKernel kernel) {
+  switch (kernel) {
+  case TokenizerKernel::Scalar:
+    return true;
+  case TokenizerKernel::SSE2:
+#ifdef CLOUSEAU_X86
+    return true; // INFO: Part of the x86-64 baseline
+#else
+    return false;
+#endif
+  case TokenizerKernel::AVX2:
+#ifdef CLOUSEAU_AVX2
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+  }
+  return false;
+}
+
+TokenizerKernel best_tokenizer_kernel() {
+  if (tokenizer_kernel_supported(TokenizerKernel::AVX2)) {
+    return TokenizerKernel::AVX2;
+  }
+  if (tokenizer_kernel_supported(TokenizerKernel::SSE2)) {
+    return TokenizerKernel::SSE2;
+  }
+  return TokenizerKernel::Scalar;
+}
+
+const char *tokenizer_kernel_name(TokenizerKernel kernel) {
+  switch (kernel) {
+  case TokenizerKernel::Scalar:
+    return "scalar";
+  case TokenizerKernel::SSE2:
+    return "sse2";
+  case TokenizerKernel::AVX2:
+    return "avx2";
+  }
+  return "unknown";
+}
+
+void classify_block(TokenizerKernel kernel, const char *src, size_t size,
+                    char *dst, uint64_t *mask) {
+  switch (kernel) {
+#ifdef CLOUSEAU_AVX2
+  case TokenizerKernel::AVX2:
+    classify_avx2(src, size, dst, mask);
+    return;
+#endif
+#ifdef CLOUSEAU_X86
+  case TokenizerKernel::SSE2:
+    classify_sse2(src, size, dst, mask);
+    return;
+#endif
+  default:
+    classify_scalar(src, size, dst, mask);
+    return;
+  }
+}
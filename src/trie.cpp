@@ -1,37 +1,221 @@
 #include "trie.hpp"
 
-void Trie::insert(const std::string &word) {
-  TrieNode *current = root;
-  for (char c : word) {
-    if (current->children.find(c) == current->children.end()) { // character not found
-      current->children[c] = new TrieNode(c);
+#include <algorithm>
+#include <queue>
+#include <utility>
+#include <vector>
+
+TrieNode::TrieNode(std::string label)
+    : label(std::move(label)), score(0), max_score(0), is_end_of_word(false),
+      children(nullptr), count(0), capacity(0) {}
+
+TrieNode::~TrieNode() {
+  for_each_child([](TrieNode *node) { delete node; });
+  delete[] children;
+}
+
+TrieNode *TrieNode::child(unsigned char c) const {
+  if (dense()) {
+    return children[c];
+  }
+  for (uint16_t i = 0; i < count; i++) {
+    unsigned char key = first(children[i]);
+    if (key >= c) {
+      return key == c ? children[i] : nullptr;
+    }
+  }
+  return nullptr;
+}
+
+void TrieNode::set_child(TrieNode *node) {
+  unsigned char c = first(node);
+  if (dense()) {
+    count += children[c] == nullptr;
+    children[c] = node;
+    return;
+  }
+
+  uint16_t position = 0;
+  while (position < count && first(children[position]) < c) {
+    position++;
+  }
+  if (position < count && first(children[position]) == c) {
+    children[position] = node;
+    return;
+  }
+
+  if (count == DENSE_CHILDREN) {
+    // NOTE: Too many to scan, index them by first character instead
+    TrieNode **table = new TrieNode *[DENSE_SLOTS]();
+    for (uint16_t i = 0; i < count; i++) {
+      table[first(children[i])] = children[i];
     }
-    current = current->children[c]; // move to the next node
+    table[c] = node;
+    delete[] children;
+    children = table;
+    capacity = DENSE_SLOTS;
+    count++;
+    return;
   }
-  current->is_end_of_word = true; // mark the end of the word
+
+  if (count == capacity) {
+    uint16_t grown = capacity == 0 ? 2 : std::min<uint16_t>(capacity * 2,
+                                                             DENSE_CHILDREN);
+    TrieNode **larger = new TrieNode *[grown];
+    std::copy(children, children + count, larger);
+    delete[] children;
+    children = larger;
+    capacity = grown;
+  }
+  std::copy_backward(children + position, children + count,
+                     children + count + 1);
+  children[position] = node;
+  count++;
 }
 
-ArrayList<std::string> Trie::search(const std::string &prefix) {
+// NOTE: Bounds are only ever raised, so lowering a word's score leaves its
+// ancestors' bounds high. That still bounds the subtree, top_k just looks a
+// little further than it has to.
+void Trie::insert(const std::string &word, uint32_t score) {
   TrieNode *current = root;
-  for (char c : prefix) {
-    if (current->children.find(c) == current->children.end()) {
-      // std::cout << "keywords not found" << std::endl;
-      return ArrayList<std::string>(); // character not found
+  size_t pos = 0;
+  while (true) {
+    current->max_score = std::max(current->max_score, score);
+    if (pos == word.size()) {
+      break;
+    }
+    TrieNode *next = current->child(static_cast<unsigned char>(word[pos]));
+    if (next == nullptr) { // NOTE: Rest of the word becomes one leaf
+      TrieNode *leaf = new TrieNode(word.substr(pos));
+      leaf->is_end_of_word = true;
+      leaf->score = score;
+      leaf->max_score = score;
+      current->set_child(leaf);
+      return;
+    }
+
+    size_t common = 1;
+    while (common < next->label.size() && pos + common < word.size() &&
+           next->label[common] == word[pos + common]) {
+      common++;
     }
-    current = current->children[c]; // move to the next node
+    if (common < next->label.size()) {
+      // NOTE: The word leaves the edge part way along, split it there
+      // (middle takes next's place before next's label changes)
+      TrieNode *middle = new TrieNode(next->label.substr(0, common));
+      middle->max_score = next->max_score;
+      current->set_child(middle);
+      next->label.erase(0, common);
+      middle->set_child(next);
+      next = middle;
+    }
+    current = next;
+    pos += common;
+  }
+  current->is_end_of_word = true;
+  current->score = score;
+}
+
+ArrayList<std::string> Trie::search(const std::string &prefix) const {
+  std::string word;
+  const TrieNode *current = find_prefix(prefix, word);
+  if (current == nullptr) {
+    return ArrayList<std::string>(); // NOTE: No word has this prefix
   }
 
   ArrayList<std::string> results;
-  collect_all_words(current, prefix, results); 
+  collect_all_words(current, word, results);
   return results;
 }
 
-void Trie::collect_all_words(TrieNode *node, const std::string &prefix, ArrayList<std::string> &results) {
-  if (node->is_end_of_word) {
-    results.push_back(prefix); // add the word to the results
+ArrayList<Completion> Trie::top_k(const std::string &prefix, size_t k) const {
+  ArrayList<Completion> results;
+  std::string path;
+  const TrieNode *start = find_prefix(prefix, path);
+  if (start == nullptr || k == 0) {
+    return results;
   }
 
-  for (auto const &pair : node->children) { // iterate over all children
-    collect_all_words(pair.value, prefix + pair.key, results);
+  // NOTE: A candidate is a subtree (ranked by its bound) or a word (ranked
+  // by its score). Popping a word means nothing left can beat it. Parents
+  // are indices into candidates, so words are spelled only when emitted.
+  struct Candidate {
+    const TrieNode *node;
+    size_t parent;
+    uint32_t rank;
+    bool word;
+  };
+  std::vector<Candidate> candidates;
+  auto worse = [&candidates](size_t a, size_t b) {
+    return candidates[a].rank != candidates[b].rank
+               ? candidates[a].rank < candidates[b].rank
+               : a > b;
+  };
+  std::priority_queue<size_t, std::vector<size_t>, decltype(worse)> queue(
+      worse);
+
+  candidates.push_back(Candidate{start, SIZE_MAX, start->max_score, false});
+  queue.push(0);
+  while (!queue.empty() && results.size() < k) {
+    size_t index = queue.top();
+    queue.pop();
+    Candidate candidate = candidates[index];
+    if (candidate.word) {
+      std::string suffix;
+      for (size_t i = candidate.parent; i != 0; i = candidates[i].parent) {
+        const std::string &label = candidates[i].node->label;
+        suffix.insert(suffix.begin(), label.begin(), label.end());
+      }
+      results.push_back(Completion{path + suffix, candidate.node->score});
+      continue;
+    }
+    if (candidate.node->is_end_of_word) {
+      candidates.push_back(
+          Candidate{candidate.node, index, candidate.node->score, true});
+      queue.push(candidates.size() - 1);
+    }
+    candidate.node->for_each_child([&](const TrieNode *child) {
+      candidates.push_back(Candidate{child, index, child->max_score, false});
+      queue.push(candidates.size() - 1);
+    });
+  }
+  return results;
+}
+
+const TrieNode *Trie::find_prefix(const std::string &prefix,
+                                  std::string &path) const {
+  const TrieNode *current = root;
+  size_t pos = 0;
+  while (pos < prefix.size()) {
+    const TrieNode *next =
+        current->child(static_cast<unsigned char>(prefix[pos]));
+    if (next == nullptr) {
+      return nullptr;
+    }
+    size_t common = 1;
+    while (common < next->label.size() && pos + common < prefix.size() &&
+           next->label[common] == prefix[pos + common]) {
+      common++;
+    }
+    if (common < next->label.size() && pos + common < prefix.size()) {
+      return nullptr; // NOTE: Diverges inside the edge
+    }
+    path += next->label;
+    current = next;
+    pos += common;
+  }
+  return current;
+}
+
+void Trie::collect_all_words(const TrieNode *node, std::string &word,
+                             ArrayList<std::string> &results) const {
+  if (node->is_end_of_word) {
+    results.push_back(word);
   }
+  node->for_each_child([&](const TrieNode *child) {
+    size_t length = word.size();
+    word += child->label;
+    collect_all_words(child, word, results);
+    word.resize(length);
+  });
 }
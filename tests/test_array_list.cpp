@@ -1,5 +1,9 @@
 #include "array_list.hpp"
 #include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
 
 
 // TEST: GIVEN an empty ArrayList WHEN checking if it's empty THEN it should return true.
@@ -128,3 +132,142 @@ TEST(ArrayListTest, Resize_HandlesLargerCapacity) {
 }
 
 
+// TEST: GIVEN emplace_back WHEN called with constructor args THEN the element
+// is built in place and returned
+TEST(ArrayListTest, EmplaceBack_ConstructsInPlace) {
+    ArrayList<std::string> list;
+    std::string &first = list.emplace_back(3, 'x');
+    EXPECT_EQ(first, "xxx");
+    list.emplace_back("holmes");
+    EXPECT_EQ(list.size(), 2);
+    EXPECT_EQ(list[1], "holmes");
+}
+
+// TEST: GIVEN reserve WHEN elements are added up to that capacity THEN the
+// storage does not move and no element is constructed early
+TEST(ArrayListTest, Reserve_AvoidsReallocation) {
+    ArrayList<std::string> list;
+    list.reserve(100);
+    EXPECT_EQ(list.capacity(), 100);
+    EXPECT_TRUE(list.empty());
+    list.push_back("first");
+    const std::string *first = &list[0];
+    for (int i = 1; i < 100; ++i) {
+        list.push_back(std::to_string(i));
+    }
+    EXPECT_EQ(&list[0], first);
+    list.reserve(10); // NOTE: Never shrinks
+    EXPECT_EQ(list.capacity(), 100);
+}
+
+// NOTE: No default constructor, and counts live instances
+struct Tracked {
+    static int alive;
+    int value;
+    explicit Tracked(int v) : value(v) { alive++; }
+    Tracked(const Tracked &other) : value(other.value) { alive++; }
+    Tracked(Tracked &&other) noexcept : value(other.value) { alive++; }
+    ~Tracked() { alive--; }
+};
+int Tracked::alive = 0;
+
+// TEST: GIVEN a type without a default constructor WHEN the list grows, pops,
+// copies and clears THEN exactly the live elements exist at every point
+TEST(ArrayListTest, OnlyLiveElementsAreConstructed) {
+    {
+        ArrayList<Tracked> list;
+        for (int i = 0; i < 10; ++i) {
+            list.emplace_back(i);
+        }
+        EXPECT_EQ(Tracked::alive, 10);
+        list.pop_back();
+        EXPECT_EQ(Tracked::alive, 9);
+
+        ArrayList<Tracked> copy = list;
+        EXPECT_EQ(Tracked::alive, 18);
+        EXPECT_EQ(copy[8].value, 8);
+        copy.clear();
+        EXPECT_EQ(Tracked::alive, 9);
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+// NOTE: Copies throw once countdown reaches zero, and live instances are
+// counted
+struct ThrowingCopy {
+    static int alive;
+    static int countdown;
+    int value;
+    explicit ThrowingCopy(int v) : value(v) { alive++; }
+    ThrowingCopy(const ThrowingCopy &other) : value(other.value) {
+        if (countdown-- == 0) {
+            throw std::runtime_error("copy failed");
+        }
+        alive++;
+    }
+    ThrowingCopy(ThrowingCopy &&other) noexcept : value(other.value) {
+        alive++;
+    }
+    ~ThrowingCopy() { alive--; }
+};
+int ThrowingCopy::alive = 0;
+int ThrowingCopy::countdown = -1;
+
+// TEST: GIVEN an element copy that throws partway WHEN copying or assigning a
+// list THEN nothing leaks and the assigned list keeps its old elements
+TEST(ArrayListTest, ThrowingCopyLeavesTargetIntact) {
+    {
+        ArrayList<ThrowingCopy> source;
+        for (int i = 0; i < 5; ++i) {
+            source.emplace_back(i);
+        }
+        ArrayList<ThrowingCopy> target;
+        target.emplace_back(42);
+
+        ThrowingCopy::countdown = 3;
+        EXPECT_THROW(ArrayList<ThrowingCopy> copy(source), std::runtime_error);
+        EXPECT_EQ(ThrowingCopy::alive, 6);
+
+        ThrowingCopy::countdown = 3;
+        EXPECT_THROW(target = source, std::runtime_error);
+        EXPECT_EQ(ThrowingCopy::alive, 6);
+        ASSERT_EQ(target.size(), 1);
+        EXPECT_EQ(target[0].value, 42);
+
+        ThrowingCopy::countdown = -1;
+        target = source;
+        EXPECT_EQ(target.size(), 5);
+        EXPECT_EQ(target[4].value, 4);
+    }
+    EXPECT_EQ(ThrowingCopy::alive, 0);
+}
+
+// TEST: GIVEN an element of the list WHEN pushed back onto it while it grows
+// THEN the copy is made before the old storage is released
+TEST(ArrayListTest, PushBack_OwnElementDuringGrowth) {
+    ArrayList<std::string> list = {"watson"};
+    EXPECT_EQ(list.capacity(), 1);
+    list.push_back(list[0]);
+    EXPECT_EQ(list[1], "watson");
+}
+
+// TEST: GIVEN the mutex lock policy WHEN 4 threads push back together THEN
+// no element is lost
+TEST(ArrayListTest, MutexLockPolicy_ConcurrentPushBack) {
+    ArrayList<int, MutexLockPolicy> list;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&list] {
+            for (int i = 0; i < 1000; ++i) {
+                list.push_back(i);
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(list.size(), 4000);
+
+    ArrayList<int, MutexLockPolicy> copy = list; // NOTE: Gets its own mutex
+    EXPECT_EQ(copy.size(), 4000);
+}
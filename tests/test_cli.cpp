@@ -1,5 +1,8 @@
 #include "cli.h"
 #include <gtest/gtest.h>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
 
 // TEST: GIVEN a command with no arguments WHEN the command is executed THEN it
 // should print "No arguments provided"
@@ -61,3 +64,49 @@ TEST(CliTest, CommandNotFound) {
       "[args...]\nCommands:\n  test - A test command\n";
   EXPECT_EQ(result, expectedOutput);
 }
+
+// TEST: GIVEN args with a "--threads 4" flag WHEN get_option is called THEN
+// the flag value is returned, and the fallback for absent flags
+TEST(CliTest, GetOption) {
+  ArrayList<std::string> args = {"index", "dir", "--threads", "4"};
+  EXPECT_EQ(get_option(args, "--threads"), "4");
+  EXPECT_EQ(get_option(args, "--missing", "0"), "0");
+}
+
+// TEST: GIVEN sizes with and without a suffix WHEN parse_size is called THEN
+// they are scaled to bytes
+TEST(CliTest, ParseSize) {
+  EXPECT_EQ(parse_size("65536"), 65536u);
+  EXPECT_EQ(parse_size("512K"), 512u << 10);
+  EXPECT_EQ(parse_size("512m"), 512u << 20);
+  EXPECT_EQ(parse_size("2G"), size_t(2) << 30);
+  EXPECT_EQ(parse_size("0"), 0u);
+}
+
+// TEST: GIVEN a negative, signed, suffixed past SIZE_MAX or malformed size
+// WHEN parse_size is called THEN it throws instead of wrapping around
+TEST(CliTest, ParseSizeRejectsInvalid) {
+  EXPECT_THROW(parse_size("-1"), std::invalid_argument);
+  EXPECT_THROW(parse_size(" -1"), std::invalid_argument);
+  EXPECT_THROW(parse_size("+1"), std::invalid_argument);
+  EXPECT_THROW(parse_size("-1G"), std::invalid_argument);
+  EXPECT_THROW(parse_size(std::to_string(SIZE_MAX) + "K"),
+               std::invalid_argument);
+  EXPECT_THROW(parse_size(std::to_string((SIZE_MAX >> 30) + 1) + "G"),
+               std::invalid_argument);
+  EXPECT_EQ(parse_size(std::to_string(SIZE_MAX >> 30) + "G"),
+            (SIZE_MAX >> 30) << 30);
+  EXPECT_THROW(parse_size(""), std::invalid_argument);
+  EXPECT_THROW(parse_size("12T"), std::invalid_argument);
+  EXPECT_THROW(parse_size("M"), std::invalid_argument);
+}
+
+// TEST: GIVEN args mixing flags and positionals WHEN positional_args is called
+// THEN flags and their values are skipped
+TEST(CliTest, PositionalArgs) {
+  ArrayList<std::string> args = {"index", "--threads", "4", "dir"};
+  ArrayList<std::string> positional = positional_args(args);
+  ASSERT_EQ(positional.size(), 2);
+  EXPECT_EQ(positional[0], "index");
+  EXPECT_EQ(positional[1], "dir");
+}
@@ -0,0 +1,129 @@
+#include "array_list.hpp"
+#include "concurrent_hashmap.hpp"
+#include <atomic>
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// TEST: GIVEN a concurrent map WHEN elements are inserted THEN they are found,
+// copied out and counted
+TEST(ConcurrentHashMapTest, InsertAndFind) {
+    ConcurrentHashMap<std::string, int> map(8);
+    map.insert("one", 1);
+    map.insert("two", 2);
+    EXPECT_TRUE(map.try_emplace("three", 3));
+    EXPECT_FALSE(map.try_emplace("three", 33));
+
+    int value = 0;
+    EXPECT_TRUE(map.find("three", value));
+    EXPECT_EQ(value, 3);
+    EXPECT_TRUE(map.contains(std::string_view("two")));
+    EXPECT_FALSE(map.find("four", value));
+    EXPECT_EQ(map.size(), 3);
+
+    EXPECT_TRUE(map.erase("one"));
+    EXPECT_FALSE(map.erase("one"));
+    EXPECT_EQ(map.size(), 2);
+    map.clear();
+    EXPECT_TRUE(map.empty());
+}
+
+// TEST: GIVEN a shard count that is not a power of two WHEN constructed THEN
+// it is rounded up and a single shard also works
+TEST(ConcurrentHashMapTest, ShardCountIsPowerOfTwo) {
+    ConcurrentHashMap<int, int> map(10);
+    EXPECT_EQ(map.shard_count(), 16);
+
+    ConcurrentHashMap<int, int> single(1);
+    EXPECT_EQ(single.shard_count(), 1);
+    for (int i = 0; i < 100; i++) {
+        single.insert(i, i);
+    }
+    EXPECT_EQ(single.size(), 100);
+}
+
+// TEST: GIVEN update on new and existing keys WHEN called THEN the value is
+// default constructed once and modified in place
+TEST(ConcurrentHashMapTest, UpdateInsertsThenModifies) {
+    ConcurrentHashMap<std::string, ArrayList<int>> map;
+    map.update("term", [](ArrayList<int> &postings) { postings.push_back(1); });
+    map.update("term", [](ArrayList<int> &postings) { postings.push_back(2); });
+
+    size_t count = 0;
+    EXPECT_TRUE(map.visit("term", [&](const ArrayList<int> &postings) {
+        count = postings.size();
+    }));
+    EXPECT_EQ(count, 2);
+}
+
+// TEST: GIVEN 8 threads each updating shared and private keys WHEN joined
+// THEN no update is lost
+TEST(ConcurrentHashMapTest, ConcurrentUpdatesAreNotLost) {
+    ConcurrentHashMap<std::string, int> map(4);
+    const int threads = 8, rounds = 2000;
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&map, t] {
+            for (int i = 0; i < rounds; i++) {
+                map.update("shared" + std::to_string(i % 10),
+                           [](int &value) { value++; });
+                map.insert("t" + std::to_string(t) + "_" + std::to_string(i), i);
+            }
+        });
+    }
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+
+    int total = 0;
+    map.for_each([&](const std::string &key, const int &value) {
+        if (key.rfind("shared", 0) == 0) {
+            total += value;
+        }
+    });
+    EXPECT_EQ(total, threads * rounds);
+    EXPECT_EQ(map.size(), static_cast<size_t>(10 + threads * rounds));
+}
+
+// TEST: GIVEN readers and a writer running together WHEN the writer inserts
+// THEN readers only ever see complete values
+TEST(ConcurrentHashMapTest, ReadersSeeCompleteValues) {
+    ConcurrentHashMap<int, std::string> map;
+    for (int i = 0; i < 100; i++) {
+        map.insert(i, std::string(32, 'a'));
+    }
+
+    std::thread writer([&map] {
+        for (int round = 0; round < 200; round++) {
+            char c = static_cast<char>('a' + round % 26);
+            for (int i = 0; i < 100; i++) {
+                map.insert(i, std::string(32, c));
+            }
+        }
+    });
+
+    std::atomic<bool> torn(false);
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; r++) {
+        readers.emplace_back([&map, &torn] {
+            for (int round = 0; round < 200; round++) {
+                for (int i = 0; i < 100; i++) {
+                    std::string value;
+                    map.find(i, value);
+                    if (value.size() != 32 ||
+                        value.find_first_not_of(value[0]) != std::string::npos) {
+                        torn = true;
+                    }
+                }
+            }
+        });
+    }
+    writer.join();
+    for (std::thread &reader : readers) {
+        reader.join();
+    }
+    EXPECT_FALSE(torn.load());
+}
@@ -0,0 +1,117 @@
+#include "doc_bitmap.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace {
+
+std::vector<uint32_t> docs_of(const DocBitmap &bitmap) {
+    std::vector<uint32_t> docs;
+    bitmap.for_each([&docs](uint32_t doc) { docs.push_back(doc); });
+    return docs;
+}
+
+// INFO: Sparse, dense and run-shaped chunks over three chunks of doc IDs
+std::set<uint32_t> random_docs(std::mt19937 &rng) {
+    std::set<uint32_t> docs;
+    for (int i = 0; i < 300; i++) {
+        docs.insert(rng() % 65536); // NOTE: Sparse chunk
+    }
+    for (int i = 0; i < 20000; i++) {
+        docs.insert(65536 + rng() % 65536); // NOTE: Dense chunk
+    }
+    uint32_t start = 131072 + rng() % 1000;
+    for (uint32_t doc = start; doc < start + 30000; doc++) {
+        docs.insert(doc); // NOTE: One long run
+    }
+    return docs;
+}
+
+DocBitmap build(const std::set<uint32_t> &docs) {
+    std::vector<uint32_t> sorted(docs.begin(), docs.end());
+    DocBitmap bitmap;
+    for (size_t i = 0; i < sorted.size(); i += 128) {
+        bitmap.add_many(sorted.data() + i,
+                        std::min<size_t>(128, sorted.size() - i));
+    }
+    bitmap.run_optimize();
+    return bitmap;
+}
+
+} // namespace
+
+// TEST: GIVEN ascending and out of order docs WHEN added THEN iteration is
+// ascending without duplicates and contains agrees
+TEST(DocBitmapTest, AddAndContains) {
+    DocBitmap bitmap;
+    EXPECT_TRUE(bitmap.empty());
+    uint32_t docs[] = {3, 9, 70000, 12};
+    bitmap.add_many(docs, 4);
+    bitmap.add(9);
+    bitmap.add(1);
+    EXPECT_EQ(docs_of(bitmap), std::vector<uint32_t>({1, 3, 9, 12, 70000}));
+    EXPECT_EQ(bitmap.cardinality(), 5u);
+    EXPECT_TRUE(bitmap.contains(70000));
+    EXPECT_FALSE(bitmap.contains(4));
+    EXPECT_FALSE(bitmap.contains(65536 + 3));
+}
+
+// TEST: GIVEN every doc of a chunk WHEN run optimized THEN it shrinks to a
+// run and keeps its contents
+TEST(DocBitmapTest, RunOptimizeShrinksConsecutiveDocs) {
+    std::set<uint32_t> all;
+    for (uint32_t doc = 0; doc < 65536; doc++) {
+        all.insert(doc);
+    }
+    std::vector<uint32_t> sorted(all.begin(), all.end());
+    DocBitmap bitmap;
+    bitmap.add_many(sorted.data(), sorted.size());
+    size_t before = bitmap.size_in_bytes();
+    bitmap.run_optimize();
+    EXPECT_LT(bitmap.size_in_bytes(), before / 50);
+    EXPECT_EQ(bitmap.cardinality(), 65536u);
+    EXPECT_EQ(docs_of(bitmap), sorted);
+}
+
+// TEST: GIVEN bitmaps mixing array, bitmap and run chunks WHEN combined with
+// AND, OR and ANDNOT THEN the results match std::set_* on the same docs
+TEST(DocBitmapTest, OperationsMatchStdSet) {
+    std::mt19937 rng(42);
+    for (int round = 0; round < 3; round++) {
+        std::set<uint32_t> a = random_docs(rng), b = random_docs(rng);
+        DocBitmap left = build(a), right = build(b);
+
+        std::vector<uint32_t> both, either, only;
+        std::set_intersection(a.begin(), a.end(), b.begin(), b.end(),
+                              std::back_inserter(both));
+        std::set_union(a.begin(), a.end(), b.begin(), b.end(),
+                       std::back_inserter(either));
+        std::set_difference(a.begin(), a.end(), b.begin(), b.end(),
+                            std::back_inserter(only));
+
+        EXPECT_EQ(docs_of(left.intersect(right)), both);
+        EXPECT_EQ(docs_of(left.unite(right)), either);
+        EXPECT_EQ(docs_of(left.difference(right)), only);
+        EXPECT_EQ(left.intersect(right).cardinality(), both.size());
+        EXPECT_TRUE(left.difference(left).empty());
+    }
+}
+
+// TEST: GIVEN a full chunk WHEN it is the other side of an operation THEN the
+// shortcuts return the right docs
+TEST(DocBitmapTest, FullChunkShortcuts) {
+    std::set<uint32_t> all, some = {5, 500, 50000};
+    for (uint32_t doc = 0; doc < 65536; doc++) {
+        all.insert(doc);
+    }
+    DocBitmap full = build(all), sparse = build(some);
+    EXPECT_EQ(docs_of(full.intersect(sparse)),
+              std::vector<uint32_t>(some.begin(), some.end()));
+    EXPECT_EQ(full.unite(sparse).cardinality(), 65536u);
+    EXPECT_TRUE(sparse.difference(full).empty());
+    EXPECT_EQ(full.difference(sparse).cardinality(), 65536u - 3);
+    EXPECT_FALSE(full.difference(sparse).contains(500));
+}
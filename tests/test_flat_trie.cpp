@@ -0,0 +1,335 @@
+#include "flat_trie.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// NOTE: A file of its own per test under the system temp directory, so
+// ctest -j can run the tests side by side
+std::string test_path() {
+  const ::testing::TestInfo *info =
+      ::testing::UnitTest::GetInstance()->current_test_info();
+  return (std::filesystem::temp_directory_path() /
+          (std::string(info->test_suite_name()) + "_" + info->name() + ".ac"))
+      .string();
+}
+
+// INFO: Scored words with shared prefixes, split edges and one node dense
+// enough to switch to the 256-slot table
+void fill(Trie &trie) {
+  for (int i = 0; i < 2000; i++) {
+    trie.insert("w" + std::to_string(i * 7919 % 2000),
+                static_cast<uint32_t>(i * 104729 % 100003));
+  }
+  for (int c = 200; c >= 33; c--) {
+    trie.insert(std::string("x") + static_cast<char>(c) + "y",
+                static_cast<uint32_t>(c));
+  }
+  trie.insert("work", 5);
+  trie.insert("workplace", 9);
+  trie.insert("world", 7);
+}
+
+} // namespace
+
+// TEST: GIVEN a Trie written to disk WHEN mapped as a FlatTrie THEN every
+// prefix search returns the same words in the same order
+TEST(FlatTrieTest, SearchMatchesTrie) {
+  std::string path = test_path();
+  Trie trie;
+  fill(trie);
+  FlatTrie::write(trie, path);
+  FlatTrie flat(path);
+
+  EXPECT_EQ(flat.num_words(), 2000u + 168u + 3u);
+  for (const std::string prefix :
+       {"", "w", "w1", "w19", "wor", "work", "workp", "worlds", "x", "xz",
+        "xzy", "q"}) {
+    ArrayList<std::string> expected = trie.search(prefix);
+    ArrayList<std::string> results = flat.search(prefix);
+    ASSERT_EQ(results.size(), expected.size()) << prefix;
+    for (size_t i = 0; i < expected.size(); i++) {
+      EXPECT_EQ(results[i], expected[i]);
+    }
+  }
+  std::filesystem::remove(path);
+}
+
+// TEST: GIVEN a Trie written to disk WHEN asking the FlatTrie for the top k
+// THEN the completions and their scores match Trie::top_k
+TEST(FlatTrieTest, TopKMatchesTrie) {
+  std::string path = test_path();
+  Trie trie;
+  fill(trie);
+  FlatTrie::write(trie, path);
+  FlatTrie flat(path);
+
+  for (const std::string prefix : {"", "w", "w1", "wo", "workp", "x", "q"}) {
+    for (size_t k : {0, 1, 10, 100}) {
+      ArrayList<Completion> expected = trie.top_k(prefix, k);
+      ArrayList<Completion> results = flat.top_k(prefix, k);
+      ASSERT_EQ(results.size(), expected.size()) << prefix << " " << k;
+      for (size_t i = 0; i < expected.size(); i++) {
+        EXPECT_EQ(results[i].word, expected[i].word);
+        EXPECT_EQ(results[i].score, expected[i].score);
+      }
+    }
+  }
+  std::filesystem::remove(path);
+}
+
+// TEST: GIVEN an empty Trie WHEN written and mapped THEN nothing is found
+TEST(FlatTrieTest, EmptyTrie) {
+  std::string path = test_path();
+  Trie trie;
+  FlatTrie::write(trie, path);
+  FlatTrie flat(path);
+
+  EXPECT_EQ(flat.num_words(), 0u);
+  EXPECT_EQ(flat.search("").size(), 0u);
+  EXPECT_EQ(flat.top_k("a", 10).size(), 0u);
+  std::filesystem::remove(path);
+}
+
+// TEST: GIVEN a missing, foreign or cut short file WHEN opened THEN it throws
+TEST(FlatTrieTest, RejectsMissingAndTruncatedFiles) {
+  std::string path = test_path();
+  std::filesystem::remove(path);
+  EXPECT_THROW(FlatTrie flat(path), std::runtime_error);
+
+  std::ofstream(path) << "not an autocomplete file at all";
+  EXPECT_THROW(FlatTrie flat(path), std::runtime_error);
+
+  Trie trie;
+  fill(trie);
+  FlatTrie::write(trie, path);
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) / 2);
+  EXPECT_THROW(FlatTrie flat(path), std::runtime_error);
+  std::filesystem::remove(path);
+}
+
+// TEST: GIVEN a mapped file WHEN it is written again by either writer THEN
+// the mapping keeps the old words and a new mapping sees the new ones
+TEST(FlatTrieTest, RewriteLeavesMappedFileIntact) {
+  std::string path = test_path();
+  Trie trie;
+  fill(trie);
+  FlatTrie::write(trie, path);
+  FlatTrie old_flat(path);
+  ArrayList<std::string> expected = trie.search("wor");
+
+  Trie other;
+  other.insert("moriarty", 1);
+  FlatTrie::write(other, path);
+  EXPECT_EQ(FlatTrie(path).num_words(), 1u);
+  std::vector<std::string> sorted = {"baker", "lestrade"};
+  FlatTrie::write(
+      sorted.size(),
+      [&sorted](size_t i) { return ScoredWord{sorted[i], 1}; }, path);
+  EXPECT_EQ(FlatTrie(path).num_words(), 2u);
+  EXPECT_FALSE(std::filesystem::exists(path + ".tmp"));
+
+  ArrayList<std::string> results = old_flat.search("wor");
+  ASSERT_EQ(results.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); i++) {
+    EXPECT_EQ(results[i], expected[i]);
+  }
+  EXPECT_EQ(old_flat.num_words(), 2000u + 168u + 3u);
+  std::filesystem::remove(path);
+}
+
+// TEST: GIVEN sorted words WHEN written without a Trie THEN the file is byte
+// for byte the one written from a Trie of the same words, and no staging
+// files are left behind
+TEST(FlatTrieTest, WriteFromSortedWordsMatchesTrie) {
+  std::string path = test_path();
+  std::map<std::string, uint32_t> sets[] = {
+      {},
+      {{"", 4}},
+      {{"", 3}, {"a", 1}, {"ab", 9}, {"abc", 2}, {"abd", 0}, {"b", 5}},
+      {{"abcd", 1}, {"abce", 2}, {"abd", 3}, {"ac", 4}, {"\xc3\xa9t\xc3\xa9", 6},
+       {"zz", 7}, {std::string(300, 'q'), 8}},
+      {}};
+  for (int i = 0; i < 2000; i++) { // NOTE: Dense nodes and split edges
+    sets[4]["w" + std::to_string(i * 7919 % 2000)] = i * 104729 % 100003;
+  }
+  for (int c = 200; c >= 33; c--) {
+    sets[4][std::string("x") + static_cast<char>(c) + "y"] = c;
+  }
+
+  for (const auto &words : sets) {
+    Trie trie;
+    std::vector<std::pair<std::string, uint32_t>> sorted;
+    for (const auto &pair : words) {
+      trie.insert(pair.first, pair.second);
+      sorted.push_back(pair);
+    }
+    FlatTrie::write(trie, path);
+    std::ifstream expected_file(path, std::ios::binary);
+    std::string expected((std::istreambuf_iterator<char>(expected_file)),
+                         std::istreambuf_iterator<char>());
+
+    FlatTrie::write(
+        sorted.size(),
+        [&sorted](size_t i) {
+          return ScoredWord{sorted[i].first, sorted[i].second};
+        },
+        path);
+    std::ifstream actual_file(path, std::ios::binary);
+    std::string actual((std::istreambuf_iterator<char>(actual_file)),
+                       std::istreambuf_iterator<char>());
+    EXPECT_EQ(actual, expected) << words.size() << " words";
+    EXPECT_EQ(FlatTrie(path).num_words(), words.size());
+  }
+
+  for (const char *staging : {".level", ".next", ".labels", ".tmp"}) {
+    EXPECT_FALSE(std::filesystem::exists(path + staging));
+  }
+  std::filesystem::remove(path);
+}
+
+namespace {
+
+// INFO: Plain dynamic programming edit distance, the reference for the
+// automaton walk. With prefix set it is the distance to the closest prefix
+// of b.
+size_t edit_distance(const std::string &a, const std::string &b,
+                     bool prefix) {
+  std::vector<size_t> row(a.size() + 1);
+  for (size_t i = 0; i <= a.size(); i++) {
+    row[i] = i;
+  }
+  size_t best = row[a.size()];
+  for (size_t j = 1; j <= b.size(); j++) {
+    size_t diagonal = row[0];
+    row[0] = j;
+    for (size_t i = 1; i <= a.size(); i++) {
+      size_t above = row[i];
+      row[i] = std::min({diagonal + (a[i - 1] != b[j - 1]), row[i - 1] + 1,
+                         above + 1});
+      diagonal = above;
+    }
+    best = std::min(best, row[a.size()]);
+  }
+  return prefix ? best : row[a.size()];
+}
+
+// INFO: Words with distinct scores so the expected order is unambiguous
+std::vector<std::pair<std::string, uint32_t>> vocabulary() {
+  std::vector<std::pair<std::string, uint32_t>> words;
+  const std::string letters = "abcde";
+  for (uint32_t i = 0; i < 3000; i++) {
+    std::string word;
+    for (uint32_t n = i * 2654435761u, length = 1 + i % 7; length > 0;
+         length--, n /= 5) {
+      word += letters[n % 5];
+    }
+    words.emplace_back(word, i + 1);
+  }
+  return words;
+}
+
+void expect_fuzzy(const FlatTrie &flat,
+                  const std::vector<std::pair<std::string, uint32_t>> &words,
+                  const std::string &query, uint8_t edits, bool prefix) {
+  // NOTE: Last score wins for repeated words, as in Trie::insert
+  std::map<std::string, uint32_t> scores;
+  for (const auto &word : words) {
+    scores[word.first] = word.second;
+  }
+  std::vector<Completion> expected;
+  for (const auto &word : scores) {
+    size_t distance = edit_distance(query, word.first, prefix);
+    if (distance <= edits) {
+      expected.push_back(Completion{word.first, word.second,
+                                    static_cast<uint8_t>(distance)});
+    }
+  }
+  std::sort(expected.begin(), expected.end(),
+            [](const Completion &a, const Completion &b) {
+              return a.distance != b.distance ? a.distance < b.distance
+                                              : a.score > b.score;
+            });
+
+  size_t k = 20;
+  ArrayList<Completion> results = prefix ? flat.fuzzy_top_k(query, k, edits)
+                                         : flat.fuzzy_find(query, k, edits);
+  ASSERT_EQ(results.size(), std::min(k, expected.size())) << query;
+  for (size_t i = 0; i < results.size(); i++) {
+    EXPECT_EQ(results[i].word, expected[i].word) << query;
+    EXPECT_EQ(results[i].score, expected[i].score) << query;
+    EXPECT_EQ(results[i].distance, expected[i].distance) << query;
+  }
+}
+
+} // namespace
+
+// TEST: GIVEN a vocabulary WHEN completing prefixes with up to 0, 1 and 2
+// edits THEN the results match a brute force scan of every word, fewest
+// edits first and then by score
+TEST(FlatTrieTest, FuzzyTopKMatchesBruteForce) {
+  std::string path = test_path();
+  Trie trie;
+  auto words = vocabulary();
+  for (const auto &word : words) {
+    trie.insert(word.first, word.second);
+  }
+  FlatTrie::write(trie, path);
+  FlatTrie flat(path);
+
+  for (const std::string query : {"abc", "eeda", "cabde", "x", "axcd",
+                                  "bbbbbbbbb", "dcbaedcb"}) {
+    for (uint8_t edits = 0; edits <= 2; edits++) {
+      expect_fuzzy(flat, words, query, edits, true);
+    }
+  }
+  std::filesystem::remove(path);
+}
+
+// TEST: GIVEN a vocabulary WHEN looking up whole words with up to 0, 1 and 2
+// edits THEN the results match a brute force scan of every word
+TEST(FlatTrieTest, FuzzyFindMatchesBruteForce) {
+  std::string path = test_path();
+  Trie trie;
+  auto words = vocabulary();
+  for (const auto &word : words) {
+    trie.insert(word.first, word.second);
+  }
+  FlatTrie::write(trie, path);
+  FlatTrie flat(path);
+
+  for (const std::string query : {"abc", "eeda", "cabde", "x", "axcd",
+                                  "abcdeab", "dcbaedcbxx", ""}) {
+    for (uint8_t edits = 0; edits <= 2; edits++) {
+      expect_fuzzy(flat, words, query, edits, false);
+    }
+  }
+  std::filesystem::remove(path);
+}
+
+// TEST: GIVEN a one letter typo WHEN completing and looking up THEN the
+// intended word is found one edit away
+TEST(FlatTrieTest, FuzzyFindsTypos) {
+  std::string path = test_path();
+  Trie trie;
+  fill(trie);
+  FlatTrie::write(trie, path);
+  FlatTrie flat(path);
+
+  EXPECT_EQ(flat.top_k("wprk", 10).size(), 0u);
+  ArrayList<Completion> completions = flat.fuzzy_top_k("wprk", 10, 1);
+  ASSERT_GT(completions.size(), 0u);
+  EXPECT_EQ(completions[0].distance, 1);
+
+  ArrayList<Completion> words = flat.fuzzy_find("wrld", 1, 1);
+  ASSERT_EQ(words.size(), 1u);
+  EXPECT_EQ(words[0].word, "world");
+  EXPECT_EQ(words[0].distance, 1);
+  std::filesystem::remove(path);
+}
@@ -1,5 +1,10 @@
 #include "hashmap.hpp"
+#include "array_list.hpp"
 #include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
 
 // TEST: GIVEN empty hashmap WHEN elements are inserted THEN size is 2 & elements are found
 TEST(HashMapTest, InsertElements) {
@@ -279,3 +284,443 @@ TEST(HashMapTest, IteratorNotEqual) {
     auto iter2 = map.end();
     EXPECT_TRUE(iter1 != iter2);
 }
+
+// TEST: GIVEN 10000 keys WHEN half are erased THEN the rest are still found
+// and erased keys are gone
+TEST(HashMapTest, EraseKeepsOtherKeysReachable) {
+    HashMap<std::string, int> map;
+    for (int i = 0; i < 10000; i++) {
+        map[std::to_string(i)] = i;
+    }
+    for (int i = 0; i < 10000; i += 2) {
+        EXPECT_TRUE(map.erase(std::to_string(i)));
+    }
+
+    EXPECT_EQ(map.size(), 5000);
+    for (int i = 0; i < 10000; i++) {
+        auto iter = map.find(std::to_string(i));
+        if (i % 2 == 0) {
+            EXPECT_EQ(iter, map.end());
+        } else {
+            ASSERT_NE(iter, map.end());
+            EXPECT_EQ((*iter).value, i);
+        }
+    }
+}
+
+// TEST: GIVEN insert/erase churn on a small key set WHEN repeated THEN the
+// map keeps working without growing the key count
+TEST(HashMapTest, ChurnReusesDeletedSlots) {
+    HashMap<int, int> map;
+    for (int round = 0; round < 1000; round++) {
+        for (int i = 0; i < 20; i++) {
+            map.insert(round * 20 + i, i);
+        }
+        for (int i = 0; i < 20; i++) {
+            EXPECT_TRUE(map.erase(round * 20 + i));
+        }
+    }
+    EXPECT_TRUE(map.empty());
+    map.insert(7, 7);
+    EXPECT_EQ((*map.find(7)).value, 7);
+}
+
+// TEST: GIVEN a sliding window of live keys WHEN old keys are erased and new
+// ones inserted for many rounds THEN tombstones are compacted instead of
+// growing the table
+TEST(HashMapTest, ChurnCompactsTombstones) {
+    HashMap<int, int> map;
+    const int window = 1000;
+    for (int i = 0; i < window; i++) {
+        map.insert(i, i);
+    }
+    size_t buckets = map.bucket_count();
+
+    for (int i = window; i < 200000; i++) {
+        map.insert(i, i);
+        EXPECT_TRUE(map.erase(i - window));
+    }
+    EXPECT_EQ(map.size(), static_cast<size_t>(window));
+    EXPECT_LE(map.bucket_count(), buckets * 2);
+    for (int i = 200000 - window; i < 200000; i++) {
+        EXPECT_EQ((*map.find(i)).value, i);
+    }
+    EXPECT_EQ(map.find(0), map.end());
+}
+
+// TEST: GIVEN a hashmap WHEN copied THEN the copy is independent
+TEST(HashMapTest, CopyIsDeep) {
+    HashMap<std::string, int> map;
+    map.insert("one", 1);
+    map.insert("two", 2);
+
+    HashMap<std::string, int> copy(map);
+    copy["one"] = 11;
+    copy.erase("two");
+
+    EXPECT_EQ(map["one"], 1);
+    EXPECT_NE(map.find("two"), map.end());
+    EXPECT_EQ(copy.size(), 1);
+}
+
+// TEST: GIVEN a hashmap WHEN moved THEN the target owns the entries and the
+// source is empty but usable
+TEST(HashMapTest, MoveLeavesSourceEmpty) {
+    HashMap<std::string, int> map;
+    map.insert("one", 1);
+
+    HashMap<std::string, int> moved(std::move(map));
+    EXPECT_EQ(moved["one"], 1);
+    EXPECT_EQ(map.size(), 0);
+    EXPECT_EQ(map.find("one"), map.end());
+
+    map["two"] = 2;
+    EXPECT_EQ(map["two"], 2);
+}
+
+// TEST: GIVEN a moved-from hashmap WHEN copied THEN the copy is empty and
+// usable
+TEST(HashMapTest, CopyOfMovedFromMap) {
+    HashMap<std::string, int> map;
+    map.insert("one", 1);
+    HashMap<std::string, int> moved(std::move(map));
+
+    HashMap<std::string, int> copy(map);
+    EXPECT_EQ(copy.size(), 0);
+    EXPECT_EQ(copy.find("one"), copy.end());
+    copy["two"] = 2;
+    EXPECT_EQ(copy["two"], 2);
+
+    copy = map;
+    EXPECT_EQ(copy.size(), 0);
+}
+
+// NOTE: No default constructor, and counts live instances
+struct Tracked {
+    static int alive;
+    int value;
+    explicit Tracked(int v) : value(v) { alive++; }
+    Tracked(const Tracked &other) : value(other.value) { alive++; }
+    Tracked(Tracked &&other) noexcept : value(other.value) { alive++; }
+    Tracked &operator=(const Tracked &) = default;
+    Tracked &operator=(Tracked &&) noexcept = default;
+    ~Tracked() { alive--; }
+};
+int Tracked::alive = 0;
+
+// TEST: GIVEN values without a default constructor WHEN the map grows,
+// erases, copies and clears THEN only the live entries are constructed
+TEST(HashMapTest, OnlyLiveEntriesAreConstructed) {
+    {
+        HashMap<int, Tracked> map;
+        for (int i = 0; i < 100; i++) {
+            map.try_emplace(i, i);
+        }
+        EXPECT_EQ(Tracked::alive, 100);
+        map.erase(5);
+        map.erase(99);
+        EXPECT_EQ(Tracked::alive, 98);
+        EXPECT_EQ((*map.find(98)).value.value, 98);
+
+        HashMap<int, Tracked> copy(map);
+        EXPECT_EQ(Tracked::alive, 196);
+        copy.clear();
+        EXPECT_EQ(Tracked::alive, 98);
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+// NOTE: Copies throw once countdown reaches zero
+struct ThrowingCopy {
+    static int countdown;
+    int value;
+    explicit ThrowingCopy(int v) : value(v) {}
+    ThrowingCopy(const ThrowingCopy &other) : value(other.value) {
+        if (countdown-- == 0) {
+            throw std::runtime_error("copy failed");
+        }
+    }
+    ThrowingCopy(ThrowingCopy &&other) noexcept = default;
+    ThrowingCopy &operator=(const ThrowingCopy &) = default;
+    ThrowingCopy &operator=(ThrowingCopy &&) noexcept = default;
+};
+int ThrowingCopy::countdown = -1;
+
+// TEST: GIVEN a value copy that throws partway WHEN copying or assigning a
+// map THEN the assigned map keeps its old entries and stays usable
+TEST(HashMapTest, ThrowingCopyLeavesTargetIntact) {
+    HashMap<std::string, ThrowingCopy> source;
+    for (int i = 0; i < 20; i++) {
+        source.try_emplace(std::to_string(i), i);
+    }
+    HashMap<std::string, ThrowingCopy> target;
+    target.try_emplace("old", 42);
+
+    ThrowingCopy::countdown = 10;
+    using Map = HashMap<std::string, ThrowingCopy>;
+    EXPECT_THROW(Map copy(source), std::runtime_error);
+    ThrowingCopy::countdown = 10;
+    EXPECT_THROW(target = source, std::runtime_error);
+    ASSERT_EQ(target.size(), 1);
+    EXPECT_EQ((*target.find("old")).value.value, 42);
+    target.try_emplace("new", 7);
+    EXPECT_EQ(target.size(), 2);
+
+    ThrowingCopy::countdown = -1;
+    target = source;
+    EXPECT_EQ(target.size(), 20);
+    EXPECT_EQ((*target.find("19")).value.value, 19);
+}
+
+// TEST: GIVEN the same text as std::string and std::string_view WHEN hashed
+// THEN both policies agree, and different text hashes differently
+TEST(HashMapTest, StringPoliciesAgree) {
+    std::string word = "moriarty";
+    EXPECT_EQ(HashPolicy<std::string>{}(word),
+              HashPolicy<std::string_view>{}(std::string_view(word)));
+    EXPECT_NE(HashPolicy<std::string>{}("moriarty"),
+              HashPolicy<std::string>{}("moriartY"));
+    EXPECT_NE(HashPolicy<std::string>{}(""), HashPolicy<std::string>{}("a"));
+
+    // NOTE: Lengths around the 4/16/48 byte paths of hash_bytes
+    std::string text(100, 'x');
+    for (size_t length = 1; length < text.size(); length++) {
+        EXPECT_NE(hash_bytes(text.data(), length),
+                  hash_bytes(text.data(), length - 1));
+    }
+}
+
+// TEST: GIVEN a string map WHEN probed with a std::string_view THEN find and
+// erase work without building a std::string
+TEST(HashMapTest, HeterogeneousLookup) {
+    HashMap<std::string, int> map;
+    map.insert("holmes", 1);
+    map.insert("watson", 2);
+
+    std::string_view buffer = "sherlock holmes";
+    auto iter = map.find(buffer.substr(9));
+    ASSERT_NE(iter, map.end());
+    EXPECT_EQ((*iter).value, 1);
+    EXPECT_EQ(map.find(std::string_view("lestrade")), map.end());
+
+    EXPECT_TRUE(map.erase(std::string_view("watson")));
+    EXPECT_EQ(map.size(), 1);
+}
+
+// NOTE: Every key collides, so all probing goes through the control bytes
+struct ConstantHash {
+    uint64_t operator()(int) const { return 42; }
+};
+
+// TEST: GIVEN a policy where every key has the same hash WHEN many keys are
+// inserted and erased THEN the map still finds each of them
+TEST(HashMapTest, CustomPolicyWithCollisions) {
+    HashMap<int, int, ConstantHash> map;
+    for (int i = 0; i < 200; i++) {
+        map[i] = i * 2;
+    }
+    for (int i = 0; i < 200; i += 3) {
+        EXPECT_TRUE(map.erase(i));
+    }
+    for (int i = 0; i < 200; i++) {
+        auto iter = map.find(i);
+        if (i % 3 == 0) {
+            EXPECT_EQ(iter, map.end());
+        } else {
+            ASSERT_NE(iter, map.end());
+            EXPECT_EQ((*iter).value, i * 2);
+        }
+    }
+}
+
+// TEST: GIVEN sequential integer and char keys WHEN inserted THEN all are
+// found again
+TEST(HashMapTest, IntegralKeys) {
+    HashMap<uint32_t, int> numbers;
+    for (uint32_t i = 0; i < 100000; i++) {
+        numbers[i] = static_cast<int>(i);
+    }
+    EXPECT_EQ(numbers.size(), 100000);
+    EXPECT_EQ((*numbers.find(99999)).value, 99999);
+
+    HashMap<char, int> letters;
+    for (char c = 'a'; c <= 'z'; c++) {
+        letters[c] = c - 'a';
+    }
+    EXPECT_EQ(letters.size(), 26);
+    EXPECT_EQ((*letters.find('q')).value, 'q' - 'a');
+}
+
+// TEST: GIVEN a present key WHEN try_emplace is called with an rvalue THEN the
+// entry is untouched and the argument is not moved from
+TEST(HashMapTest, TryEmplaceDoesNotOverwrite) {
+    HashMap<std::string, std::string> map;
+    std::string first = "first";
+    auto inserted = map.try_emplace("key", std::move(first));
+    EXPECT_TRUE(inserted.second);
+    EXPECT_EQ(inserted.first->value, "first");
+
+    std::string second = "second";
+    auto existing = map.try_emplace("key", std::move(second));
+    EXPECT_FALSE(existing.second);
+    EXPECT_EQ(existing.first->value, "first");
+    EXPECT_EQ(second, "second");
+    EXPECT_EQ(map.size(), 1);
+}
+
+// TEST: GIVEN a string_view key WHEN try_emplace inserts it THEN it is stored
+// as a std::string and found by either type
+TEST(HashMapTest, TryEmplaceHeterogeneousKey) {
+    HashMap<std::string, int> map;
+    std::string_view view = "apple";
+    EXPECT_TRUE(map.try_emplace(view, 1).second);
+    EXPECT_FALSE(map.try_emplace(std::string("apple"), 2).second);
+    EXPECT_EQ((*map.find(std::string("apple"))).value, 1);
+    EXPECT_EQ(map.size(), 1);
+}
+
+// TEST: GIVEN insert_or_assign WHEN the key is new and then present THEN it
+// inserts once and overwrites after
+TEST(HashMapTest, InsertOrAssign) {
+    HashMap<std::string, ArrayList<int>> map;
+    ArrayList<int> values;
+    values.push_back(1);
+    EXPECT_TRUE(map.insert_or_assign("key", values).second);
+
+    ArrayList<int> replacement;
+    replacement.push_back(2);
+    replacement.push_back(3);
+    auto result = map.insert_or_assign("key", std::move(replacement));
+    EXPECT_FALSE(result.second);
+    EXPECT_EQ(result.first->value.size(), 2);
+    EXPECT_EQ(result.first->value[0], 2);
+    EXPECT_EQ(map.size(), 1);
+}
+
+// TEST: GIVEN rvalue insert and emplace WHEN used THEN values are moved in and
+// emplace reports existing keys
+TEST(HashMapTest, RvalueInsertAndEmplace) {
+    HashMap<std::string, std::string> map;
+    std::string key = "key";
+    std::string value(64, 'x'); // NOTE: Long enough to live on the heap
+    const char *buffer = value.data();
+    map.insert(std::move(key), std::move(value));
+    EXPECT_EQ((*map.find("key")).value.data(), buffer);
+
+    auto emplaced = map.emplace("other", 3, 'y');
+    EXPECT_TRUE(emplaced.second);
+    EXPECT_EQ(emplaced.first->value, "yyy");
+    EXPECT_FALSE(map.emplace("other", "zzz").second);
+    EXPECT_EQ((*map.find("other")).value, "yyy");
+}
+
+// TEST: GIVEN reserve(n) WHEN n keys are inserted THEN entries never move
+TEST(HashMapTest, ReserveAvoidsGrowth) {
+    HashMap<int, int> map;
+    map.reserve(1000);
+    map[0] = 0;
+    const int *first = &(*map.find(0)).value;
+    for (int i = 1; i < 1000; i++) {
+        map[i] = i;
+    }
+    EXPECT_EQ(&(*map.find(0)).value, first);
+    EXPECT_EQ(map.size(), 1000);
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_EQ((*map.find(i)).value, i);
+    }
+}
+
+// TEST: GIVEN a table at its load limit WHEN existing keys are looked up or
+// assigned THEN it does not grow, and the next new key grows it
+TEST(HashMapTest, HitsNeverGrow) {
+    HashMap<int, int> map;
+    for (int i = 0; i < 14; i++) { // NOTE: 7/8 of the initial 16 slots
+        map[i] = i;
+    }
+    EXPECT_EQ(map.bucket_count(), 16);
+
+    for (int i = 0; i < 14; i++) {
+        map[i] += 1;
+        EXPECT_FALSE(map.try_emplace(i, 0).second);
+    }
+    EXPECT_EQ(map.bucket_count(), 16);
+
+    map[14] = 14;
+    EXPECT_EQ(map.bucket_count(), 32);
+    for (int i = 0; i < 15; i++) {
+        EXPECT_EQ((*map.find(i)).value, i < 14 ? i + 1 : 14);
+    }
+}
+
+// TEST: GIVEN a key or value stored in the map WHEN inserted under a new key
+// as the entries grow THEN the new entry is copied before the old ones move
+TEST(HashMapTest, InsertOwnEntryDuringGrowth) {
+    HashMap<std::string, std::string> map;
+    map["old"] = std::string(100, 'x'); // NOTE: Past small string storage
+    for (int i = 1; i < 64; i++) {
+        std::string key = "k" + std::to_string(i);
+        map.insert_or_assign(key, (*map.find("old")).value);
+        map.try_emplace((*map.begin()).value, (*map.find(key)).value);
+    }
+    EXPECT_EQ(map.size(), 65);
+    EXPECT_EQ((*map.find("k63")).value, std::string(100, 'x'));
+    EXPECT_EQ((*map.find(std::string(100, 'x'))).value, std::string(100, 'x'));
+}
+
+// TEST: GIVEN present and missing keys (more than one batch) WHEN looked up
+// with find_many THEN each result matches find
+TEST(HashMapTest, FindManyMatchesFind) {
+    HashMap<std::string, int> map;
+    for (int i = 0; i < 1000; i++) {
+        map.insert("key" + std::to_string(i), i);
+    }
+
+    std::vector<std::string_view> keys;
+    std::vector<std::string> storage;
+    for (int i = 0; i < 50; i++) {
+        storage.push_back("key" + std::to_string(i * 37));
+        storage.push_back("missing" + std::to_string(i));
+    }
+    for (const std::string &key : storage) {
+        keys.push_back(key);
+    }
+
+    std::vector<HashMap<std::string, int>::Iterator> out(keys.size());
+    map.find_many(keys.data(), keys.size(), out.data());
+    for (size_t i = 0; i < keys.size(); i++) {
+        EXPECT_EQ(out[i], map.find(keys[i])) << keys[i];
+    }
+
+    HashMap<std::string, int> empty;
+    empty.find_many(keys.data(), keys.size(), out.data());
+    EXPECT_EQ(out[0], empty.end());
+}
+
+// TEST: GIVEN the stats policy WHEN keys are inserted and looked up THEN hits,
+// misses and resizes are counted, and the default policy adds no size
+TEST(HashMapTest, StatsPolicyCountsProbes) {
+    HashMap<int, int, HashPolicy<int>, HashMapStats> map;
+    for (int i = 0; i < 100; i++) {
+        map.insert(i, i);
+    }
+    EXPECT_GT(map.stats().resizes, 0u);
+    EXPECT_EQ(map.stats().rehashes, 0u);
+    EXPECT_EQ(map.stats().misses, 100u); // NOTE: Every insert probes first
+
+    map.reset_stats();
+    for (int i = 0; i < 100; i++) {
+        map.find(i);
+    }
+    map.find(1000);
+    EXPECT_EQ(map.stats().hits, 100u);
+    EXPECT_EQ(map.stats().misses, 1u);
+    EXPECT_GE(map.stats().average_hit_groups(), 1.0);
+    EXPECT_GE(map.stats().max_groups, 1u);
+    EXPECT_GE(map.stats().key_compares, 100u);
+
+    // NOTE: groups, entries and four counters - the empty policy is free
+    EXPECT_EQ(sizeof(HashMap<int, int>),
+              2 * sizeof(void *) + 4 * sizeof(size_t));
+    EXPECT_LT(sizeof(HashMap<int, int>),
+              sizeof(HashMap<int, int, HashPolicy<int>, HashMapStats>));
+}
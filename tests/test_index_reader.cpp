@@ -0,0 +1,212 @@
+#include "index_reader.h"
+#include "index_writer.h"
+#include "indexer.h"
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// NOTE: A directory of its own per test under the system temp directory, so
+// ctest -j can run the tests side by side
+static std::string test_dir() {
+  const ::testing::TestInfo *info =
+      ::testing::UnitTest::GetInstance()->current_test_info();
+  return (std::filesystem::temp_directory_path() /
+          (std::string(info->test_suite_name()) + "_" + info->name()))
+      .string();
+}
+
+// NOTE: Helper function to index a small directory and save it
+static void build_index(const std::string &dir) {
+  std::filesystem::create_directory(dir);
+  std::ofstream(dir + "/file1.txt") << "holmes watson holmes baker";
+  std::ofstream(dir + "/file2.txt") << "watson street";
+  std::ofstream(dir + "/file3.txt") << "lestrade";
+
+  Indexer indexer(dir);
+  indexer.index_directory();
+  indexer.serialize_index();
+}
+
+// TEST: GIVEN a saved index WHEN opened with IndexReader THEN the document
+// table and every term are available in sorted order
+TEST(IndexReaderTest, OpenListsDocumentsAndSortedTerms) {
+  std::string temp_dir = test_dir();
+  build_index(temp_dir);
+
+  IndexReader reader(temp_dir + "/clouseau.idx");
+  EXPECT_EQ(reader.num_documents(), 3);
+  EXPECT_EQ(reader.num_terms(), 5);
+  for (size_t i = 1; i < reader.num_terms(); i++) {
+    EXPECT_LT(reader.term(i - 1).term, reader.term(i).term);
+  }
+
+  std::filesystem::remove_all(temp_dir);
+}
+
+// TEST: GIVEN a saved index WHEN a term is looked up THEN its totals and
+// postings match the in-memory index
+TEST(IndexReaderTest, FindMatchesInMemoryIndex) {
+  std::string temp_dir = test_dir();
+  build_index(temp_dir);
+
+  Indexer indexer(temp_dir);
+  indexer.deserialize_index();
+  IndexReader reader(temp_dir + "/clouseau.idx");
+
+  for (auto &pair : indexer.index) {
+    TermInfo info;
+    ASSERT_TRUE(reader.find(pair.key, info)) << pair.key;
+    EXPECT_EQ(info.term, pair.key);
+    EXPECT_EQ(static_cast<int>(info.total), pair.value.total);
+    EXPECT_EQ(info.df, pair.value.files.size());
+    EXPECT_DOUBLE_EQ(reader.idf(info), pair.value.idf);
+
+    uint32_t docs[POSTINGS_BLOCK_SIZE], counts[POSTINGS_BLOCK_SIZE];
+    PostingsDecoder decoder = reader.postings(info);
+    size_t n = decoder.next(docs, counts);
+    ASSERT_EQ(n, pair.value.files.size());
+    for (size_t i = 0; i < n; i++) {
+      EXPECT_EQ(docs[i], pair.value.files[i].doc);
+      EXPECT_EQ(static_cast<int>(counts[i]), pair.value.files[i].count);
+    }
+  }
+
+  TermInfo info;
+  EXPECT_FALSE(reader.find("moriarty", info));
+  EXPECT_FALSE(reader.find("", info));
+  EXPECT_FALSE(reader.find("zzz", info));
+
+  std::filesystem::remove_all(temp_dir);
+}
+
+// TEST: GIVEN a mix of present, missing, repeated and boundary terms WHEN
+// looked up with find_many THEN every result matches a single find
+TEST(IndexReaderTest, FindManyMatchesFind) {
+  std::string temp_dir = test_dir();
+  build_index(temp_dir);
+  IndexReader reader(temp_dir + "/clouseau.idx");
+
+  std::vector<std::string_view> terms = {"watson", "aaa",     "street",
+                                         "zzz",    "holmes",  "watson",
+                                         "",       "lestrade", "holmesx"};
+  std::vector<TermInfo> infos(terms.size());
+  std::unique_ptr<bool[]> found(new bool[terms.size()]);
+  reader.find_many(terms.data(), terms.size(), infos.data(), found.get());
+
+  for (size_t i = 0; i < terms.size(); i++) {
+    TermInfo expected;
+    ASSERT_EQ(found[i], reader.find(terms[i], expected)) << terms[i];
+    if (found[i]) {
+      EXPECT_EQ(infos[i].term, expected.term);
+      EXPECT_EQ(infos[i].df, expected.df);
+      EXPECT_EQ(infos[i].postings, expected.postings);
+    }
+  }
+  reader.find_many(terms.data(), 0, infos.data(), found.get());
+
+  std::filesystem::remove_all(temp_dir);
+}
+
+// TEST: GIVEN a missing or cut short index file WHEN opened THEN it throws
+TEST(IndexReaderTest, RejectsMissingAndTruncatedFiles) {
+  std::string temp_dir = test_dir();
+  EXPECT_THROW(IndexReader(temp_dir + "/clouseau.idx"), std::runtime_error);
+
+  build_index(temp_dir);
+  std::string path = temp_dir + "/clouseau.idx";
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) - 4);
+  EXPECT_THROW(IndexReader reader(path), std::runtime_error);
+
+  std::filesystem::remove_all(temp_dir);
+}
+
+// TEST: GIVEN terms written with IndexWriter WHEN read back THEN the
+// dictionary holds each term's total and df next to its postings
+TEST(IndexReaderTest, WriterRoundTrip) {
+  std::string temp_dir = test_dir();
+  std::filesystem::create_directory(temp_dir);
+
+  ArrayList<Document> documents;
+  for (uint32_t i = 0; i < 300; i++) {
+    documents.push_back(Document{"doc" + std::to_string(i), 0, 0, 0, 10});
+  }
+
+  Frequency common{0, 0.0, {}};
+  for (uint32_t i = 300; i-- > 0;) { // NOTE: Out of order on purpose
+    common.files.push_back(FileFrequency{i, 2, 0.0});
+    common.total += 2;
+  }
+  Frequency rare{1, 0.0, {}};
+  rare.files.push_back(FileFrequency{7, 1, 0.0});
+
+  IndexWriter writer(temp_dir + "/clouseau.idx", documents);
+  writer.add("common", common);
+  writer.add("rare", rare);
+  EXPECT_EQ(writer.finish(), 2u);
+  // NOTE: The dictionary and term table are staged on disk until finish()
+  EXPECT_FALSE(std::filesystem::exists(temp_dir + "/clouseau.idx.dictionary"));
+  EXPECT_FALSE(std::filesystem::exists(temp_dir + "/clouseau.idx.terms"));
+  EXPECT_FALSE(std::filesystem::exists(temp_dir + "/clouseau.idx.tmp"));
+
+  IndexReader reader(temp_dir + "/clouseau.idx");
+  EXPECT_EQ(reader.num_documents(), 300);
+  EXPECT_EQ(reader.documents()[299].file, "doc299");
+
+  TermInfo info;
+  ASSERT_TRUE(reader.find("common", info));
+  EXPECT_EQ(info.total, 600u);
+  EXPECT_EQ(info.df, 300u);
+  EXPECT_DOUBLE_EQ(reader.idf(info), 0.0);
+
+  uint32_t docs[POSTINGS_BLOCK_SIZE], counts[POSTINGS_BLOCK_SIZE];
+  PostingsDecoder decoder = reader.postings(info);
+  uint32_t expected = 0;
+  for (size_t n = decoder.next(docs, counts); n > 0;
+       n = decoder.next(docs, counts)) {
+    for (size_t i = 0; i < n; i++) {
+      EXPECT_EQ(docs[i], expected++);
+      EXPECT_EQ(counts[i], 2u);
+    }
+  }
+  EXPECT_EQ(expected, 300u);
+
+  ASSERT_TRUE(reader.find("rare", info));
+  EXPECT_EQ(info.df, 1u);
+  EXPECT_DOUBLE_EQ(reader.tf(7, 1), 0.1);
+
+  std::filesystem::remove_all(temp_dir);
+}
+
+// TEST: GIVEN an index mapped by a reader WHEN the index is written again
+// THEN the reader keeps serving the old index and a new reader sees the new
+// one
+TEST(IndexReaderTest, RewriteLeavesMappedIndexIntact) {
+  std::string temp_dir = test_dir();
+  build_index(temp_dir);
+  IndexReader old_reader(temp_dir + "/clouseau.idx");
+
+  std::ofstream(temp_dir + "/file3.txt") << "moriarty moriarty";
+  Indexer indexer(temp_dir);
+  indexer.index_directory();
+  indexer.serialize_index();
+  EXPECT_FALSE(std::filesystem::exists(temp_dir + "/clouseau.idx.tmp"));
+
+  TermInfo info;
+  ASSERT_TRUE(old_reader.find("lestrade", info));
+  uint32_t docs[POSTINGS_BLOCK_SIZE], counts[POSTINGS_BLOCK_SIZE];
+  PostingsDecoder decoder = old_reader.postings(info);
+  EXPECT_EQ(decoder.next(docs, counts), 1u);
+  EXPECT_EQ(counts[0], 1u);
+  EXPECT_FALSE(old_reader.find("moriarty", info));
+
+  IndexReader new_reader(temp_dir + "/clouseau.idx");
+  EXPECT_FALSE(new_reader.find("lestrade", info));
+  ASSERT_TRUE(new_reader.find("moriarty", info));
+  EXPECT_EQ(info.total, 2u);
+
+  std::filesystem::remove_all(temp_dir);
+}
@@ -1,5 +1,6 @@
 #include "hashmap.hpp"
 #include "indexer.h"
+#include <chrono>
 #include <filesystem>
 #include <fstream>
 #include <gtest/gtest.h>
@@ -15,10 +16,20 @@ void create_temp_file(const std::string &dir, const std::string &filename,
   file.close();
 }
 
+// NOTE: A directory of its own per test under the system temp directory, so
+// ctest -j can run the tests side by side
+static std::string test_dir() {
+  const ::testing::TestInfo *info =
+      ::testing::UnitTest::GetInstance()->current_test_info();
+  return (std::filesystem::temp_directory_path() /
+          (std::string(info->test_suite_name()) + "_" + info->name()))
+      .string();
+}
+
 // TEST: GIVEN a directory with files WHEN create_temp_file is called THEN it
 // should create the files.
 TEST(IndexerTest, CreateTempFile) {
-  std::string temp_dir = "./test_data";
+  std::string temp_dir = test_dir();
   std::filesystem::create_directory(temp_dir);
   create_temp_file(temp_dir, "file1.txt", "word1 word2 word3");
   create_temp_file(temp_dir, "file2.txt", "word2 word3 word4");
@@ -32,7 +43,7 @@ TEST(IndexerTest, CreateTempFile) {
 // TEST: GIVEN a directory with files WHEN get_directory_files is called THEN it
 // indexes correctly.
 TEST(IndexerTest, GetDirectoryFiles) {
-  std::string temp_dir = "./test_data";
+  std::string temp_dir = test_dir();
   std::filesystem::create_directory(temp_dir);
   create_temp_file(temp_dir, "file1.txt", "i am a test file");
   create_temp_file(temp_dir, "file2.txt", "i am another test file");
@@ -47,10 +58,38 @@ TEST(IndexerTest, GetDirectoryFiles) {
   std::filesystem::remove_all(temp_dir);
 }
 
+// TEST: GIVEN files of very different sizes WHEN indexed with 1 and 3 threads
+// THEN both indexes hold the same totals and postings
+TEST(IndexerTest, ThreadCountDoesNotChangeIndex) {
+  std::string temp_dir = test_dir();
+  std::filesystem::create_directory(temp_dir);
+  std::string big;
+  for (int i = 0; i < 500; i++) {
+    big += "detective watson baker street ";
+  }
+  create_temp_file(temp_dir, "big.txt", big);
+  create_temp_file(temp_dir, "small.txt", "watson");
+  create_temp_file(temp_dir, "medium.txt", "baker street watson watson");
+  create_temp_file(temp_dir, "other.txt", "street lamp");
+
+  Indexer single(temp_dir);
+  single.index_directory(1);
+  Indexer multi(temp_dir);
+  multi.index_directory(3);
+
+  EXPECT_EQ(single.index.size(), multi.index.size());
+  EXPECT_EQ(multi.index["watson"].total, 503);
+  EXPECT_EQ(multi.index["watson"].files.size(), 3);
+  EXPECT_EQ(multi.index["street"].total, single.index["street"].total);
+  EXPECT_EQ(multi.index["lamp"].files.size(), 1);
+
+  std::filesystem::remove_all(temp_dir);
+}
+
 // TEST: GIVEN a directory with indexed files WHEN serialize_index is called
 // THEN it should serialize the index.
 TEST(IndexerTest, SerializeIndex) {
-  std::string temp_dir = "./test_data";
+  std::string temp_dir = test_dir();
   std::filesystem::create_directory(temp_dir);
   create_temp_file(temp_dir, "file1.txt", "i am a test file");
   create_temp_file(temp_dir, "file2.txt", "i am another test file");
@@ -67,7 +106,7 @@ TEST(IndexerTest, SerializeIndex) {
 // TEST: GIVEN a directory with indexed files WHEN deserialize_index is called
 // THEN it should deserialize the index.
 TEST(IndexerTest, DeserializeIndex) {
-  std::string temp_dir = "./test_data";
+  std::string temp_dir = test_dir();
   std::filesystem::create_directory(temp_dir);
   create_temp_file(temp_dir, "file1.txt", "i am a test file");
   create_temp_file(temp_dir, "file2.txt", "i am another test file");
@@ -80,6 +119,228 @@ TEST(IndexerTest, DeserializeIndex) {
   new_indexer.deserialize_index();
 
   EXPECT_EQ(indexer.index.size(), new_indexer.index.size());
+  ASSERT_EQ(new_indexer.documents.size(), 2);
+
+  // NOTE: Postings hold doc IDs, resolved through the document table
+  Frequency &freq = new_indexer.index["another"];
+  ASSERT_EQ(freq.files.size(), 1);
+  EXPECT_EQ(new_indexer.documents[freq.files[0].doc].file, "file2.txt");
+
+  std::filesystem::remove_all(temp_dir);
+}
+
+// TEST: GIVEN a memory budget far below the corpus size WHEN indexed with
+// index_directory_external THEN runs are merged into an index identical to
+// the in-memory one, and no run files are left behind
+TEST(IndexerTest, ExternalIndexMatchesInMemory) {
+  std::string temp_dir = test_dir();
+  std::filesystem::create_directory(temp_dir);
+  create_temp_file(temp_dir, "file1.txt", "holmes watson baker street");
+  create_temp_file(temp_dir, "file2.txt", "watson lestrade street street");
+  create_temp_file(temp_dir, "file3.txt", "moriarty holmes holmes");
+  create_temp_file(temp_dir, "file4.txt", "adler watson");
+
+  Indexer in_memory(temp_dir);
+  in_memory.index_directory(2);
+
+  Indexer external(temp_dir);
+  external.index_directory_external(1, 2); // NOTE: spill after every file
+  external.deserialize_index();
+
+  EXPECT_EQ(external.index.size(), in_memory.index.size());
+  for (auto &pair : in_memory.index) {
+    ASSERT_NE(external.index.find(pair.key), external.index.end());
+    Frequency &freq = external.index[pair.key];
+    EXPECT_EQ(freq.total, pair.value.total);
+    EXPECT_EQ(freq.files.size(), pair.value.files.size());
+    EXPECT_DOUBLE_EQ(freq.idf, pair.value.idf);
+  }
+
+  for (const auto &entry : std::filesystem::directory_iterator(temp_dir)) {
+    EXPECT_EQ(entry.path().string().find(".run"), std::string::npos);
+  }
+
+  std::filesystem::remove_all(temp_dir);
+}
+
+// TEST: GIVEN a saved index WHEN files are added, modified, touched and
+// deleted and update_index is called THEN the index matches a full rebuild
+TEST(IndexerTest, UpdateIndexMatchesFullRebuild) {
+  std::string temp_dir = test_dir();
+  std::filesystem::create_directory(temp_dir);
+  create_temp_file(temp_dir, "file1.txt", "holmes watson baker street");
+  create_temp_file(temp_dir, "file2.txt", "watson lestrade");
+  create_temp_file(temp_dir, "file3.txt", "moriarty holmes");
+  create_temp_file(temp_dir, "file4.txt", "adler holmes");
+
+  {
+    Indexer indexer(temp_dir);
+    indexer.update_index(); // NOTE: No index yet, so a full build
+    indexer.serialize_index();
+    EXPECT_EQ(indexer.documents.size(), 4);
+  }
+
+  create_temp_file(temp_dir, "file2.txt", "watson lestrade gregson gregson");
+  std::filesystem::remove(temp_dir + "/file3.txt");
+  create_temp_file(temp_dir, "file5.txt", "hudson street");
+  std::filesystem::last_write_time(
+      temp_dir + "/file4.txt",
+      std::filesystem::last_write_time(temp_dir + "/file4.txt") +
+          std::chrono::hours(1));
+
+  Indexer updated(temp_dir);
+  testing::internal::CaptureStdout();
+  updated.update_index();
+  std::string output = testing::internal::GetCapturedStdout();
+  EXPECT_NE(output.find("Added 1, modified 1, removed 1, unchanged 2"),
+            std::string::npos);
+
+  Indexer rebuilt(temp_dir);
+  rebuilt.index_directory();
+
+  EXPECT_EQ(updated.index.size(), rebuilt.index.size());
+  EXPECT_EQ(updated.index.find("moriarty"), updated.index.end());
+  for (auto &pair : rebuilt.index) {
+    ASSERT_NE(updated.index.find(pair.key), updated.index.end()) << pair.key;
+    Frequency &freq = updated.index[pair.key];
+    EXPECT_EQ(freq.total, pair.value.total) << pair.key;
+    EXPECT_EQ(freq.files.size(), pair.value.files.size()) << pair.key;
+    EXPECT_DOUBLE_EQ(freq.idf, pair.value.idf) << pair.key;
+
+    // NOTE: Doc IDs differ between the two, so compare by file name
+    Set<std::string> updated_files, rebuilt_files;
+    for (const auto &file_freq : freq.files) {
+      ASSERT_LT(file_freq.doc, updated.documents.size());
+      updated_files.insert(updated.documents[file_freq.doc].file);
+    }
+    for (const auto &file_freq : pair.value.files) {
+      rebuilt_files.insert(rebuilt.documents[file_freq.doc].file);
+    }
+    EXPECT_EQ(updated_files.intersect(rebuilt_files).size(),
+              rebuilt_files.size())
+        << pair.key;
+  }
+  EXPECT_EQ(updated.documents.size(), 4);
+
+  std::filesystem::remove_all(temp_dir);
+}
+
+// TEST: GIVEN a saved index WHEN update_index runs with nothing changed, then
+// with a file only touched THEN it reports None without decoding the index,
+// then Manifest, and the new mtime is kept without rewriting the trie
+TEST(IndexerTest, UpdateIndexReportsWhatChanged) {
+  std::string temp_dir = test_dir();
+  std::filesystem::create_directory(temp_dir);
+  create_temp_file(temp_dir, "file1.txt", "holmes watson baker street");
+  create_temp_file(temp_dir, "file2.txt", "watson lestrade");
+
+  {
+    Indexer indexer(temp_dir);
+    EXPECT_EQ(indexer.update_index(), IndexChange::Postings);
+    indexer.serialize_index();
+  }
+
+  testing::internal::CaptureStdout();
+  {
+    Indexer indexer(temp_dir);
+    EXPECT_EQ(indexer.update_index(), IndexChange::None);
+    EXPECT_EQ(indexer.index.size(), 0); // NOTE: Postings never decoded
+  }
+
+  std::filesystem::last_write_time(
+      temp_dir + "/file2.txt",
+      std::filesystem::last_write_time(temp_dir + "/file2.txt") +
+          std::chrono::hours(1));
+  {
+    Indexer indexer(temp_dir);
+    EXPECT_EQ(indexer.update_index(), IndexChange::Manifest);
+    std::filesystem::remove(temp_dir + "/clouseau.ac");
+    indexer.serialize_index(false);
+    EXPECT_FALSE(std::filesystem::exists(temp_dir + "/clouseau.ac"));
+  }
+  {
+    Indexer indexer(temp_dir);
+    EXPECT_EQ(indexer.update_index(), IndexChange::None);
+    indexer.deserialize_index();
+    EXPECT_EQ(indexer.index.size(), 5);
+  }
+  testing::internal::GetCapturedStdout();
+
+  std::filesystem::remove_all(temp_dir);
+}
+
+// TEST: GIVEN an index built with a memory budget WHEN files are added,
+// modified, touched and deleted and update_index_external is called THEN the
+// index matches a full rebuild and a second run finds nothing to do
+TEST(IndexerTest, UpdateIndexExternalMatchesFullRebuild) {
+  std::string temp_dir = test_dir();
+  std::filesystem::create_directory(temp_dir);
+  create_temp_file(temp_dir, "file1.txt", "holmes watson baker street");
+  create_temp_file(temp_dir, "file2.txt", "watson lestrade");
+  create_temp_file(temp_dir, "file3.txt", "moriarty holmes");
+  create_temp_file(temp_dir, "file4.txt", "adler holmes");
+
+  testing::internal::CaptureStdout();
+  {
+    Indexer indexer(temp_dir);
+    EXPECT_EQ(indexer.update_index_external(1, 2), IndexChange::Postings);
+  }
+  testing::internal::GetCapturedStdout();
+
+  create_temp_file(temp_dir, "file2.txt", "watson lestrade gregson gregson");
+  std::filesystem::remove(temp_dir + "/file3.txt");
+  create_temp_file(temp_dir, "file5.txt", "hudson street");
+  std::filesystem::last_write_time(
+      temp_dir + "/file4.txt",
+      std::filesystem::last_write_time(temp_dir + "/file4.txt") +
+          std::chrono::hours(1));
+
+  testing::internal::CaptureStdout();
+  {
+    Indexer indexer(temp_dir);
+    EXPECT_EQ(indexer.update_index_external(1, 2), IndexChange::Postings);
+  }
+  std::string output = testing::internal::GetCapturedStdout();
+  EXPECT_NE(output.find("Added 1, modified 1, removed 1, unchanged 2"),
+            std::string::npos);
+
+  Indexer updated(temp_dir);
+  updated.deserialize_index();
+  Indexer rebuilt(temp_dir);
+  rebuilt.index_directory();
+
+  ASSERT_EQ(updated.documents.size(), 4);
+  EXPECT_EQ(updated.index.size(), rebuilt.index.size());
+  EXPECT_EQ(updated.index.find("moriarty"), updated.index.end());
+  for (auto &pair : rebuilt.index) {
+    ASSERT_NE(updated.index.find(pair.key), updated.index.end()) << pair.key;
+    Frequency &freq = updated.index[pair.key];
+    EXPECT_EQ(freq.total, pair.value.total) << pair.key;
+    EXPECT_DOUBLE_EQ(freq.idf, pair.value.idf) << pair.key;
+
+    // NOTE: Doc IDs differ between the two, so compare by file name
+    Set<std::string> updated_files, rebuilt_files;
+    for (const auto &file_freq : freq.files) {
+      updated_files.insert(updated.documents[file_freq.doc].file);
+    }
+    for (const auto &file_freq : pair.value.files) {
+      rebuilt_files.insert(rebuilt.documents[file_freq.doc].file);
+    }
+    EXPECT_EQ(updated_files.size(), rebuilt_files.size()) << pair.key;
+    EXPECT_EQ(updated_files.intersect(rebuilt_files).size(),
+              rebuilt_files.size())
+        << pair.key;
+  }
+
+  testing::internal::CaptureStdout();
+  {
+    Indexer indexer(temp_dir);
+    EXPECT_EQ(indexer.update_index_external(1, 2), IndexChange::None);
+  }
+  testing::internal::GetCapturedStdout();
+  for (const auto &entry : std::filesystem::directory_iterator(temp_dir)) {
+    EXPECT_EQ(entry.path().string().find(".run"), std::string::npos);
+  }
 
   std::filesystem::remove_all(temp_dir);
 }
@@ -0,0 +1,83 @@
+#include "levenshtein.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// INFO: Steps the automaton through text, returns the final state
+LevenshteinAutomaton::State run(const LevenshteinAutomaton &automaton,
+                                const std::string &text) {
+  LevenshteinAutomaton::State state = automaton.start();
+  for (char c : text) {
+    state = automaton.step(state, static_cast<unsigned char>(c));
+  }
+  return state;
+}
+
+size_t edit_distance(const std::string &a, const std::string &b) {
+  std::vector<std::vector<size_t>> d(a.size() + 1,
+                                     std::vector<size_t>(b.size() + 1));
+  for (size_t i = 0; i <= a.size(); i++) {
+    for (size_t j = 0; j <= b.size(); j++) {
+      d[i][j] = i == 0   ? j
+                : j == 0 ? i
+                         : std::min({d[i - 1][j - 1] + (a[i - 1] != b[j - 1]),
+                                     d[i - 1][j] + 1, d[i][j - 1] + 1});
+    }
+  }
+  return d[a.size()][b.size()];
+}
+
+} // namespace
+
+// TEST: GIVEN a query and a text WHEN the automaton consumes the text THEN
+// its distance is the edit distance, capped at max_edits + 1
+TEST(LevenshteinTest, DistanceMatchesDynamicProgramming) {
+  const std::vector<std::string> words = {"",      "a",      "ab",     "ba",
+                                          "abc",   "acb",    "holmes", "homles",
+                                          "holms", "hlomes", "watson", "wtson",
+                                          "moriarty", "moriarity"};
+  for (uint8_t edits = 0; edits <= LevenshteinAutomaton::MAX_EDITS; edits++) {
+    for (const std::string &query : words) {
+      LevenshteinAutomaton automaton(query, edits);
+      for (const std::string &text : words) {
+        size_t expected = std::min<size_t>(edit_distance(query, text),
+                                           edits + 1);
+        EXPECT_EQ(automaton.distance(run(automaton, text)), expected)
+            << query << " / " << text;
+      }
+    }
+  }
+}
+
+// TEST: GIVEN a consumed text WHEN asking for the lower bound THEN it never
+// exceeds the distance of any longer text with that start
+TEST(LevenshteinTest, LowerBoundHoldsForExtensions) {
+  LevenshteinAutomaton automaton("holmes", 2);
+  for (const std::string text : {"h", "ho", "hol", "hx", "hxx", "xxx"}) {
+    uint8_t bound = automaton.lower_bound(run(automaton, text));
+    for (const std::string rest : {"", "mes", "lmes", "olmes", "s", "zzz"}) {
+      EXPECT_LE(bound, automaton.distance(run(automaton, text + rest)))
+          << text << rest;
+    }
+  }
+  EXPECT_EQ(automaton.lower_bound(run(automaton, "xxx")), 3);
+}
+
+// TEST: GIVEN more than MAX_EDITS or a word longer than MAX_LENGTH WHEN
+// building the automaton THEN edits are clamped and the word is rejected
+TEST(LevenshteinTest, ClampsMaxEdits) {
+  EXPECT_EQ(LevenshteinAutomaton("word", 5).max_edits(),
+            LevenshteinAutomaton::MAX_EDITS);
+  std::string longest(LevenshteinAutomaton::MAX_LENGTH, 'a');
+  EXPECT_EQ(LevenshteinAutomaton(longest, 2).distance(
+                run(LevenshteinAutomaton(longest, 2), longest + "b")),
+            1);
+  EXPECT_THROW(LevenshteinAutomaton(longest + "a", 2), std::invalid_argument);
+  EXPECT_EQ(edits_for_length(2), 0);
+  EXPECT_EQ(edits_for_length(4), 1);
+  EXPECT_EQ(edits_for_length(9), 2);
+}
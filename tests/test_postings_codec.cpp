@@ -0,0 +1,136 @@
+#include "postings_codec.h"
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Postings {
+    std::vector<uint32_t> docs;
+    std::vector<uint32_t> counts;
+};
+
+Postings make_postings(size_t n, uint32_t max_gap, uint32_t max_count) {
+    std::mt19937 rng(static_cast<unsigned>(n));
+    std::uniform_int_distribution<uint32_t> gap(1, max_gap);
+    std::uniform_int_distribution<uint32_t> count(1, max_count);
+
+    Postings postings;
+    uint32_t doc = 0;
+    for (size_t i = 0; i < n; i++) {
+        doc += (i == 0) ? gap(rng) - 1 : gap(rng);
+        postings.docs.push_back(doc);
+        postings.counts.push_back(count(rng));
+    }
+    return postings;
+}
+
+Postings decode(const std::string &encoded) {
+    PostingsDecoder decoder(encoded.data(), encoded.size());
+    Postings postings;
+    uint32_t docs[POSTINGS_BLOCK_SIZE], counts[POSTINGS_BLOCK_SIZE];
+    for (size_t n = decoder.next(docs, counts); n > 0;
+         n = decoder.next(docs, counts)) {
+        postings.docs.insert(postings.docs.end(), docs, docs + n);
+        postings.counts.insert(postings.counts.end(), counts, counts + n);
+    }
+    EXPECT_EQ(decoder.size(), postings.docs.size());
+    EXPECT_EQ(decoder.consumed(), encoded.size());
+    return postings;
+}
+
+} // namespace
+
+// TEST: GIVEN postings around the block size WHEN encoded and decoded THEN
+// the same doc IDs and counts come back
+TEST(PostingsCodecTest, RoundTrip) {
+    for (size_t n : {0, 1, 127, 128, 129, 256, 1000}) {
+        Postings postings = make_postings(n, 50, 20);
+        std::string encoded;
+        encode_postings(postings.docs.data(), postings.counts.data(), n, encoded);
+
+        Postings decoded = decode(encoded);
+        EXPECT_EQ(decoded.docs, postings.docs) << "n = " << n;
+        EXPECT_EQ(decoded.counts, postings.counts) << "n = " << n;
+    }
+}
+
+// TEST: GIVEN gaps and counts needing all 32 bits WHEN round tripped THEN
+// nothing is truncated
+TEST(PostingsCodecTest, RoundTripWideValues) {
+    Postings postings;
+    for (uint32_t i = 0; i < 200; i++) {
+        postings.docs.push_back(i == 199 ? UINT32_MAX - 1 : i * 7);
+        postings.counts.push_back(i % 2 ? UINT32_MAX : 1);
+    }
+    std::string encoded;
+    encode_postings(postings.docs.data(), postings.counts.data(), 200, encoded);
+
+    Postings decoded = decode(encoded);
+    EXPECT_EQ(decoded.docs, postings.docs);
+    EXPECT_EQ(decoded.counts, postings.counts);
+}
+
+// TEST: GIVEN dense doc IDs with count 1 WHEN encoded THEN full blocks take
+// only their two width bytes plus one bit per gap
+TEST(PostingsCodecTest, DenseListsAreSmall) {
+    std::vector<uint32_t> docs(1024), counts(1024, 1);
+    for (uint32_t i = 0; i < 1024; i++) {
+        docs[i] = i;
+    }
+    std::string encoded;
+    encode_postings(docs.data(), counts.data(), docs.size(), encoded);
+
+    // INFO: Consecutive docs have gap 0, so both widths are 0
+    EXPECT_LE(encoded.size(), 2u + 8 * 2);
+}
+
+// TEST: GIVEN a truncated encoding WHEN decoded THEN it throws instead of
+// reading past the end
+TEST(PostingsCodecTest, TruncatedInputThrows) {
+    Postings postings = make_postings(300, 1000, 5);
+    std::string encoded;
+    encode_postings(postings.docs.data(), postings.counts.data(), 300, encoded);
+    encoded.resize(encoded.size() / 2);
+
+    PostingsDecoder decoder(encoded.data(), encoded.size());
+    uint32_t docs[POSTINGS_BLOCK_SIZE], counts[POSTINGS_BLOCK_SIZE];
+    EXPECT_THROW(
+        {
+            while (decoder.next(docs, counts) > 0) {
+            }
+        },
+        std::runtime_error);
+}
+
+// TEST: GIVEN postings naming docs past the document table WHEN decoded with
+// that table's size THEN it throws instead of handing out the bad IDs
+TEST(PostingsCodecTest, UnknownDocumentThrows) {
+    for (uint32_t n : {300u, 5u}) { // NOTE: Packed blocks and varint tail
+        Postings postings = make_postings(n, 1000, 5);
+        std::string encoded;
+        encode_postings(postings.docs.data(), postings.counts.data(), n,
+                        encoded);
+
+        uint32_t docs[POSTINGS_BLOCK_SIZE], counts[POSTINGS_BLOCK_SIZE];
+        PostingsDecoder decoder(encoded.data(), encoded.size(),
+                                postings.docs[n - 1]);
+        EXPECT_THROW(
+            {
+                while (decoder.next(docs, counts) > 0) {
+                }
+            },
+            std::runtime_error);
+
+        PostingsDecoder exact(encoded.data(), encoded.size(),
+                              postings.docs[n - 1] + 1);
+        size_t decoded = 0;
+        for (size_t k = exact.next(docs, counts); k > 0;
+             k = exact.next(docs, counts)) {
+            decoded += k;
+        }
+        EXPECT_EQ(decoded, n);
+    }
+}
@@ -0,0 +1,108 @@
+#include "flat_trie.h"
+#include "index_reader.h"
+#include "indexer.h"
+#include "query.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// NOTE: A directory of its own per test under the system temp directory, so
+// ctest -j can run the tests side by side
+static std::string test_dir() {
+  const ::testing::TestInfo *info =
+      ::testing::UnitTest::GetInstance()->current_test_info();
+  return (std::filesystem::temp_directory_path() /
+          (std::string(info->test_suite_name()) + "_" + info->name()))
+      .string();
+}
+
+// NOTE: Helper function to index a small directory and save it, along with
+// its autocomplete trie. "then" is one edit away from the stopword "the".
+static void build_index(const std::string &dir) {
+  std::filesystem::create_directory(dir);
+  std::ofstream(dir + "/a.txt") << "the watson baker";
+  std::ofstream(dir + "/b.txt") << "watson street";
+  std::ofstream(dir + "/c.txt") << "then lestrade";
+
+  Indexer indexer(dir);
+  indexer.index_directory();
+  indexer.serialize_index();
+}
+
+// INFO: File names of the matching docs, sorted
+static std::vector<std::string> matching_files(const IndexReader &reader,
+                                               const QueryResult &result) {
+  std::vector<std::string> files;
+  result.docs.for_each([&](uint32_t doc) {
+    files.push_back(
+        std::filesystem::path(reader.documents()[doc].file).filename().string());
+  });
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+// TEST: GIVEN a query led by a stopword WHEN evaluated with a vocabulary THEN
+// the stopword is skipped rather than replaced by a near word, and the rest of
+// the query decides the results
+TEST(QueryTest, StopwordIsNotFuzzyReplaced) {
+  std::string temp_dir = test_dir();
+  build_index(temp_dir);
+
+  IndexReader reader(temp_dir + "/clouseau.idx");
+  FlatTrie vocabulary(temp_dir + "/clouseau.ac");
+  std::ostringstream out;
+  QueryResult result =
+      evaluate_query(reader, &vocabulary, {"the", "watson"}, out);
+
+  EXPECT_EQ(matching_files(reader, result),
+            (std::vector<std::string>{"a.txt", "b.txt"}));
+  EXPECT_EQ(out.str(), "Word 'the' not found in the index.\n");
+  EXPECT_EQ(result.scored_terms.size(), 1u);
+
+  std::filesystem::remove_all(temp_dir);
+}
+
+// TEST: GIVEN a misspelled query word WHEN evaluated with a vocabulary THEN
+// its closest indexed word is searched instead
+TEST(QueryTest, MisspelledWordIsFuzzyReplaced) {
+  std::string temp_dir = test_dir();
+  build_index(temp_dir);
+
+  IndexReader reader(temp_dir + "/clouseau.idx");
+  FlatTrie vocabulary(temp_dir + "/clouseau.ac");
+  std::ostringstream out;
+  QueryResult result =
+      evaluate_query(reader, &vocabulary, {"lestrad", "or", "baker"}, out);
+
+  EXPECT_EQ(matching_files(reader, result),
+            (std::vector<std::string>{"a.txt", "c.txt"}));
+  EXPECT_EQ(out.str(), "Word 'lestrad' not found in the index, searching "
+                       "'lestrade' instead.\n");
+
+  std::filesystem::remove_all(temp_dir);
+}
+
+// TEST: GIVEN terms joined by "and" and "not" WHEN evaluated without a
+// vocabulary THEN the results are intersected and subtracted in order
+TEST(QueryTest, BooleanOperators) {
+  std::string temp_dir = test_dir();
+  build_index(temp_dir);
+
+  IndexReader reader(temp_dir + "/clouseau.idx");
+  std::ostringstream out;
+  QueryResult result = evaluate_query(
+      reader, nullptr, {"watson", "and", "street", "not", "baker"}, out);
+  EXPECT_EQ(matching_files(reader, result),
+            (std::vector<std::string>{"b.txt"}));
+
+  result = evaluate_query(reader, nullptr, {"watson", "not", "street"}, out);
+  EXPECT_EQ(matching_files(reader, result),
+            (std::vector<std::string>{"a.txt"}));
+  EXPECT_EQ(out.str(), "");
+
+  std::filesystem::remove_all(temp_dir);
+}
@@ -1,5 +1,10 @@
 #include "set.hpp"
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 // TEST: GIVEN an empty Set WHEN checking if it's empty THEN it should return true.
 TEST(SetTest, DefaultConstructor_IsEmpty) {
@@ -138,3 +143,145 @@ TEST(SetTest, Resize_HandlesLargerCapacity) {
     EXPECT_EQ(set.size(), 100);
     EXPECT_GE(set.capacity(), 100);
 }
+
+// TEST: GIVEN elements inserted out of order WHEN iterating THEN they come out
+// ascending and contains finds each of them
+TEST(SetTest, Iteration_IsSorted) {
+    Set<std::string> set = {"watson", "holmes", "lestrade", "holmes"};
+    set.insert("adler");
+    std::vector<std::string> expected = {"adler", "holmes", "lestrade",
+                                         "watson"};
+    std::vector<std::string> actual(set.begin(), set.end());
+    EXPECT_EQ(actual, expected);
+    EXPECT_TRUE(set.contains("lestrade"));
+    EXPECT_FALSE(set.contains("moriarty"));
+}
+
+// TEST: GIVEN sorted input with duplicates WHEN built with from_sorted THEN
+// the duplicates are dropped
+TEST(SetTest, FromSorted_DropsDuplicates) {
+    std::vector<int> sorted = {1, 1, 2, 5, 5, 5, 9};
+    Set<int> set = Set<int>::from_sorted(sorted.begin(), sorted.end());
+    EXPECT_EQ(set.size(), 4);
+    EXPECT_EQ(std::vector<int>(set.begin(), set.end()),
+              std::vector<int>({1, 2, 5, 9}));
+}
+
+// TEST: GIVEN ranges that append, overlap and arrive unsorted WHEN inserted
+// THEN the set holds their union in order
+TEST(SetTest, InsertRange_MergesOverlappingAndUnsorted) {
+    Set<int> set;
+    int first[] = {1, 3, 5};
+    int second[] = {7, 9};
+    int third[] = {8, 2, 3, 10, 2};
+    set.insert(first, first + 3);
+    set.insert(second, second + 2);
+    set.insert(third, third + 5);
+    EXPECT_EQ(std::vector<int>(set.begin(), set.end()),
+              std::vector<int>({1, 2, 3, 5, 7, 8, 9, 10}));
+}
+
+// TEST: GIVEN two sets WHEN computing union and difference THEN the results
+// hold the expected elements in order
+TEST(SetTest, UniteAndDifference) {
+    Set<int> set1 = {1, 2, 3, 6};
+    Set<int> set2 = {2, 4, 6, 8};
+    Set<int> both = set1.unite(set2);
+    EXPECT_EQ(std::vector<int>(both.begin(), both.end()),
+              std::vector<int>({1, 2, 3, 4, 6, 8}));
+    Set<int> only = set1.difference(set2);
+    EXPECT_EQ(std::vector<int>(only.begin(), only.end()),
+              std::vector<int>({1, 3}));
+    EXPECT_TRUE(set1.difference(set1).empty());
+}
+
+// TEST: GIVEN doc ID sets of similar and very different sizes WHEN
+// intersected THEN the merge and galloping paths match a brute force check
+TEST(SetTest, Intersect_MatchesBruteForce) {
+    std::mt19937 rng(42);
+    for (size_t large_size : {40u, 5000u}) {
+        std::vector<uint32_t> small_ids, large_ids;
+        for (size_t i = 0; i < large_size; i++) {
+            large_ids.push_back(rng() % (large_size * 2));
+        }
+        for (size_t i = 0; i < 37; i++) {
+            small_ids.push_back(rng() % (large_size * 2));
+        }
+        Set<uint32_t> small_set, large_set;
+        small_set.insert(small_ids.begin(), small_ids.end());
+        large_set.insert(large_ids.begin(), large_ids.end());
+
+        std::vector<uint32_t> expected;
+        for (uint32_t id : small_set) {
+            if (std::find(large_ids.begin(), large_ids.end(), id) !=
+                large_ids.end()) {
+                expected.push_back(id);
+            }
+        }
+        Set<uint32_t> forward = small_set.intersect(large_set);
+        Set<uint32_t> backward = large_set.intersect(small_set);
+        EXPECT_EQ(std::vector<uint32_t>(forward.begin(), forward.end()),
+                  expected);
+        EXPECT_EQ(std::vector<uint32_t>(backward.begin(), backward.end()),
+                  expected);
+    }
+}
+
+// NOTE: Copies throw once countdown reaches zero, and live instances are
+// counted
+struct ThrowingCopy {
+    static int alive;
+    static int countdown;
+    int value;
+    explicit ThrowingCopy(int v) : value(v) { alive++; }
+    ThrowingCopy(const ThrowingCopy &other) : value(other.value) {
+        if (countdown-- == 0) {
+            throw std::runtime_error("copy failed");
+        }
+        alive++;
+    }
+    ThrowingCopy(ThrowingCopy &&other) noexcept : value(other.value) {
+        alive++;
+    }
+    ThrowingCopy &operator=(const ThrowingCopy &) = default;
+    ThrowingCopy &operator=(ThrowingCopy &&) noexcept = default;
+    ~ThrowingCopy() { alive--; }
+    bool operator<(const ThrowingCopy &other) const {
+        return value < other.value;
+    }
+};
+int ThrowingCopy::alive = 0;
+int ThrowingCopy::countdown = -1;
+
+// TEST: GIVEN an element copy that throws partway WHEN copying or assigning a
+// set THEN nothing leaks and the assigned set keeps its old elements
+TEST(SetTest, ThrowingCopyLeavesTargetIntact) {
+    {
+        std::vector<ThrowingCopy> values;
+        for (int i = 0; i < 5; ++i) {
+            values.emplace_back(i);
+        }
+        Set<ThrowingCopy> source =
+            Set<ThrowingCopy>::from_sorted(values.begin(), values.end());
+        values.clear();
+        Set<ThrowingCopy> target;
+        target.insert(ThrowingCopy(42));
+        EXPECT_EQ(ThrowingCopy::alive, 6);
+
+        ThrowingCopy::countdown = 3;
+        EXPECT_THROW(Set<ThrowingCopy> copy(source), std::runtime_error);
+        EXPECT_EQ(ThrowingCopy::alive, 6);
+
+        ThrowingCopy::countdown = 3;
+        EXPECT_THROW(target = source, std::runtime_error);
+        EXPECT_EQ(ThrowingCopy::alive, 6);
+        ASSERT_EQ(target.size(), 1u);
+        EXPECT_EQ(target.begin()->value, 42);
+
+        ThrowingCopy::countdown = -1;
+        target = source;
+        EXPECT_EQ(target.size(), 5u);
+        EXPECT_TRUE(target.contains(ThrowingCopy(4)));
+    }
+    EXPECT_EQ(ThrowingCopy::alive, 0);
+}
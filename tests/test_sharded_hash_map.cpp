@@ -0,0 +1,99 @@
+#include "sharded_hashmap.hpp"
+#include <gtest/gtest.h>
+#include <string>
+
+// TEST: GIVEN a sharded map WHEN elements are inserted THEN they are found and
+// counted across shards
+TEST(ShardedHashMapTest, InsertAndFind) {
+    ShardedHashMap<std::string, int> map(8);
+    map.insert("one", 1);
+    map["two"] = 2;
+    map["three"] = 3;
+
+    EXPECT_EQ(map.size(), 3);
+    EXPECT_NE(map.find("two"), map.end());
+    EXPECT_EQ((*map.find("two")).value, 2);
+    EXPECT_EQ(map.find("four"), map.end());
+}
+
+// TEST: GIVEN a key WHEN shard_of is called THEN the key lives in that shard
+TEST(ShardedHashMapTest, KeyLivesInItsShard) {
+    ShardedHashMap<std::string, int> map(4);
+    map["watson"] = 1;
+
+    size_t s = map.shard_of("watson");
+    EXPECT_LT(s, map.shard_count());
+    EXPECT_NE(map.shard(s).find("watson"), map.shard(s).end());
+}
+
+// TEST: GIVEN two maps with the same shard count WHEN shard_of is called THEN
+// both agree, so per-thread maps can be merged shard by shard
+TEST(ShardedHashMapTest, ShardingIsStableAcrossMaps) {
+    ShardedHashMap<std::string, int> a(16);
+    ShardedHashMap<std::string, int> b(16);
+    for (std::string key : {"holmes", "watson", "moriarty", "lestrade"}) {
+        EXPECT_EQ(a.shard_of(key), b.shard_of(key));
+    }
+}
+
+// TEST: GIVEN 1000 keys spread over shards (some empty) WHEN iterating THEN
+// every key is visited exactly once
+TEST(ShardedHashMapTest, IteratesEveryShard) {
+    ShardedHashMap<std::string, int> map(64);
+    for (int i = 0; i < 1000; i++) {
+        map[std::to_string(i)] = i;
+    }
+
+    int count = 0;
+    long sum = 0;
+    for (auto &pair : map) {
+        count++;
+        sum += pair.value;
+    }
+    EXPECT_EQ(count, 1000);
+    EXPECT_EQ(sum, 999 * 1000 / 2);
+}
+
+// TEST: GIVEN a sharded map WHEN erasing and clearing THEN size follows
+TEST(ShardedHashMapTest, EraseAndClear) {
+    ShardedHashMap<std::string, int> map(4);
+    map["one"] = 1;
+    map["two"] = 2;
+
+    EXPECT_TRUE(map.erase("one"));
+    EXPECT_FALSE(map.erase("one"));
+    EXPECT_EQ(map.size(), 1);
+
+    map.clear();
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(map.begin(), map.end());
+}
+
+// NOTE: The string policy, counting how often it runs
+struct CountingHash {
+    static int calls;
+    uint64_t operator()(const std::string &key) const {
+        calls++;
+        return HashPolicy<std::string>{}(key);
+    }
+};
+int CountingHash::calls = 0;
+
+// TEST: GIVEN a custom hash policy WHEN keys are inserted, found and erased
+// THEN each operation hashes the key once, and shard counts round up to a
+// power of two
+TEST(ShardedHashMapTest, HashesEachKeyOnce) {
+    ShardedHashMap<std::string, int, CountingHash> map(6);
+    EXPECT_EQ(map.shard_count(), 8);
+
+    CountingHash::calls = 0;
+    map["holmes"] = 1;
+    map.insert("watson", 2);
+    map.try_emplace("moriarty", 3);
+    EXPECT_NE(map.find("watson"), map.end());
+    EXPECT_TRUE(map.erase("holmes"));
+    EXPECT_EQ(CountingHash::calls, 5);
+
+    size_t s = map.shard_of("moriarty");
+    EXPECT_NE(map.shard(s).find("moriarty"), map.shard(s).end());
+}
@@ -0,0 +1,165 @@
+#include "small_array_list.hpp"
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+// TEST: GIVEN a list with one inline slot WHEN one element is added THEN it
+// stays inline and the list is no larger than a pointer plus two counts
+TEST(SmallArrayListTest, FirstElementIsInline) {
+    struct Posting {
+        uint32_t doc;
+        int count;
+        double tf;
+    };
+    SmallArrayList<Posting, 1> list;
+    EXPECT_EQ(sizeof(list), 24u);
+    EXPECT_TRUE(list.empty());
+
+    list.push_back(Posting{7, 2, 0.5});
+    EXPECT_EQ(list.capacity(), 1u);
+    EXPECT_EQ(list[0].doc, 7u);
+    EXPECT_GE(reinterpret_cast<const char *>(&list[0]),
+              reinterpret_cast<const char *>(&list));
+    EXPECT_LT(reinterpret_cast<const char *>(&list[0]),
+              reinterpret_cast<const char *>(&list) + sizeof(list));
+}
+
+// TEST: GIVEN more elements than fit inline WHEN pushed THEN the list spills
+// to the heap and keeps every element in order
+TEST(SmallArrayListTest, SpillsToHeap) {
+    SmallArrayList<int, 2> list;
+    for (int i = 0; i < 100; i++) {
+        list.push_back(i);
+    }
+    EXPECT_EQ(list.size(), 100u);
+    EXPECT_GE(list.capacity(), 100u);
+    int expected = 0;
+    for (int value : list) {
+        EXPECT_EQ(value, expected++);
+    }
+    EXPECT_THROW(list.at(100), std::out_of_range);
+}
+
+// TEST: GIVEN inline and heap lists of strings WHEN copied and moved THEN the
+// copies are deep and the moved-from lists are empty
+TEST(SmallArrayListTest, CopyAndMove) {
+    SmallArrayList<std::string, 2> small = {"holmes"};
+    SmallArrayList<std::string, 2> large = {"a", "b", "c", "d"};
+
+    SmallArrayList<std::string, 2> small_copy = small;
+    small_copy[0] = "watson";
+    EXPECT_EQ(small[0], "holmes");
+
+    SmallArrayList<std::string, 2> large_copy;
+    large_copy = large;
+    EXPECT_EQ(large_copy.size(), 4u);
+    EXPECT_EQ(large_copy[3], "d");
+
+    SmallArrayList<std::string, 2> small_moved = std::move(small);
+    EXPECT_EQ(small_moved[0], "holmes");
+    EXPECT_TRUE(small.empty());
+
+    const std::string *heap = &large[0];
+    SmallArrayList<std::string, 2> large_moved;
+    large_moved = std::move(large);
+    EXPECT_EQ(&large_moved[0], heap); // NOTE: Heap buffer is taken over
+    EXPECT_TRUE(large.empty());
+    large.push_back("reused");
+    EXPECT_EQ(large[0], "reused");
+}
+
+// TEST: GIVEN pop_back, clear, reserve and emplace_back WHEN used THEN sizes
+// and contents follow
+TEST(SmallArrayListTest, PopClearReserveEmplace) {
+    SmallArrayList<std::string, 1> list;
+    list.reserve(10);
+    EXPECT_EQ(list.capacity(), 10u);
+    EXPECT_EQ(list.emplace_back(3, 'z'), "zzz");
+    list.push_back("baker");
+    list.pop_back();
+    EXPECT_EQ(list.size(), 1u);
+    list.clear();
+    EXPECT_TRUE(list.empty());
+
+    SmallArrayList<std::string, 1> grow = {"lestrade"};
+    grow.push_back(grow[0]); // NOTE: Forces a spill while reading element 0
+    EXPECT_EQ(grow[1], "lestrade");
+}
+
+// NOTE: Copies throw once countdown reaches zero, and live instances are
+// counted
+struct ThrowingCopy {
+    static int alive;
+    static int countdown;
+    int value;
+    explicit ThrowingCopy(int v) : value(v) { alive++; }
+    ThrowingCopy(const ThrowingCopy &other) : value(other.value) {
+        if (countdown-- == 0) {
+            throw std::runtime_error("copy failed");
+        }
+        alive++;
+    }
+    ThrowingCopy(ThrowingCopy &&other) noexcept : value(other.value) {
+        alive++;
+    }
+    ~ThrowingCopy() { alive--; }
+};
+int ThrowingCopy::alive = 0;
+int ThrowingCopy::countdown = -1;
+
+// TEST: GIVEN an element copy that throws partway WHEN copying or assigning a
+// spilled list THEN nothing leaks and the assigned list keeps its old
+// elements, inline or not
+TEST(SmallArrayListTest, ThrowingCopyLeavesTargetIntact) {
+    using List = SmallArrayList<ThrowingCopy, 2>;
+    {
+        List source;
+        for (int i = 0; i < 5; ++i) {
+            source.emplace_back(i);
+        }
+        List small_target;
+        small_target.emplace_back(42);
+        List large_target;
+        for (int i = 0; i < 3; ++i) {
+            large_target.emplace_back(100 + i);
+        }
+
+        ThrowingCopy::countdown = 3;
+        EXPECT_THROW(List copy(source), std::runtime_error);
+        EXPECT_EQ(ThrowingCopy::alive, 9);
+
+        ThrowingCopy::countdown = 3;
+        EXPECT_THROW(small_target = source, std::runtime_error);
+        EXPECT_EQ(ThrowingCopy::alive, 9);
+        ASSERT_EQ(small_target.size(), 1u);
+        EXPECT_EQ(small_target[0].value, 42);
+
+        ThrowingCopy::countdown = 1;
+        EXPECT_THROW(large_target = source, std::runtime_error);
+        EXPECT_EQ(ThrowingCopy::alive, 9);
+        ASSERT_EQ(large_target.size(), 3u);
+        EXPECT_EQ(large_target[2].value, 102);
+
+        ThrowingCopy::countdown = -1;
+        small_target = source;
+        EXPECT_EQ(small_target.size(), 5u);
+        EXPECT_EQ(small_target[4].value, 4);
+    }
+    EXPECT_EQ(ThrowingCopy::alive, 0);
+}
+
+// TEST: GIVEN an inline and a spilled list WHEN swapped THEN each holds the
+// other's elements
+TEST(SmallArrayListTest, SwapInlineAndHeap) {
+    SmallArrayList<std::string, 2> small = {"holmes"};
+    SmallArrayList<std::string, 2> large = {"a", "b", "c"};
+    small.swap(large);
+    ASSERT_EQ(small.size(), 3u);
+    EXPECT_EQ(small[2], "c");
+    ASSERT_EQ(large.size(), 1u);
+    EXPECT_EQ(large[0], "holmes");
+    EXPECT_EQ(large.capacity(), 2u);
+    small.swap(small);
+    EXPECT_EQ(small.size(), 3u);
+}
@@ -0,0 +1,164 @@
+#include "mapped_file.h"
+#include "tokenizer.h"
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+// NOTE: Helper to collect every emitted token
+std::vector<std::string> tokens_of(const std::string &text) {
+  std::vector<std::string> tokens;
+  tokenize(text.data(), text.size(),
+           [&](std::string_view token) { tokens.emplace_back(token); });
+  return tokens;
+}
+
+std::vector<std::string> tokens_of(TokenizerKernel kernel,
+                                   const std::string &text) {
+  std::vector<std::string> tokens;
+  tokenize(kernel, text.data(), text.size(),
+           [&](std::string_view token) { tokens.emplace_back(token); });
+  return tokens;
+}
+
+// NOTE: Byte-at-a-time reference of the word rules
+std::vector<std::string> reference_tokens(const std::string &text) {
+  std::vector<std::string> tokens;
+  std::string word;
+  for (size_t i = 0; i <= text.size(); i++) {
+    char c = i < text.size() ? text[i] : ' ';
+    if (is_word_char(c)) {
+      word += (c >= 'A' && c <= 'Z') ? static_cast<char>(c + 32) : c;
+    } else if (!word.empty()) {
+      if (is_valid_word(word)) {
+        tokens.push_back(word);
+      }
+      word.clear();
+    }
+  }
+  return tokens;
+}
+
+// TEST: GIVEN mixed case text WHEN tokenized THEN words are lowercased
+TEST(TokenizerTest, LowercasesWords) {
+  std::vector<std::string> tokens = tokens_of("Hello WORLD wOrD");
+  ASSERT_EQ(tokens.size(), 3);
+  EXPECT_EQ(tokens[0], "hello");
+  EXPECT_EQ(tokens[1], "world");
+  EXPECT_EQ(tokens[2], "word");
+}
+
+// TEST: GIVEN punctuation and digits WHEN tokenized THEN only word characters
+// are kept and punctuation splits words
+TEST(TokenizerTest, SplitsOnPunctuation) {
+  std::vector<std::string> tokens = tokens_of("one,two.three!4th\nfive\tsix");
+  std::vector<std::string> expected = {"one", "two", "three",
+                                       "4th", "five", "six"};
+  EXPECT_EQ(tokens, expected);
+}
+
+// TEST: GIVEN contractions and hyphenated words WHEN tokenized THEN valid ones
+// are kept and malformed ones are dropped
+TEST(TokenizerTest, HyphenAndApostropheRules) {
+  std::vector<std::string> tokens =
+      tokens_of("don't well-known 'quoted' trailing- --dash can''t x-y-z");
+  std::vector<std::string> expected = {"don't", "well-known", "x-y-z"};
+  EXPECT_EQ(tokens, expected);
+}
+
+// TEST: GIVEN text ending inside a word WHEN tokenized THEN the last word is
+// emitted and validated like any other
+TEST(TokenizerTest, LastWordAtEndOfSpan) {
+  EXPECT_EQ(tokens_of("first last"),
+            (std::vector<std::string>{"first", "last"}));
+  EXPECT_EQ(tokens_of("first last-"), (std::vector<std::string>{"first"}));
+}
+
+// TEST: GIVEN non-ASCII bytes WHEN tokenized THEN they act as word boundaries
+TEST(TokenizerTest, NonAsciiIsBoundary) {
+  std::vector<std::string> tokens = tokens_of("caf\xc3\xa9 na\xc3\xafve");
+  std::vector<std::string> expected = {"caf", "na", "ve"};
+  EXPECT_EQ(tokens, expected);
+}
+
+// TEST: GIVEN random text WHEN tokenized by every supported kernel THEN the
+// tokens match the scalar kernel exactly
+TEST(TokenizerTest, KernelsMatchScalar) {
+  const char alphabet[] = "abcXYZ09'- .,\n\x80\xff";
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<int> pick(0, sizeof(alphabet) - 2);
+
+  std::string text;
+  for (int i = 0; i < 20000; i++) {
+    text += alphabet[pick(rng)];
+  }
+
+  std::vector<std::string> expected = reference_tokens(text);
+  EXPECT_FALSE(expected.empty());
+  EXPECT_EQ(tokens_of(TokenizerKernel::Scalar, text), expected);
+
+  for (TokenizerKernel kernel :
+       {TokenizerKernel::SSE2, TokenizerKernel::AVX2}) {
+    if (!tokenizer_kernel_supported(kernel)) {
+      continue;
+    }
+    // Odd lengths so the scalar tail of the vector kernels is exercised
+    for (size_t length : {text.size(), size_t(4095), size_t(4097), size_t(63)}) {
+      std::string slice = text.substr(0, length);
+      EXPECT_EQ(tokens_of(kernel, slice),
+                tokens_of(TokenizerKernel::Scalar, slice))
+          << tokenizer_kernel_name(kernel) << " length " << length;
+    }
+  }
+}
+
+// TEST: GIVEN a word that straddles the internal block boundary WHEN
+// tokenized THEN it is emitted once and whole
+TEST(TokenizerTest, WordAcrossBlockBoundary) {
+  std::string text(4090, ' ');
+  text += "Boundary-Word rest";
+  std::vector<std::string> tokens = tokens_of(text);
+  std::vector<std::string> expected = {"boundary-word", "rest"};
+  EXPECT_EQ(tokens, expected);
+
+  std::string long_word(10000, 'q');
+  EXPECT_EQ(tokens_of(" " + long_word + " "),
+            std::vector<std::string>{long_word});
+}
+
+// TEST: GIVEN a file on disk WHEN mapped THEN its bytes are readable as a span
+TEST(MappedFileTest, MapsWholeFile) {
+  std::string path = "./mapped_file_test.txt";
+  {
+    std::ofstream file(path, std::ios::binary);
+    file << "mapped file contents";
+  }
+
+  MappedFile mapped(path);
+  EXPECT_EQ(std::string(mapped.data(), mapped.size()), "mapped file contents");
+
+  MappedFile moved = std::move(mapped);
+  EXPECT_EQ(moved.size(), 20);
+  EXPECT_TRUE(mapped.empty());
+
+  std::filesystem::remove(path);
+}
+
+// TEST: GIVEN an empty file WHEN mapped THEN the span is empty
+TEST(MappedFileTest, EmptyFile) {
+  std::string path = "./mapped_file_empty.txt";
+  { std::ofstream file(path, std::ios::binary); }
+
+  MappedFile mapped(path);
+  EXPECT_TRUE(mapped.empty());
+  EXPECT_TRUE(tokens_of(std::string(mapped.data(), mapped.size())).empty());
+
+  std::filesystem::remove(path);
+}
+
+// TEST: GIVEN a missing file WHEN mapped THEN it throws
+TEST(MappedFileTest, MissingFileThrows) {
+  EXPECT_THROW(MappedFile("./does_not_exist.txt"), std::runtime_error);
+}
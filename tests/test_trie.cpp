@@ -1,5 +1,8 @@
 #include "trie.hpp"
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <string>
+#include <vector>
 
 
 // TEST: GIVEN a Trie of 3 words 
@@ -81,3 +84,95 @@ TEST(TrieTest, SearchPrefix_Word) {
     EXPECT_EQ(results.size(), 1);
     EXPECT_EQ(results[0], "word");
 }
+
+// TEST: GIVEN words that share and split compressed edges
+//       WHEN searching prefixes ending inside and past an edge
+//       THEN the matching words come back in order
+TEST(TrieTest, SearchPrefix_InsideCompressedEdge) {
+    Trie trie;
+    trie.insert("holmesian");
+    trie.insert("holmes");
+    trie.insert("hold");
+
+    ArrayList<std::string> results = trie.search("holm");
+    ASSERT_EQ(results.size(), 2);
+    EXPECT_EQ(results[0], "holmes");
+    EXPECT_EQ(results[1], "holmesian");
+    EXPECT_EQ(trie.search("holmesi").size(), 1);
+    EXPECT_EQ(trie.search("holx").size(), 0);
+    EXPECT_EQ(trie.search("holmesians").size(), 0);
+    EXPECT_EQ(trie.search("ho").size(), 3);
+}
+
+// TEST: GIVEN a node with more children than fit its sorted array
+//       WHEN searching under it
+//       THEN every child is found in byte order
+TEST(TrieTest, SearchPrefix_DenseNode) {
+    Trie trie;
+    std::vector<std::string> words;
+    for (int c = 200; c >= 33; c--) {
+        words.push_back(std::string("x") + static_cast<char>(c) + "y");
+        trie.insert(words.back());
+    }
+    std::sort(words.begin(), words.end(), [](const std::string &a,
+                                             const std::string &b) {
+        return static_cast<unsigned char>(a[1]) <
+               static_cast<unsigned char>(b[1]);
+    });
+
+    ArrayList<std::string> results = trie.search("x");
+    ASSERT_EQ(results.size(), words.size());
+    for (size_t i = 0; i < words.size(); i++) {
+        EXPECT_EQ(results[i], words[i]);
+    }
+    EXPECT_EQ(trie.search(std::string("x") + static_cast<char>(120)).size(),
+              1);
+}
+
+// TEST: GIVEN scored words
+//       WHEN asking for the top k under a prefix
+//       THEN the k highest scores come back best first
+TEST(TrieTest, TopK_BestScoresFirst) {
+    Trie trie;
+    trie.insert("holmes", 90);
+    trie.insert("hold", 40);
+    trie.insert("holiday", 70);
+    trie.insert("home", 100); // NOTE: Outside the prefix
+    trie.insert("hole", 5);
+    trie.insert("holmesian", 80);
+
+    ArrayList<Completion> results = trie.top_k("hol", 3);
+    ASSERT_EQ(results.size(), 3);
+    EXPECT_EQ(results[0].word, "holmes");
+    EXPECT_EQ(results[0].score, 90u);
+    EXPECT_EQ(results[1].word, "holmesian");
+    EXPECT_EQ(results[2].word, "holiday");
+
+    EXPECT_EQ(trie.top_k("holm", 10).size(), 2);
+    EXPECT_EQ(trie.top_k("holmesi", 10)[0].word, "holmesian");
+    EXPECT_EQ(trie.top_k("hol", 0).size(), 0);
+    EXPECT_EQ(trie.top_k("x", 5).size(), 0);
+    EXPECT_EQ(trie.top_k("", 1)[0].word, "home");
+}
+
+// TEST: GIVEN many scored words
+//       WHEN asking for the top k
+//       THEN the result matches sorting every completion by score
+TEST(TrieTest, TopK_MatchesFullSort) {
+    Trie trie;
+    std::vector<std::pair<uint32_t, std::string>> scored;
+    for (int i = 0; i < 2000; i++) {
+        std::string word = "w" + std::to_string(i * 7919 % 2000);
+        uint32_t score = static_cast<uint32_t>(i * 104729 % 100003);
+        trie.insert(word, score);
+        scored.emplace_back(score, word);
+    }
+    std::sort(scored.rbegin(), scored.rend());
+
+    ArrayList<Completion> results = trie.top_k("w", 25);
+    ASSERT_EQ(results.size(), 25);
+    for (size_t i = 0; i < 25; i++) {
+        EXPECT_EQ(results[i].score, scored[i].first);
+        EXPECT_EQ(results[i].word, scored[i].second);
+    }
+}